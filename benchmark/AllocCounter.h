@@ -0,0 +1,49 @@
+#ifndef MINIKV_ALLOCCOUNTER_H
+#define MINIKV_ALLOCCOUNTER_H
+
+// Replaces the global operator new and delete with ones that count allocations, for benchmarks that report
+// allocations per operation. Include it in exactly one file of a benchmark.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace miniKV {
+
+inline std::atomic<uint64_t> allocations{0};
+
+/** @return number of allocations with operator new since the program started */
+inline uint64_t AllocationCount() { return allocations.load(std::memory_order_relaxed); }
+
+}  // namespace miniKV
+
+void *operator new(std::size_t size) {
+  miniKV::allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+  miniKV::allocations.fetch_add(1, std::memory_order_relaxed);
+  auto alignment = static_cast<std::size_t>(align);
+  if (void *ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+#endif  // MINIKV_ALLOCCOUNTER_H
@@ -0,0 +1,131 @@
+// Page latch throughput, ReaderWriterLatch against the mutex and condition variable latch it replaced,
+// copied here as MutexLatch. "uncontended" is one thread taking and releasing the latch, "contended"
+// is all threads on one latch, each holding it for a few loads of a shared array, with write_percent
+// of the acquisitions in write mode. Page latches are held that briefly in the B+ tree.
+//
+// Usage: Latch_bench [max_threads=16] [ops_per_thread=1000000] [write_percent=10]
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <random>
+
+#include "Base/ReaderWriterLatch.h"
+#include "BenchUtil.h"
+
+namespace miniKV {
+
+class MutexLatch {
+ public:
+  void WLock() {
+    std::unique_lock<std::mutex> latch(mutex_);
+    while (writer_entered_) {
+      reader_.wait(latch);
+    }
+    writer_entered_ = true;
+    while (reader_count_ > 0) {
+      writer_.wait(latch);
+    }
+  }
+
+  void WUnlock() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    writer_entered_ = false;
+    reader_.notify_all();
+  }
+
+  void RLock() {
+    std::unique_lock<std::mutex> latch(mutex_);
+    while (writer_entered_) {
+      reader_.wait(latch);
+    }
+    reader_count_++;
+  }
+
+  void RUnlock() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    reader_count_--;
+    if (writer_entered_ && reader_count_ == 0) {
+      writer_.notify_one();
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable writer_;
+  std::condition_variable reader_;
+  uint32_t reader_count_{0};
+  bool writer_entered_{false};
+};
+
+constexpr size_t SHARED_WORDS = 8;
+
+template <typename Latch>
+double Uncontended(size_t ops, bool write) {
+  Latch latch;
+  Timer timer;
+  for (size_t i = 0; i < ops; ++i) {
+    if (write) {
+      latch.WLock();
+      latch.WUnlock();
+    } else {
+      latch.RLock();
+      latch.RUnlock();
+    }
+  }
+  return ops / timer.Elapsed();
+}
+
+template <typename Latch>
+double Contended(size_t threads, size_t ops_per_thread, int write_percent) {
+  Latch latch;
+  volatile uint64_t shared[SHARED_WORDS] = {};
+  double seconds = RunParallel(threads, [&](size_t tid) {
+    std::mt19937 rng(tid);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < ops_per_thread; ++i) {
+      if (static_cast<int>(rng() % 100) < write_percent) {
+        latch.WLock();
+        for (auto &word : shared) {
+          word = word + 1;
+        }
+        latch.WUnlock();
+      } else {
+        latch.RLock();
+        for (auto &word : shared) {
+          sum += word;
+        }
+        latch.RUnlock();
+      }
+    }
+    if (sum == 1) {
+      std::printf("unlikely sum\n");
+    }
+  });
+  return threads * ops_per_thread / seconds;
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t max_threads = miniKV::GetArg(argc, argv, 1, 16);
+  size_t ops_per_thread = miniKV::GetArg(argc, argv, 2, 1000000);
+  int write_percent = static_cast<int>(miniKV::GetArg(argc, argv, 3, 10));
+
+  std::printf("uncontended, million latches/s\n");
+  std::printf("%-8s %14s %14s\n", "mode", "MutexLatch", "RWLatch");
+  for (bool write : {false, true}) {
+    std::printf("%-8s %14.1f %14.1f\n", write ? "write" : "read",
+                miniKV::Uncontended<miniKV::MutexLatch>(ops_per_thread * 10, write) / 1e6,
+                miniKV::Uncontended<ReaderWriterLatch>(ops_per_thread * 10, write) / 1e6);
+  }
+
+  std::printf("\ncontended, %d%% writes, million latches/s\n", write_percent);
+  std::printf("%-8s %14s %14s\n", "threads", "MutexLatch", "RWLatch");
+  for (size_t threads : miniKV::ThreadCounts(max_threads)) {
+    std::printf("%-8zu %14.1f %14.1f\n", threads,
+                miniKV::Contended<miniKV::MutexLatch>(threads, ops_per_thread, write_percent) / 1e6,
+                miniKV::Contended<ReaderWriterLatch>(threads, ops_per_thread, write_percent) / 1e6);
+  }
+  return 0;
+}
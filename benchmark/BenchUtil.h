@@ -0,0 +1,104 @@
+#ifndef MINIKV_BENCHUTIL_H
+#define MINIKV_BENCHUTIL_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace miniKV {
+
+class Timer {
+ public:
+  Timer() : start(std::chrono::steady_clock::now()) {}
+
+  /** @return seconds elapsed since construction */
+  double Elapsed() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * Run fn(thread_index) on num_threads threads.
+ * @return wall clock seconds until the last thread finished
+ */
+template <typename Fn>
+double RunParallel(size_t num_threads, Fn &&fn) {
+  std::vector<std::thread> threads;
+  Timer timer;
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back(fn, tid);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return timer.Elapsed();
+}
+
+/** @return 1, 2, 4, ... up to max_threads */
+inline std::vector<size_t> ThreadCounts(size_t max_threads) {
+  std::vector<size_t> counts;
+  for (size_t n = 1; n <= max_threads; n *= 2) {
+    counts.push_back(n);
+  }
+  return counts;
+}
+
+/**
+ * Zipfian distribution over [0, num_items), item 0 is the most popular.
+ * Uses the closed form of Gray et al., "Quickly Generating Billion-Record Synthetic Databases",
+ * like the YCSB generator, so construction is O(num_items) and sampling is O(1).
+ */
+class ZipfianGenerator {
+ public:
+  explicit ZipfianGenerator(size_t num_items, double theta = 0.99) : num_items(num_items), theta(theta) {
+    double zeta2 = Zeta(2);
+    zetan = Zeta(num_items);
+    alpha = 1.0 / (1.0 - theta);
+    eta = (1 - std::pow(2.0 / num_items, 1 - theta)) / (1 - zeta2 / zetan);
+  }
+
+  template <typename Rng>
+  size_t operator()(Rng &rng) {
+    double u = std::uniform_real_distribution<double>(0, 1)(rng);
+    double uz = u * zetan;
+    if (uz < 1) {
+      return 0;
+    }
+    if (uz < 1 + std::pow(0.5, theta)) {
+      return 1;
+    }
+    auto item = static_cast<size_t>(num_items * std::pow(eta * u - eta + 1, alpha));
+    return item < num_items ? item : num_items - 1;
+  }
+
+ private:
+  double Zeta(size_t n) const {
+    double sum = 0;
+    for (size_t i = 1; i <= n; ++i) {
+      sum += 1 / std::pow(static_cast<double>(i), theta);
+    }
+    return sum;
+  }
+
+  size_t num_items;
+  double theta;
+  double zetan;
+  double alpha;
+  double eta;
+};
+
+/** @return argv[index] parsed as a number, or default_value if absent */
+inline size_t GetArg(int argc, char **argv, int index, size_t default_value) {
+  return index < argc ? std::strtoull(argv[index], nullptr, 10) : default_value;
+}
+
+}  // namespace miniKV
+
+#endif  // MINIKV_BENCHUTIL_H
@@ -0,0 +1,101 @@
+// Loading a BPlusTree with num_keys keys: one Insert per key, in key order and in random order,
+// against BulkLoad from sorted input, which fills the leaves left to right and writes every page
+// once. MiniKV::import adds the external sort of an unsorted record file to the bulk load.
+//
+// Usage: BulkLoad_bench [num_keys=10000000] [pool_mb=256] [run_size=4194304]
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Core/MiniKV.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+/** @return size of the file in bytes */
+size_t FileSize(const char *path) {
+  struct stat stat_buf;
+  return stat(path, &stat_buf) == 0 ? static_cast<size_t>(stat_buf.st_size) : 0;
+}
+
+void Report(const char *name, size_t num_keys, double seconds, double baseline) {
+  std::printf("%-16s %10.2f %14.0f %10.1fx %10.1f\n", name, seconds, num_keys / seconds, baseline / seconds,
+              FileSize("bench.db") / 1048576.0);
+}
+
+/** @return seconds to load keys into a new tree and write it to disk */
+double RunTree(const std::vector<key_t> &keys, bool bulk, size_t pool_mb) {
+  remove("bench.db");
+  auto disk_manager = std::make_shared<DiskManager>("bench.db");
+  auto bpm = std::make_shared<BufferPoolManager>(pool_mb * 1024 * 1024 / PAGE_SIZE, disk_manager);
+  BPlusTree<key_t, value_t> tree(bpm);
+
+  Timer timer;
+  if (bulk) {
+    size_t i = 0;
+    tree.BulkLoad(keys.size(), [&](key_t *key, value_t *value) {
+      *key = keys[i];
+      *value = static_cast<value_t>(keys[i]);
+      i++;
+    });
+  } else {
+    for (auto key : keys) {
+      tree.Insert(key, static_cast<value_t>(key));
+    }
+  }
+  bpm->FlushAllPages();
+  return timer.Elapsed();
+}
+
+/** @return seconds to import keys from a record file into a new database, which is closed */
+double RunImport(const std::vector<key_t> &keys, size_t run_size) {
+  remove("bench.db");
+  FILE *file = fopen("bench.records", "wb");
+  for (auto key : keys) {
+    auto value = static_cast<value_t>(key);
+    fwrite(&key, sizeof(key), 1, file);
+    fwrite(&value, sizeof(value), 1, file);
+  }
+  fclose(file);
+
+  Timer timer;
+  {
+    MiniKV db("bench.db");
+    db.import("bench.records", run_size);
+  }
+  double seconds = timer.Elapsed();
+  remove("bench.records");
+  return seconds;
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t num_keys = miniKV::GetArg(argc, argv, 1, 10000000);
+  size_t pool_mb = miniKV::GetArg(argc, argv, 2, 256);
+  size_t run_size = miniKV::GetArg(argc, argv, 3, miniKV::EXTERNAL_SORT_RUN_SIZE);
+
+  std::vector<miniKV::key_t> sorted(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    sorted[i] = static_cast<miniKV::key_t>(i * 2);
+  }
+  auto shuffled = sorted;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937_64(0));
+
+  std::printf("%zu keys\n%-16s %10s %14s %11s %10s\n", num_keys, "method", "seconds", "keys/s", "speedup",
+              "file MB");
+  double baseline = miniKV::RunTree(shuffled, false, pool_mb);
+  miniKV::Report("insert random", num_keys, baseline, baseline);
+  miniKV::Report("insert sorted", num_keys, miniKV::RunTree(sorted, false, pool_mb), baseline);
+  miniKV::Report("BulkLoad", num_keys, miniKV::RunTree(sorted, true, pool_mb), baseline);
+  miniKV::Report("import", num_keys, miniKV::RunImport(shuffled, run_size), baseline);
+  remove("bench.db");
+  return 0;
+}
@@ -0,0 +1,68 @@
+// Concurrent BPlusTree inserts of random keys from 1 to max_threads writer threads, each run into an
+// empty tree. Inserts descend with read latches and write latch the leaf only, "restarts" is the share
+// of inserts that found the leaf full and descended again holding the structure latch shared to split it.
+// The tree fits in the buffer pool.
+//
+// Usage: ConcurrentInsert_bench [max_threads=32] [inserts_per_thread=200000]
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+void Run(size_t threads, size_t inserts_per_thread) {
+  remove("bench.db");
+  auto disk_manager = std::make_shared<DiskManager>("bench.db");
+  auto bpm = std::make_shared<BufferPoolManager>(1024, disk_manager);
+  BPlusTree<key_t, value_t> tree(bpm);
+
+  std::vector<std::vector<key_t>> keys(threads);
+  std::mt19937_64 rng(0);
+  for (auto &thread_keys : keys) {
+    for (size_t i = 0; i < inserts_per_thread; ++i) {
+      thread_keys.push_back(static_cast<key_t>(rng() >> 1));
+    }
+  }
+
+  std::atomic<size_t> inserted{0};
+  double seconds = RunParallel(threads, [&](size_t tid) {
+    size_t local_inserted = 0;
+    for (auto key : keys[tid]) {
+      local_inserted += tree.Insert(key, static_cast<value_t>(key));
+    }
+    inserted += local_inserted;
+  });
+
+  size_t found = 0;
+  for (auto &thread_keys : keys) {
+    for (size_t i = 0; i < thread_keys.size(); i += 97) {
+      value_t value;
+      found += tree.GetValue(thread_keys[i], value) && value == static_cast<value_t>(thread_keys[i]);
+    }
+  }
+  if (found != threads * ((inserts_per_thread + 96) / 97)) {
+    std::printf("lost keys: %zu of %zu found\n", found, threads * ((inserts_per_thread + 96) / 97));
+  }
+  double throughput = threads * inserts_per_thread / seconds;
+  std::printf("%-8zu %14.0f %20.0f %12.4f%%\n", threads, throughput, throughput / threads,
+              100.0 * tree.GetInsertRestarts() / inserted.load());
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t max_threads = miniKV::GetArg(argc, argv, 1, 32);
+  size_t inserts_per_thread = miniKV::GetArg(argc, argv, 2, 200000);
+  std::printf("%-8s %14s %20s %13s\n", "threads", "inserts/s", "inserts/s/thread", "restarts");
+  for (size_t threads : miniKV::ThreadCounts(max_threads)) {
+    miniKV::Run(threads, inserts_per_thread);
+  }
+  return 0;
+}
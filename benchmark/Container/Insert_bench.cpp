@@ -0,0 +1,58 @@
+// Single-threaded BPlusTree insert rate for increasing keys, such as time-series ids, and for random
+// keys, with the default page size. "pages" is the number of pages in the file, increasing keys fill
+// the leaves, random keys leave them partly full. The tree fits in the buffer pool.
+//
+// Usage: Insert_bench [num_keys=2000000]
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+void Run(const char *name, const std::vector<key_t> &keys) {
+  remove("bench.db");
+  auto disk_manager = std::make_shared<DiskManager>("bench.db");
+  auto bpm = std::make_shared<BufferPoolManager>(1024, disk_manager);
+  BPlusTree<key_t, value_t> tree(bpm);
+
+  Timer timer;
+  for (auto key : keys) {
+    tree.Insert(key, static_cast<value_t>(key));
+  }
+  double seconds = timer.Elapsed();
+
+  size_t found = 0;
+  for (size_t i = 0; i < keys.size(); i += 97) {
+    value_t value;
+    found += tree.GetValue(keys[i], value) && value == static_cast<value_t>(keys[i]);
+  }
+  if (found != (keys.size() + 96) / 97) {
+    std::printf("lost keys: %zu of %zu found\n", found, (keys.size() + 96) / 97);
+  }
+  std::printf("%-12s %14.0f %10d\n", name, keys.size() / seconds, disk_manager->GetNextPageId());
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t num_keys = miniKV::GetArg(argc, argv, 1, 2000000);
+  std::vector<miniKV::key_t> keys;
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(static_cast<miniKV::key_t>(i));
+  }
+  std::printf("%-12s %14s %10s\n", "keys", "inserts/s", "pages");
+  miniKV::Run("sequential", keys);
+  std::mt19937_64 rng(0);
+  for (auto &key : keys) {
+    key = static_cast<miniKV::key_t>(rng() >> 1);
+  }
+  miniKV::Run("random", keys);
+  return 0;
+}
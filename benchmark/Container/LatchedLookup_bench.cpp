@@ -0,0 +1,96 @@
+// Single-threaded BPlusTree operations that pin and latch pages, with the allocations they make.
+// "GetValue" is the optimistic lookup, which neither pins nor latches, for reference. "Seek" positions an
+// iterator at a key, a latched descent with read latches. "Insert+Remove" inserts a key and removes it
+// again, two latched descents that write latch the leaf. "Remove" then removes every key in random order,
+// a remove that leaves its leaf underfull latch-crabs from the root to merge or redistribute pages.
+// Pages are 4 KB, so descents go through several levels, and the tree fits in the buffer pool.
+//
+// Usage: LatchedLookup_bench [ops=1000000] [num_keys=1000000]
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+template <typename Op>
+void Measure(const char *name, const std::vector<key_t> &keys, Op &&op) {
+  size_t sum = 0;
+  uint64_t allocations_before = AllocationCount();
+  Timer timer;
+  for (auto key : keys) {
+    sum += op(key);
+  }
+  double seconds = timer.Elapsed();
+  uint64_t allocations_after = AllocationCount();
+  if (sum != keys.size()) {
+    std::printf("%s: %zu of %zu succeeded\n", name, sum, keys.size());
+  }
+  std::printf("%-16s %14.0f %12.2f\n", name, keys.size() / seconds,
+              static_cast<double>(allocations_after - allocations_before) / keys.size());
+}
+
+void Run(size_t ops, size_t num_keys) {
+  remove("bench.db");
+  DatabaseOptions options;
+  options.page_size = 4096;
+  auto disk_manager = std::make_shared<DiskManager>("bench.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(num_keys / 100 + 1024, disk_manager);
+  BPlusTree<key_t, value_t> tree(bpm);
+
+  std::vector<std::pair<key_t, value_t>> entries;
+  for (size_t i = 0; i < num_keys; ++i) {
+    entries.emplace_back(static_cast<key_t>(i * 2), static_cast<value_t>(i));
+  }
+  tree.BulkLoad(entries.begin(), entries.end());
+
+  std::mt19937_64 rng(0);
+  std::vector<key_t> keys;
+  for (size_t i = 0; i < ops; ++i) {
+    keys.push_back(static_cast<key_t>(rng() % num_keys * 2));
+  }
+
+  std::printf("%-16s %14s %12s\n", "operation", "ops/s", "allocs/op");
+  Measure("GetValue", keys, [&](key_t key) {
+    value_t value;
+    return tree.GetValue(key, value);
+  });
+  Measure("Seek", keys, [&](key_t key) {
+    auto it = tree.Begin(key);
+    return !it.IsEnd() && (*it).first == key;
+  });
+  Measure("Insert+Remove", keys, [&](key_t key) {
+    bool inserted = tree.Insert(key + 1, 0);
+    tree.Remove(key + 1);
+    return inserted;
+  });
+
+  std::vector<key_t> all_keys;
+  for (auto &entry : entries) {
+    all_keys.push_back(entry.first);
+  }
+  std::shuffle(all_keys.begin(), all_keys.end(), rng);
+  Measure("Remove", all_keys, [&](key_t key) {
+    tree.Remove(key);
+    return true;
+  });
+  value_t value;
+  if (!tree.IsEmpty() || tree.GetValue(all_keys[0], value)) {
+    std::printf("Remove: the tree is not empty\n");
+  }
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  miniKV::Run(miniKV::GetArg(argc, argv, 1, 1000000), miniKV::GetArg(argc, argv, 2, 1000000));
+  return 0;
+}
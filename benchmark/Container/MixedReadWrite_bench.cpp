@@ -0,0 +1,76 @@
+// Mixed BPlusTree workload from 1 to max_threads threads: each operation is a GetValue of a loaded key,
+// or, with probability write_percent, an Insert of a new random key. Inserts keep splitting leaves and
+// internal pages under the lookups. A split latches one page at a time, so lookups are not held up by the
+// ancestors of the page being split, and "move-rights" counts the descents that reached a page split since
+// its parent was read and followed its right link. The tree fits in the buffer pool.
+//
+// Usage: MixedReadWrite_bench [max_threads=32] [ops_per_thread=200000] [write_percent=20] [num_keys=200000]
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+void Run(size_t threads, size_t ops_per_thread, size_t write_percent, size_t num_keys) {
+  remove("bench.db");
+  auto disk_manager = std::make_shared<DiskManager>("bench.db");
+  auto bpm = std::make_shared<BufferPoolManager>(1024, disk_manager);
+  BPlusTree<key_t, value_t> tree(bpm);
+
+  // Loaded keys are even, inserted keys odd, so lookups of loaded keys always find them.
+  std::vector<key_t> keys;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(static_cast<key_t>(rng() >> 2) * 2);
+    tree.Insert(keys.back(), static_cast<value_t>(keys.back()));
+  }
+  uint64_t move_rights = tree.GetMoveRights();
+
+  std::atomic<size_t> found{0};
+  std::atomic<size_t> lookups{0};
+  double seconds = RunParallel(threads, [&](size_t tid) {
+    std::mt19937_64 rng(tid + 1);
+    std::uniform_int_distribution<size_t> dist(0, keys.size() - 1);
+    size_t local_found = 0;
+    size_t local_lookups = 0;
+    for (size_t i = 0; i < ops_per_thread; ++i) {
+      if (rng() % 100 < write_percent) {
+        key_t key = static_cast<key_t>(rng() >> 2) * 2 + 1;
+        tree.Insert(key, static_cast<value_t>(key));
+      } else {
+        value_t value;
+        local_found += tree.GetValue(keys[dist(rng)], value);
+        local_lookups++;
+      }
+    }
+    found += local_found;
+    lookups += local_lookups;
+  });
+  if (found != lookups) {
+    std::printf("lost keys: %zu of %zu found\n", found.load(), lookups.load());
+  }
+  double throughput = threads * ops_per_thread / seconds;
+  std::printf("%-8zu %14.0f %20.0f %14lu\n", threads, throughput, throughput / threads,
+              tree.GetMoveRights() - move_rights);
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t max_threads = miniKV::GetArg(argc, argv, 1, 32);
+  size_t ops_per_thread = miniKV::GetArg(argc, argv, 2, 200000);
+  size_t write_percent = miniKV::GetArg(argc, argv, 3, 20);
+  size_t num_keys = miniKV::GetArg(argc, argv, 4, 200000);
+  std::printf("%-8s %14s %20s %14s\n", "threads", "ops/s", "ops/s/thread", "move-rights");
+  for (size_t threads : miniKV::ThreadCounts(max_threads)) {
+    miniKV::Run(threads, ops_per_thread, write_percent, num_keys);
+  }
+  return 0;
+}
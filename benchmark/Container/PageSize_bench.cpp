@@ -0,0 +1,107 @@
+// Point lookups and full scans of a BPlusTree for page sizes from 4 KB to 256 KB.
+// Every database gets the same buffer pool memory, so small pages mean more frames and a deeper
+// tree, large pages mean fewer, wider nodes with longer in-page searches. Scans walk the leaf chain.
+// "pages" is the number of pages in the file, "height" the number of levels of the tree.
+//
+// Usage: PageSize_bench [num_keys=1000000] [lookups=1000000] [pool_mb=64]
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+using LeafPage = BPlusTreeLeafPage<key_t, value_t>;
+
+/** @return number of values found walking the leaf chain from leaf_id, every value is odd */
+size_t Scan(IBufferPoolManager *bpm, page_id_t leaf_id) {
+  size_t count = 0;
+  while (leaf_id != INVALID_PAGE_ID) {
+    auto page = bpm->FetchPage(leaf_id);
+    page->RLatch();
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    for (int i = 0; i < leaf->GetSize(); ++i) {
+      count += leaf->GetItem(i).second & 1;
+    }
+    page_id_t next_id = leaf->GetNextPageId();
+    page->RUnlatch();
+    bpm->UnpinPage(leaf_id, false);
+    leaf_id = next_id;
+  }
+  return count;
+}
+
+/** @return number of levels from leaf_id up to the root */
+int Height(IBufferPoolManager *bpm, page_id_t leaf_id) {
+  int height = 0;
+  for (page_id_t page_id = leaf_id; page_id != INVALID_PAGE_ID; ++height) {
+    auto page = bpm->FetchPage(page_id);
+    page_id_t parent_id = reinterpret_cast<BPlusTreePage *>(page->GetData())->GetParentPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = parent_id;
+  }
+  return height;
+}
+
+void Run(size_t page_size, size_t num_keys, size_t lookups, size_t pool_mb) {
+  remove("bench.db");
+  DatabaseOptions options;
+  options.page_size = page_size;
+  auto disk_manager = std::make_shared<DiskManager>("bench.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(pool_mb * 1024 * 1024 / page_size, disk_manager);
+  BPlusTree<key_t, value_t> tree(bpm);
+
+  std::vector<key_t> keys;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(rng() >> 1);
+    tree.Insert(keys.back(), static_cast<value_t>(keys.back() | 1));
+  }
+  size_t tree_pages = disk_manager->AllocatePage();
+
+  std::mt19937 lookup_rng(1);
+  std::uniform_int_distribution<size_t> dist(0, keys.size() - 1);
+  size_t found = 0;
+  Timer lookup_timer;
+  for (size_t i = 0; i < lookups; ++i) {
+    value_t value;
+    found += tree.GetValue(keys[dist(lookup_rng)], value);
+  }
+  double lookup_seconds = lookup_timer.Elapsed();
+
+  // The first root leaf stays the leftmost leaf, splits move the upper half to a new page.
+  const int scans = 5;
+  size_t scanned = 0;
+  Timer scan_timer;
+  for (int i = 0; i < scans; ++i) {
+    scanned += Scan(bpm.get(), 0);
+  }
+  double scan_seconds = scan_timer.Elapsed();
+
+  if (found != lookups || scanned != scans * num_keys) {
+    std::printf("lost keys: %zu of %zu found, %zu of %zu scanned\n", found, lookups, scanned, scans * num_keys);
+  }
+  std::printf("%-10zu %10d %10zu %10zu %8d %14.0f %14.0f\n", page_size / 1024, LeafPage::MaxSizeFor(page_size),
+              bpm->GetPoolSize(), tree_pages, Height(bpm.get(), 0), lookups / lookup_seconds,
+              scanned / scan_seconds);
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t num_keys = miniKV::GetArg(argc, argv, 1, 1000000);
+  size_t lookups = miniKV::GetArg(argc, argv, 2, 1000000);
+  size_t pool_mb = miniKV::GetArg(argc, argv, 3, 64);
+  std::printf("%-10s %10s %10s %10s %8s %14s %14s\n", "page KB", "leaf cap", "frames", "pages", "height",
+              "lookups/s", "scan keys/s");
+  for (size_t page_size = 4096; page_size <= 256 * 1024; page_size *= 2) {
+    miniKV::Run(page_size, num_keys, lookups, pool_mb);
+  }
+  return 0;
+}
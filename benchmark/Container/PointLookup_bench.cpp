@@ -0,0 +1,58 @@
+// Hot-set point lookups with BPlusTree::GetValue from 1 to max_threads reader threads.
+// The whole tree fits in the buffer pool, so lookups stay optimistic: they neither latch nor pin pages,
+// readers only read shared memory, and the numbers show how they scale with readers.
+//
+// Usage: PointLookup_bench [max_threads=32] [lookups_per_thread=200000] [num_keys=100000]
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+void Run(size_t max_threads, size_t lookups_per_thread, size_t num_keys) {
+  auto disk_manager = std::make_shared<DiskManager>("bench.db");
+  auto bpm = std::make_shared<BufferPoolManager>(256, disk_manager);
+  BPlusTree<key_t, value_t> tree(bpm);
+
+  std::vector<key_t> keys;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(rng());
+    tree.Insert(keys.back(), static_cast<value_t>(keys.back()));
+  }
+
+  std::printf("%-8s %16s %20s\n", "threads", "lookups/s", "lookups/s/thread");
+  for (size_t threads : ThreadCounts(max_threads)) {
+    std::atomic<size_t> found{0};
+    double seconds = RunParallel(threads, [&](size_t tid) {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<size_t> dist(0, keys.size() - 1);
+      size_t local_found = 0;
+      for (size_t i = 0; i < lookups_per_thread; ++i) {
+        value_t value;
+        local_found += tree.GetValue(keys[dist(rng)], value);
+      }
+      found += local_found;
+    });
+    if (found != threads * lookups_per_thread) {
+      std::printf("lost keys: %zu of %zu found\n", found.load(), threads * lookups_per_thread);
+    }
+    double throughput = threads * lookups_per_thread / seconds;
+    std::printf("%-8zu %16.0f %20.0f\n", threads, throughput, throughput / threads);
+  }
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  miniKV::Run(miniKV::GetArg(argc, argv, 1, 32), miniKV::GetArg(argc, argv, 2, 200000),
+              miniKV::GetArg(argc, argv, 3, 100000));
+  return 0;
+}
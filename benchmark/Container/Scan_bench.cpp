@@ -0,0 +1,82 @@
+// Range scan throughput of MiniKV::range in keys/s, from 1 to max_threads scanning threads.
+// Full scans read the whole database in parts of 4096 entries, short scans copy scan_length entries
+// from a random start key, so they pay for one descent per scan_length keys. The database fits in the
+// buffer pool.
+//
+// Usage: Scan_bench [max_threads=8] [num_keys=2000000] [scan_length=100]
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Core/MiniKV.h"
+
+namespace miniKV {
+
+/** @return number of entries in db, read in parts of buffer_size entries */
+size_t FullScan(MiniKV *db, size_t buffer_size) {
+  std::vector<std::pair<key_t, value_t>> buffer(buffer_size);
+  size_t total = 0;
+  for (key_t lo = 0;;) {
+    size_t count = db->range(lo, INT64_MAX, buffer.data(), buffer.size());
+    total += count;
+    if (count < buffer.size()) {
+      return total;
+    }
+    lo = buffer[count - 1].first + 1;
+  }
+}
+
+void Run(size_t max_threads, size_t num_keys, size_t scan_length) {
+  remove("bench.db");
+  FILE *file = fopen("bench.records", "wb");
+  for (size_t i = 0; i < num_keys; ++i) {
+    auto key = static_cast<key_t>(i * 2);
+    auto value = static_cast<value_t>(i);
+    fwrite(&key, sizeof(key), 1, file);
+    fwrite(&value, sizeof(value), 1, file);
+  }
+  fclose(file);
+  DatabaseOptions options;
+  options.buffer_pool_size = 1024;
+  MiniKV db("bench.db", options);
+  db.import("bench.records");
+  remove("bench.records");
+
+  std::printf("%-8s %18s %18s\n", "threads", "full scan keys/s", "short scan keys/s");
+  for (size_t threads : ThreadCounts(max_threads)) {
+    std::atomic<size_t> scanned{0};
+    double full_seconds = RunParallel(threads, [&](size_t) { scanned += FullScan(&db, 4096); });
+    if (scanned != threads * num_keys) {
+      std::printf("lost keys: %zu of %zu scanned\n", scanned.load(), threads * num_keys);
+    }
+    double full_throughput = scanned / full_seconds;
+
+    scanned = 0;
+    size_t scans_per_thread = 20000000 / scan_length / threads;
+    double short_seconds = RunParallel(threads, [&](size_t tid) {
+      std::mt19937_64 rng(tid);
+      std::uniform_int_distribution<key_t> dist(0, static_cast<key_t>((num_keys - scan_length) * 2));
+      std::vector<std::pair<key_t, value_t>> buffer(scan_length);
+      size_t count = 0;
+      for (size_t i = 0; i < scans_per_thread; ++i) {
+        count += db.range(dist(rng), INT64_MAX, buffer.data(), buffer.size());
+      }
+      scanned += count;
+    });
+    std::printf("%-8zu %18.0f %18.0f\n", threads, full_throughput, scanned / short_seconds);
+  }
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  miniKV::Run(miniKV::GetArg(argc, argv, 1, 8), miniKV::GetArg(argc, argv, 2, 2000000),
+              miniKV::GetArg(argc, argv, 3, 100));
+  return 0;
+}
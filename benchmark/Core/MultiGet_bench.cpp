@@ -0,0 +1,66 @@
+// Batched lookups, MiniKV::multi_get against a loop of MiniKV::get over the same batches, single-threaded.
+// Batches are uniformly random keys of a database of num_keys keys, all present, with the default page size
+// and the whole tree in the buffer pool.
+//
+// Usage: MultiGet_bench [lookups=2000000] [num_keys=1000000]
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Core/MiniKV.h"
+
+namespace miniKV {
+
+void Run(size_t lookups, size_t num_keys) {
+  remove("bench.db");
+  DatabaseOptions options;
+  options.buffer_pool_size = num_keys / 4000 + 64;
+  MiniKV db("bench.db", options);
+  std::vector<key_t> keys;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(static_cast<key_t>(rng() >> 1));
+    db.insert(keys.back(), static_cast<value_t>(keys.back()));
+  }
+
+  std::vector<key_t> batches;
+  for (size_t i = 0; i < lookups; ++i) {
+    batches.push_back(keys[rng() % keys.size()]);
+  }
+  std::vector<value_t> values(lookups);
+  std::vector<uint64_t> found((lookups + 63) / 64);
+
+  std::printf("%-8s %16s %16s %10s\n", "batch", "get keys/s", "multi_get keys/s", "speedup");
+  for (size_t batch : {1, 16, 256, 4096}) {
+    size_t count = lookups / batch * batch;
+    size_t hits = 0;
+    Timer timer;
+    for (size_t i = 0; i < count; ++i) {
+      values[i] = db.get(batches[i]);
+      hits += values[i] != -1;
+    }
+    double get_seconds = timer.Elapsed();
+
+    timer = Timer();
+    for (size_t i = 0; i < count; i += batch) {
+      hits += db.multi_get(&batches[i], batch, &values[i], &found[0]);
+    }
+    double multi_get_seconds = timer.Elapsed();
+
+    if (hits != 2 * count) {
+      std::printf("lost keys: %zu of %zu found\n", hits, 2 * count);
+    }
+    std::printf("%-8zu %16.0f %16.0f %9.2fx\n", batch, count / get_seconds, count / multi_get_seconds,
+                get_seconds / multi_get_seconds);
+  }
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  miniKV::Run(miniKV::GetArg(argc, argv, 1, 2000000), miniKV::GetArg(argc, argv, 2, 1000000));
+  return 0;
+}
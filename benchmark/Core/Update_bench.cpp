@@ -0,0 +1,88 @@
+// YCSB-A style workload: 50% get, 50% writes of existing keys, keys drawn from a Zipfian distribution, from
+// 1 to max_threads threads. Writes are done four ways: "remove+insert", the two descents update used to
+// need, "update" (one descent, the value set in place), "get+update", a counter increment read then
+// written back, which loses increments under concurrency, and "merge", the same increment as one
+// read-modify-write under the leaf latch. The database has the default page size and the whole tree in the
+// buffer pool.
+//
+// Usage: Update_bench [max_threads=4] [ops_per_thread=1000000] [num_keys=1000000]
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Core/MiniKV.h"
+
+namespace miniKV {
+
+enum class WriteKind { RemoveInsert, Update, GetUpdate, Merge };
+
+void Run(const char *name, WriteKind kind, size_t threads, size_t ops_per_thread, size_t num_keys) {
+  remove("bench.db");
+  DatabaseOptions options;
+  options.buffer_pool_size = num_keys / 4000 + 64;
+  MiniKV db("bench.db", options);
+  std::vector<key_t> keys;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(static_cast<key_t>(rng() >> 1));
+    db.insert(keys.back(), 0);
+  }
+
+  // The operations of every thread are drawn beforehand, a write is flagged by a negative index.
+  ZipfianGenerator zipf(num_keys);
+  std::vector<std::vector<int64_t>> operations(threads);
+  for (size_t tid = 0; tid < threads; ++tid) {
+    for (size_t i = 0; i < ops_per_thread; ++i) {
+      auto index = static_cast<int64_t>(zipf(rng));
+      operations[tid].push_back(rng() % 2 == 0 ? index : -index - 1);
+    }
+  }
+
+  auto increment = [](const value_t *count) { return count != nullptr ? *count + 1 : 1; };
+  double seconds = RunParallel(threads, [&](size_t tid) {
+    for (int64_t index : operations[tid]) {
+      if (index >= 0) {
+        db.get(keys[index]);
+        continue;
+      }
+      key_t key = keys[-index - 1];
+      switch (kind) {
+        case WriteKind::RemoveInsert:
+          db.remove(key);
+          db.insert(key, 1);
+          break;
+        case WriteKind::Update:
+          db.update(key, 1);
+          break;
+        case WriteKind::GetUpdate:
+          db.update(key, db.get(key) + 1);
+          break;
+        case WriteKind::Merge:
+          db.merge(key, increment);
+          break;
+      }
+    }
+  });
+  std::printf("%-16s %8zu %14.0f\n", name, threads, threads * ops_per_thread / seconds);
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t max_threads = miniKV::GetArg(argc, argv, 1, 4);
+  size_t ops_per_thread = miniKV::GetArg(argc, argv, 2, 1000000);
+  size_t num_keys = miniKV::GetArg(argc, argv, 3, 1000000);
+  std::printf("%-16s %8s %14s\n", "write", "threads", "ops/s");
+  for (auto [name, kind] : {std::pair{"remove+insert", miniKV::WriteKind::RemoveInsert},
+                            std::pair{"update", miniKV::WriteKind::Update},
+                            std::pair{"get+update", miniKV::WriteKind::GetUpdate},
+                            std::pair{"merge", miniKV::WriteKind::Merge}}) {
+    for (size_t threads : miniKV::ThreadCounts(max_threads)) {
+      miniKV::Run(name, kind, threads, ops_per_thread, num_keys);
+    }
+  }
+  return 0;
+}
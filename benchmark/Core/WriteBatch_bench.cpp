@@ -0,0 +1,65 @@
+// Ingest of random keys into an empty database, MiniKV::write with batches of batch_size puts against a
+// loop of MiniKV::insert, single-threaded. The database has the default page size and the whole tree in
+// the buffer pool, so the numbers are those of the tree, not of the disk.
+//
+// Usage: WriteBatch_bench [num_keys=2000000]
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Core/MiniKV.h"
+
+namespace miniKV {
+
+// Ingest keys into a new database, with insert if batch_size is 0.
+double Ingest(const std::vector<key_t> &keys, size_t batch_size) {
+  remove("bench.db");
+  DatabaseOptions options;
+  options.buffer_pool_size = keys.size() / 4000 + 64;
+  MiniKV db("bench.db", options);
+  WriteBatch<key_t, value_t> batch;
+  Timer timer;
+  for (auto key : keys) {
+    if (batch_size == 0) {
+      db.insert(key, static_cast<value_t>(key));
+      continue;
+    }
+    batch.Put(key, static_cast<value_t>(key));
+    if (batch.Size() == batch_size) {
+      db.write(batch);
+      batch.Clear();
+    }
+  }
+  db.write(batch);
+  double seconds = timer.Elapsed();
+  if (db.get(keys.back()) != static_cast<value_t>(keys.back())) {
+    std::printf("lost key %lld\n", static_cast<long long>(keys.back()));
+  }
+  remove("bench.db");
+  return keys.size() / seconds;
+}
+
+void Run(size_t num_keys) {
+  std::vector<key_t> keys;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(static_cast<key_t>(rng() >> 1));
+  }
+
+  double insert_throughput = Ingest(keys, 0);
+  std::printf("%-8s %14s %10s\n", "batch", "keys/s", "speedup");
+  std::printf("%-8s %14.0f %9.2fx\n", "insert", insert_throughput, 1.0);
+  for (size_t batch_size : {1, 16, 256, 4096}) {
+    double throughput = Ingest(keys, batch_size);
+    std::printf("%-8zu %14.0f %9.2fx\n", batch_size, throughput, throughput / insert_throughput);
+  }
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  miniKV::Run(miniKV::GetArg(argc, argv, 1, 2000000));
+  return 0;
+}
@@ -0,0 +1,101 @@
+// FetchPage throughput with a working set 10x the buffer pool, from 1 to max_threads threads,
+// for the synchronous BufferPoolManager and the async I/O mode on io_uring and on the thread
+// pool engine. In async mode the latch is not held during reads and write-backs, so hits and
+// misses of other threads proceed while a miss waits for the disk.
+// A write_percent share of the fetches dirties the page, so evictions also write back.
+//
+// Usage: AsyncIO_bench [pool_size=64] [fetches_per_thread=5000] [max_threads=16] [write_percent=10]
+//                      [evict_cache=0]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+struct Mode {
+  const char *name;
+  bool async_io;
+  bool use_io_uring;
+};
+
+void Run(const Mode &mode, size_t pool_size, size_t fetches_per_thread, size_t max_threads, size_t write_percent,
+         bool evict_cache) {
+  const std::string db_file = "bench.db";
+  const size_t working_set = pool_size * 10;
+  remove(db_file.c_str());
+  auto disk_manager = std::make_shared<DiskManager>(db_file, mode.use_io_uring);
+  auto bpm = std::make_shared<BufferPoolManager>(pool_size, disk_manager, ReplacerType::LRU, mode.async_io);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < working_set; ++i) {
+    auto page = bpm->NewPage();
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page->GetPageId());
+    page_ids.push_back(page->GetPageId());
+    bpm->UnpinPage(page->GetPageId(), true);
+  }
+  bpm->FlushAllPages();
+
+  for (size_t threads : ThreadCounts(max_threads)) {
+    if (evict_cache) {
+      int fd = open(db_file.c_str(), O_RDONLY);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+    std::atomic<size_t> failed{0};
+    double seconds = RunParallel(threads, [&](size_t tid) {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<size_t> dist(0, working_set - 1);
+      for (size_t i = 0; i < fetches_per_thread; ++i) {
+        page_id_t page_id = page_ids[dist(rng)];
+        auto page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          failed++;
+          continue;
+        }
+        bool dirty = rng() % 100 < write_percent;
+        if (dirty) {
+          page->WLatch();
+          page->GetData()[PAGE_SIZE - 1]++;
+          page->WUnlatch();
+        }
+        bpm->UnpinPage(page_id, dirty);
+      }
+    });
+    std::printf("%-22s %2zu threads %10.0f fetches/s", mode.name, threads, threads * fetches_per_thread / seconds);
+    if (failed > 0) {
+      std::printf("  (%zu fetches found every frame pinned)", failed.load());
+    }
+    std::printf("\n");
+  }
+  remove(db_file.c_str());
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  using namespace miniKV;
+  size_t pool_size = GetArg(argc, argv, 1, 64);
+  size_t fetches_per_thread = GetArg(argc, argv, 2, 5000);
+  size_t max_threads = GetArg(argc, argv, 3, 16);
+  size_t write_percent = GetArg(argc, argv, 4, 10);
+  bool evict_cache = GetArg(argc, argv, 5, 0) != 0;
+
+  const Mode modes[] = {
+      {"sync", false, false},
+      {"async io_uring", true, true},
+      {"async thread pool", true, false},
+  };
+  for (const auto &mode : modes) {
+    Run(mode, pool_size, fetches_per_thread, max_threads, write_percent, evict_cache);
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+// Scaling of a single BufferPoolManager vs. a ParallelBufferPoolManager from 1 to max_threads threads.
+//
+// fetch/unpin: every thread fetches and unpins random pages of a working set that fits in the pool,
+//              so the buffer pool latch is the only shared resource.
+// tree insert: every thread inserts random keys into one BPlusTree (the shape of CoreTest.Concurrent_Insert_Test).
+//
+// Usage: BufferPoolManager_bench [max_threads=32] [ops_per_thread=200000] [num_instances=16]
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+#include "Storage/BufferPool/ParallelBufferPoolManager.h"
+
+namespace miniKV {
+
+static const size_t POOL_SIZE = 256;
+
+std::shared_ptr<IBufferPoolManager> MakePool(size_t num_instances, std::shared_ptr<DiskManager> disk_manager) {
+  if (num_instances == 1) {
+    return std::make_shared<BufferPoolManager>(POOL_SIZE, disk_manager);
+  }
+  return std::make_shared<ParallelBufferPoolManager>(num_instances, POOL_SIZE / num_instances, disk_manager);
+}
+
+double FetchUnpinThroughput(size_t num_instances, size_t num_threads, size_t ops_per_thread) {
+  auto disk_manager = std::make_shared<DiskManager>("bench.db");
+  auto bpm = MakePool(num_instances, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < POOL_SIZE; ++i) {
+    auto page = bpm->NewPage();
+    page_ids.push_back(page->GetPageId());
+    bpm->UnpinPage(page->GetPageId(), true);
+  }
+
+  double seconds = RunParallel(num_threads, [&](size_t tid) {
+    std::mt19937 rng(tid);
+    std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+    for (size_t i = 0; i < ops_per_thread; ++i) {
+      page_id_t page_id = page_ids[dist(rng)];
+      if (bpm->FetchPage(page_id) != nullptr) {
+        bpm->UnpinPage(page_id, false);
+      }
+    }
+  });
+
+  remove("bench.db");
+  return num_threads * ops_per_thread / seconds;
+}
+
+double TreeInsertThroughput(size_t num_instances, size_t num_threads, size_t keys_per_thread) {
+  auto disk_manager = std::make_shared<DiskManager>("bench.db");
+  auto tree = std::make_shared<BPlusTree<key_t, value_t>>(MakePool(num_instances, disk_manager));
+
+  double seconds = RunParallel(num_threads, [&](size_t tid) {
+    std::mt19937_64 rng(tid);
+    std::uniform_int_distribution<key_t> dist;
+    Transaction transaction(tid);
+    for (size_t i = 0; i < keys_per_thread; ++i) {
+      key_t key = dist(rng);
+      tree->Insert(key, key & 0xFFFFFFFF, &transaction);
+    }
+  });
+
+  remove("bench.db");
+  return num_threads * keys_per_thread / seconds;
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  using namespace miniKV;  // NOLINT
+  size_t max_threads = GetArg(argc, argv, 1, 32);
+  size_t ops_per_thread = GetArg(argc, argv, 2, 200000);
+  size_t num_instances = GetArg(argc, argv, 3, 16);
+
+  std::printf("%-8s %22s %22s %22s %22s\n", "threads", "fetch/unpin 1x (op/s)",
+              ("fetch/unpin " + std::to_string(num_instances) + "x (op/s)").c_str(), "tree insert 1x (op/s)",
+              ("tree insert " + std::to_string(num_instances) + "x (op/s)").c_str());
+  for (size_t threads : ThreadCounts(max_threads)) {
+    std::printf("%-8zu %22.0f %22.0f %22.0f %22.0f\n", threads, FetchUnpinThroughput(1, threads, ops_per_thread),
+                FetchUnpinThroughput(num_instances, threads, ops_per_thread),
+                TreeInsertThroughput(1, threads, ops_per_thread / 10),
+                TreeInsertThroughput(num_instances, threads, ops_per_thread / 10));
+  }
+  return 0;
+}
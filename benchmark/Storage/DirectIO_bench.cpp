@@ -0,0 +1,108 @@
+// Buffered vs O_DIRECT page I/O under a buffer pool, with a dataset larger than RAM by default.
+// For each mode it runs random FetchPage calls over the whole file and reports throughput,
+// the process resident set and how much the kernel page cache grew. Buffered I/O caches every
+// page a second time in the page cache, O_DIRECT only in the buffer pool frames.
+//
+// Usage: DirectIO_bench [dataset_mb=1.25 x MemTotal] [pool_mb=256] [fetches_per_thread=20000] [threads=8]
+//                       [huge_pages=0]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+/** @return a field of /proc/meminfo in MiB */
+size_t MemInfoMB(const std::string &field) {
+  std::ifstream meminfo("/proc/meminfo");
+  std::string name;
+  size_t kb;
+  std::string unit;
+  while (meminfo >> name >> kb >> unit) {
+    if (name == field + ":") {
+      return kb / 1024;
+    }
+  }
+  return 0;
+}
+
+/** @return resident set size of this process in MiB */
+size_t ResidentMB() {
+  std::ifstream statm("/proc/self/statm");
+  size_t pages;
+  size_t resident;
+  statm >> pages >> resident;
+  return resident * sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+void Run(bool direct_io, const std::string &db_file, page_id_t num_pages, size_t pool_size, size_t fetches_per_thread,
+         size_t threads, bool huge_pages) {
+  int fd = open(db_file.c_str(), O_RDONLY);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+
+  size_t cached_before = MemInfoMB("Cached");
+  auto disk_manager = std::make_shared<DiskManager>(db_file, true, direct_io);
+  BufferPoolManager bpm(pool_size, disk_manager, ReplacerType::LRU, false, huge_pages);
+
+  double seconds = RunParallel(threads, [&](size_t tid) {
+    std::mt19937 rng(tid);
+    std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+    for (size_t i = 0; i < fetches_per_thread; ++i) {
+      page_id_t page_id = dist(rng);
+      auto page = bpm.FetchPage(page_id);
+      if (page != nullptr) {
+        bpm.UnpinPage(page_id, false);
+      }
+    }
+  });
+
+  std::printf("%-9s %10.0f fetches/s  rss %6zu MB  page cache +%6zd MB  huge pages %s\n",
+              disk_manager->IsDirectIO() ? "O_DIRECT" : "buffered", threads * fetches_per_thread / seconds,
+              ResidentMB(), static_cast<ssize_t>(MemInfoMB("Cached")) - static_cast<ssize_t>(cached_before),
+              bpm.GetFrameRegion().IsHugeTLB() ? "hugetlb" : (huge_pages ? "transparent" : "no"));
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  using namespace miniKV;
+  size_t dataset_mb = GetArg(argc, argv, 1, MemInfoMB("MemTotal") * 5 / 4);
+  size_t pool_mb = GetArg(argc, argv, 2, 256);
+  size_t fetches_per_thread = GetArg(argc, argv, 3, 20000);
+  size_t threads = GetArg(argc, argv, 4, 8);
+  bool huge_pages = GetArg(argc, argv, 5, 0) != 0;
+  const std::string db_file = "bench.db";
+
+  auto num_pages = static_cast<page_id_t>((dataset_mb << 20) / PAGE_SIZE);
+  size_t pool_size = (pool_mb << 20) / PAGE_SIZE;
+  std::printf("dataset %zu MB (%d pages), pool %zu MB (%zu frames), RAM %zu MB\n", dataset_mb, num_pages, pool_mb,
+              pool_size, MemInfoMB("MemTotal"));
+
+  {
+    remove(db_file.c_str());
+    DiskManager disk_manager(db_file, true, true);
+    std::unique_ptr<char, decltype(&std::free)> page(
+        static_cast<char *>(std::aligned_alloc(DiskManager::IO_ALIGNMENT, PAGE_SIZE)), &std::free);
+    memset(page.get(), 0, PAGE_SIZE);
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      snprintf(page.get(), PAGE_SIZE, "page %d", page_id);
+      disk_manager.WritePage(page_id, page.get());
+    }
+    disk_manager.Sync();
+  }
+
+  Run(false, db_file, num_pages, pool_size, fetches_per_thread, threads, huge_pages);
+  Run(true, db_file, num_pages, pool_size, fetches_per_thread, threads, huge_pages);
+  remove(db_file.c_str());
+  return 0;
+}
@@ -0,0 +1,100 @@
+// Random page read IOPS of DiskManager (pread) against the previous std::fstream implementation,
+// which seeks and reads one shared stream under a mutex, from 1 to max_threads threads.
+// With evict_cache=1 the file is dropped from the page cache (posix_fadvise) before each run,
+// so reads go to the device instead of measuring only the syscall path.
+//
+// Usage: DiskManager_bench [file_pages=4096] [reads_per_thread=2000] [max_threads=16] [evict_cache=0]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Storage/Disk/DiskManager.h"
+
+namespace miniKV {
+
+/** The DiskManager read path before positional I/O, kept here as the baseline. */
+class FstreamDiskManager {
+ public:
+  explicit FstreamDiskManager(const std::string &db_file) {
+    db_io.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  }
+
+  void ReadPage(page_id_t page_id, char *page_data) {
+    std::lock_guard<std::mutex> guard{db_io_latch};
+    db_io.seekp(static_cast<size_t>(page_id) * PAGE_SIZE);
+    db_io.read(page_data, PAGE_SIZE);
+    int read_count = db_io.gcount();
+    if (read_count < PAGE_SIZE) {
+      db_io.clear();
+      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    }
+  }
+
+ private:
+  std::fstream db_io;
+  std::mutex db_io_latch;
+};
+
+void EvictCache(const std::string &db_file) {
+  int fd = open(db_file.c_str(), O_RDONLY);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+template <typename Manager>
+void BenchReads(const char *name, Manager *manager, const std::string &db_file, size_t file_pages,
+                size_t reads_per_thread, size_t max_threads, bool evict_cache) {
+  for (size_t threads : ThreadCounts(max_threads)) {
+    if (evict_cache) {
+      EvictCache(db_file);
+    }
+    double seconds = RunParallel(threads, [&](size_t tid) {
+      std::unique_ptr<char[]> buffer(new char[PAGE_SIZE]);
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, file_pages - 1);
+      for (size_t i = 0; i < reads_per_thread; ++i) {
+        manager->ReadPage(dist(rng), buffer.get());
+      }
+    });
+    std::printf("%-8s %2zu threads %12.0f reads/s %10.1f MB/s\n", name, threads, threads * reads_per_thread / seconds,
+                threads * reads_per_thread * static_cast<double>(PAGE_SIZE) / seconds / (1 << 20));
+  }
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  using namespace miniKV;
+  size_t file_pages = GetArg(argc, argv, 1, 4096);
+  size_t reads_per_thread = GetArg(argc, argv, 2, 2000);
+  size_t max_threads = GetArg(argc, argv, 3, 16);
+  bool evict_cache = GetArg(argc, argv, 4, 0) != 0;
+  const std::string db_file = "bench.db";
+
+  {
+    DiskManager disk_manager(db_file);
+    std::vector<char> page(PAGE_SIZE);
+    for (size_t page_id = 0; page_id < file_pages; ++page_id) {
+      snprintf(page.data(), PAGE_SIZE, "page %zu", page_id);
+      disk_manager.WritePage(page_id, page.data());
+    }
+    disk_manager.Sync();
+  }
+
+  FstreamDiskManager fstream_manager(db_file);
+  BenchReads("fstream", &fstream_manager, db_file, file_pages, reads_per_thread, max_threads, evict_cache);
+  DiskManager disk_manager(db_file);
+  BenchReads("pread", &disk_manager, db_file, file_pages, reads_per_thread, max_threads, evict_cache);
+  remove(db_file.c_str());
+  return 0;
+}
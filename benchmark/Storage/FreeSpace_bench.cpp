@@ -0,0 +1,101 @@
+// File size and allocation throughput of a BPlusTree under sustained insert/delete churn.
+// Every round inserts a batch of random keys and removes the batch inserted window rounds before,
+// so the live data stays constant. Merges free pages, which later splits reuse, and Sync() truncates
+// free pages at the end of the file. Without page reuse the file grows with every round.
+// The second part measures DiskManager::AllocatePage/DeallocatePage pairs on a populated free set.
+//
+// Usage: FreeSpace_bench [keys_per_round=50000] [rounds=20] [window=4] [page_kb=4]
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Container/BPlusTree.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+
+namespace miniKV {
+
+/** @return size of the file in bytes */
+size_t FileSize(const char *path) {
+  struct stat stat_buf;
+  return stat(path, &stat_buf) == 0 ? static_cast<size_t>(stat_buf.st_size) : 0;
+}
+
+void RunChurn(size_t keys_per_round, size_t rounds, size_t window, size_t page_kb) {
+  remove("bench.db");
+  DatabaseOptions options;
+  options.page_size = page_kb * 1024;
+  auto disk_manager = std::make_shared<DiskManager>("bench.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(1024, disk_manager);
+  BPlusTree<key_t, value_t> tree(bpm);
+
+  std::printf("%-8s %12s %12s %12s %14s\n", "round", "file MB", "pages", "free pages", "ops/s");
+  std::mt19937_64 rng(0);
+  std::deque<std::vector<key_t>> batches;
+  for (size_t round = 0; round < rounds; ++round) {
+    Timer timer;
+    size_t ops = 0;
+    batches.emplace_back();
+    for (size_t i = 0; i < keys_per_round; ++i) {
+      auto key = static_cast<key_t>(rng() >> 1);
+      batches.back().push_back(key);
+      tree.Insert(key, static_cast<value_t>(key));
+      ops++;
+    }
+    if (batches.size() > window) {
+      for (auto key : batches.front()) {
+        tree.Remove(key);
+        ops++;
+      }
+      batches.pop_front();
+    }
+    double seconds = timer.Elapsed();
+    bpm->FlushAllPages();
+    disk_manager->Sync();
+    std::printf("%-8zu %12.1f %12d %12zu %14.0f\n", round, FileSize("bench.db") / 1048576.0,
+                disk_manager->GetNextPageId(), disk_manager->GetFreePageCount(), ops / seconds);
+  }
+  remove("bench.db");
+}
+
+void RunAllocator(size_t free_pages, size_t pairs) {
+  remove("bench.db");
+  DiskManager disk_manager("bench.db");
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < free_pages * 2; ++i) {
+    page_ids.push_back(disk_manager.AllocatePage());
+  }
+  // Free every other page, so the free set is fragmented.
+  for (size_t i = 1; i < page_ids.size(); i += 2) {
+    disk_manager.DeallocatePage(page_ids[i]);
+  }
+
+  Timer timer;
+  for (size_t i = 0; i < pairs; ++i) {
+    disk_manager.DeallocatePage(disk_manager.AllocatePage());
+  }
+  double seconds = timer.Elapsed();
+  std::printf("%-12zu %16.0f\n", free_pages, pairs / seconds);
+  remove("bench.db");
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t keys_per_round = miniKV::GetArg(argc, argv, 1, 50000);
+  size_t rounds = miniKV::GetArg(argc, argv, 2, 20);
+  size_t window = miniKV::GetArg(argc, argv, 3, 4);
+  size_t page_kb = miniKV::GetArg(argc, argv, 4, 4);
+  miniKV::RunChurn(keys_per_round, rounds, window, page_kb);
+
+  std::printf("\n%-12s %16s\n", "free pages", "alloc+free/s");
+  for (size_t free_pages : {16, 1024, 65536}) {
+    miniKV::RunAllocator(free_pages, 1000000);
+  }
+  return 0;
+}
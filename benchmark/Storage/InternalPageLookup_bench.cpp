@@ -0,0 +1,92 @@
+// BPlusTreeInternalPage::Lookup across page fanouts, against the search methods it can use.
+// "linear" is the scan Lookup used to do, "upper_bound" is std::upper_bound, "branch-free" is
+// CountNotGreaterScalar and "simd" is CountNotGreater with the kernel picked for this CPU. Lookup adds
+// the page call around CountNotGreater. Keys are random, so the branches of the linear scan and of
+// upper_bound are unpredictable. The largest fanout is that of the default 160 KB page.
+//
+// Usage: InternalPageLookup_bench [lookups=2000000]
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Storage/Page/BPlusTreeInternalPage.h"
+#include "Util/KeySearch.h"
+
+namespace miniKV {
+
+using InternalPage = BPlusTreeInternalPage<key_t, value_t>;
+
+size_t Linear(const std::vector<key_t> &keys, key_t key) {
+  for (size_t i = 1; i < keys.size(); i++) {
+    if (key < keys[i]) {
+      return i - 1;
+    }
+  }
+  return keys.size() - 1;
+}
+
+size_t UpperBound(const std::vector<key_t> &keys, key_t key) {
+  return std::upper_bound(keys.begin() + 1, keys.end(), key) - keys.begin() - 1;
+}
+
+/** @return lookups per second of search over keys */
+template <typename Search>
+double Measure(const std::vector<key_t> &keys, Search &&search) {
+  size_t sum = 0;
+  Timer timer;
+  for (auto key : keys) {
+    sum += search(key);
+  }
+  double seconds = timer.Elapsed();
+  if (sum == 0) {
+    std::printf("no child found\n");
+  }
+  return keys.size() / seconds;
+}
+
+void Run(int fanout, size_t lookups) {
+  std::unique_ptr<char[]> data(new char[INTERNAL_PAGE_HEADER_SIZE + (sizeof(key_t) + sizeof(value_t)) * (fanout + 1)]);
+  auto *page = reinterpret_cast<InternalPage *>(data.get());
+  page->Init(1, INVALID_PAGE_ID, fanout);
+  std::vector<key_t> separators;
+  for (int i = 0; i < fanout; ++i) {
+    page->AppendChild(i * 16, i + 1);
+    separators.push_back(i * 16);
+  }
+
+  std::mt19937_64 rng(fanout);
+  std::vector<key_t> keys;
+  for (size_t i = 0; i < lookups; ++i) {
+    keys.push_back(static_cast<key_t>(rng() % (fanout * 16)));
+  }
+  // The linear scan takes a long time on wide pages, give it fewer lookups.
+  std::vector<key_t> linear_keys(keys.begin(), keys.begin() + std::min<size_t>(lookups, 20000000 / fanout + 1000));
+
+  double linear = Measure(linear_keys, [&](key_t key) { return Linear(separators, key); });
+  double upper_bound = Measure(keys, [&](key_t key) { return UpperBound(separators, key); });
+  double branch_free = Measure(keys, [&](key_t key) {
+    return CountNotGreaterScalar(separators.data() + 1, separators.size() - 1, key);
+  });
+  double simd = Measure(keys, [&](key_t key) {
+    return CountNotGreater(separators.data() + 1, separators.size() - 1, key);
+  });
+  double lookup = Measure(keys, [&](key_t key) { return page->Lookup(key); });
+  std::printf("%-8d %14.1f %14.1f %14.1f %14.1f %14.1f\n", fanout, linear / 1e6, upper_bound / 1e6, branch_free / 1e6,
+              simd / 1e6, lookup / 1e6);
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  size_t lookups = miniKV::GetArg(argc, argv, 1, 2000000);
+  std::printf("kernel: %s, million lookups/s\n", miniKV::KeySearchKernel());
+  std::printf("%-8s %14s %14s %14s %14s %14s\n", "fanout", "linear", "upper_bound", "branch-free", "simd", "Lookup");
+  for (int fanout : {16, 64, 256, 1024, 4096, miniKV::InternalPage::MaxSizeFor(miniKV::PAGE_SIZE)}) {
+    miniKV::Run(fanout, lookups);
+  }
+  return 0;
+}
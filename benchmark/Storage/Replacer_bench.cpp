@@ -0,0 +1,190 @@
+// Compares LRUReplacer, ClockReplacer and LRUKReplacer.
+// 1. Cost of Pin/Unpin and Victim calls, single threaded and with concurrent callers.
+// 2. Hit ratio of a buffer pool of pool_size frames replaying page traces, driven through
+//    the replacer the same way BufferPoolManager drives it:
+//    - a zipfian trace over num_pages pages,
+//    - a B+ tree trace over num_pages leaves with fanout 128, where root-to-leaf point lookups
+//      are interleaved with a full leaf scan every scan_interval lookups.
+//
+// Usage: Replacer_bench [pool_size=1024] [num_pages=16384] [trace_length=2000000] [max_threads=8]
+//                       [scan_interval=20000]
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Storage/BufferPool/ClockReplacer.h"
+#include "Storage/BufferPool/LRUKReplacer.h"
+#include "Storage/BufferPool/LRUReplaceer.h"
+
+namespace miniKV {
+
+std::unique_ptr<IReplacer> MakeReplacer(ReplacerType type, size_t pool_size) {
+  switch (type) {
+    case ReplacerType::Clock:
+      return std::make_unique<ClockReplacer>(pool_size);
+    case ReplacerType::LRUK:
+      return std::make_unique<LRUKReplacer>(pool_size);
+    case ReplacerType::LRU:
+    default:
+      return std::make_unique<LRUReplacer>(pool_size);
+  }
+}
+
+const char *Name(ReplacerType type) {
+  switch (type) {
+    case ReplacerType::Clock:
+      return "clock";
+    case ReplacerType::LRUK:
+      return "lru-k";
+    case ReplacerType::LRU:
+    default:
+      return "lru";
+  }
+}
+
+const ReplacerType ALL_TYPES[] = {ReplacerType::LRU, ReplacerType::Clock, ReplacerType::LRUK};
+
+void BenchOps(ReplacerType type, size_t pool_size, size_t num_ops, size_t max_threads) {
+  auto replacer = MakeReplacer(type, pool_size);
+  for (size_t frame = 0; frame < pool_size; ++frame) {
+    replacer->Unpin(frame);
+  }
+
+  for (size_t threads : ThreadCounts(max_threads)) {
+    double seconds = RunParallel(threads, [&](size_t tid) {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<frame_id_t> dist(0, pool_size - 1);
+      for (size_t i = 0; i < num_ops / threads; ++i) {
+        frame_id_t frame = dist(rng);
+        replacer->Pin(frame);
+        replacer->RecordAccess(frame);
+        replacer->Unpin(frame);
+      }
+    });
+    std::printf("%-6s pin+unpin  %2zu threads %10.1f ns/pair %12.0f pairs/s\n", Name(type), threads,
+                seconds * 1e9 / (num_ops / threads), num_ops / seconds);
+  }
+
+  // Victim until empty, then refill, so every Victim call finds a frame.
+  Timer timer;
+  size_t victims = 0;
+  while (victims < num_ops) {
+    frame_id_t frame;
+    while (replacer->Victim(&frame)) {
+      ++victims;
+    }
+    for (frame = 0; frame < static_cast<frame_id_t>(pool_size); ++frame) {
+      replacer->Unpin(frame);
+    }
+  }
+  std::printf("%-6s victim+unpin          %10.1f ns/frame\n", Name(type), timer.Elapsed() * 1e9 / victims);
+}
+
+/**
+ * Replay a page trace, page ids below num_hot_pages are reported separately.
+ */
+void BenchHitRatio(ReplacerType type, size_t pool_size, const std::vector<page_id_t> &trace,
+                   page_id_t num_hot_pages = 0) {
+  auto replacer = MakeReplacer(type, pool_size);
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frame_to_page(pool_size, INVALID_PAGE_ID);
+  frame_id_t next_free = 0;
+  size_t hits = 0;
+  size_t hot_accesses = 0;
+  size_t hot_hits = 0;
+
+  Timer timer;
+  for (page_id_t page_id : trace) {
+    frame_id_t frame;
+    auto iter = page_table.find(page_id);
+    if (iter != page_table.end()) {
+      frame = iter->second;
+      ++hits;
+      hot_hits += page_id < num_hot_pages;
+    } else {
+      if (next_free < static_cast<frame_id_t>(pool_size)) {
+        frame = next_free++;
+      } else {
+        replacer->Victim(&frame);
+        page_table.erase(frame_to_page[frame]);
+      }
+      page_table[page_id] = frame;
+      frame_to_page[frame] = page_id;
+    }
+    hot_accesses += page_id < num_hot_pages;
+    replacer->Pin(frame);
+    replacer->RecordAccess(frame);
+    replacer->Unpin(frame);
+  }
+  std::printf("%-6s hit ratio %.4f over %zu accesses (%.2f s)", Name(type), static_cast<double>(hits) / trace.size(),
+              trace.size(), timer.Elapsed());
+  if (hot_accesses > 0) {
+    std::printf(", internal pages %.4f", static_cast<double>(hot_hits) / hot_accesses);
+  }
+  std::printf("\n");
+}
+
+/**
+ * Trace of a B+ tree with a root (page 0), internal pages 1..num_leaves / fanout and leaves after them.
+ * Every lookup reads the root, one internal page and one leaf, every scan_interval lookups
+ * all leaves are read in order.
+ */
+std::vector<page_id_t> TreeTrace(size_t num_leaves, size_t fanout, size_t trace_length, size_t scan_interval,
+                                 page_id_t *num_internal_pages) {
+  auto num_internal = static_cast<page_id_t>((num_leaves + fanout - 1) / fanout);
+  *num_internal_pages = num_internal + 1;
+  std::mt19937_64 rng(0);
+  std::uniform_int_distribution<size_t> leaf_dist(0, num_leaves - 1);
+  std::vector<page_id_t> trace;
+  size_t lookups = 0;
+  while (trace.size() < trace_length) {
+    size_t leaf = leaf_dist(rng);
+    trace.push_back(0);
+    trace.push_back(static_cast<page_id_t>(1 + leaf / fanout));
+    trace.push_back(static_cast<page_id_t>(1 + num_internal + leaf));
+    if (++lookups % scan_interval == 0) {
+      for (size_t i = 0; i < num_leaves; ++i) {
+        trace.push_back(static_cast<page_id_t>(1 + num_internal + i));
+      }
+    }
+  }
+  return trace;
+}
+
+}  // namespace miniKV
+
+int main(int argc, char **argv) {
+  using namespace miniKV;
+  size_t pool_size = GetArg(argc, argv, 1, 1024);
+  size_t num_pages = GetArg(argc, argv, 2, 16384);
+  size_t trace_length = GetArg(argc, argv, 3, 2000000);
+  size_t max_threads = GetArg(argc, argv, 4, 8);
+  size_t scan_interval = GetArg(argc, argv, 5, 20000);
+
+  for (auto type : ALL_TYPES) {
+    BenchOps(type, pool_size, trace_length, max_threads);
+  }
+
+  ZipfianGenerator zipf(num_pages);
+  std::mt19937_64 rng(0);
+  std::vector<page_id_t> trace;
+  for (size_t i = 0; i < trace_length; ++i) {
+    trace.push_back(static_cast<page_id_t>(zipf(rng)));
+  }
+  std::printf("zipfian trace\n");
+  for (auto type : ALL_TYPES) {
+    BenchHitRatio(type, pool_size, trace);
+  }
+
+  page_id_t num_internal_pages;
+  trace = TreeTrace(num_pages, 128, trace_length, scan_interval, &num_internal_pages);
+  std::printf("point lookups with a full scan every %zu lookups\n", scan_interval);
+  for (auto type : ALL_TYPES) {
+    BenchHitRatio(type, pool_size, trace, num_internal_pages);
+  }
+  return 0;
+}
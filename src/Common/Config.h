@@ -20,13 +20,28 @@ using values = std::vector<value_t>;
 
 using txn_id_t = int32_t;  // transaction id type
 
-static constexpr int INVALID_PAGE_ID = -1;    // invalid page id
-static constexpr int INVALID_TXN_ID = -1;     // invalid transaction id
-static constexpr int INVALID_LSN = -1;        // invalid log sequence number
-static constexpr int HEADER_PAGE_ID = 0;      // the header page id
-static constexpr int PAGE_SIZE = 16384 * 10;  // size of a data page in byte, 16 KB
-static constexpr int BUFFER_POOL_SIZE = 40;   // size of buffer pool
-static constexpr int BUCKET_SIZE = 50;        // size of extendible hash bucket
+static constexpr int INVALID_PAGE_ID = -1;       // invalid page id
+static constexpr int INVALID_TXN_ID = -1;        // invalid transaction id
+static constexpr int INVALID_LSN = -1;           // invalid log sequence number
+static constexpr int HEADER_PAGE_ID = 0;         // the header page id
+static constexpr int PAGE_SIZE = 16384 * 10;     // default size of a data page in byte, 160 KB
+static constexpr int BUFFER_POOL_SIZE = 40;      // default size of buffer pool, in pages
+static constexpr int BUFFER_POOL_INSTANCES = 4;  // number of buffer pool shards, each has BUFFER_POOL_SIZE / N pages
+static constexpr int BUCKET_SIZE = 50;           // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;        // number of past references LRUKReplacer ranks frames by
+static constexpr int LRUK_CRP = 4;               // LRUKReplacer correlated reference period, in accesses
+static constexpr int ASYNC_IO_QUEUE_DEPTH = 64;  // requests in flight of the io_uring engine
+static constexpr int ASYNC_IO_THREADS = 4;       // threads of the fallback I/O engine
+static constexpr int ASYNC_IO_RETRIES = 100;     // io_uring submissions retried after EAGAIN or EBUSY, 1 ms apart
+static constexpr int CLEANER_PERCENT = 25;       // share of unpinned frames the page cleaner keeps clean
+static constexpr int CLEANER_BATCH = 32;         // max pages the page cleaner writes per round
+static constexpr int CLEANER_PERIOD_MS = 10;     // page cleaner wake-up period
+
+static constexpr double BULK_LOAD_FILL_FACTOR = 0.9;               // share of a node BPlusTree::BulkLoad fills
+static constexpr size_t EXTERNAL_SORT_RUN_SIZE = 4 * 1024 * 1024;  // records ExternalSorter sorts in memory
+static constexpr int OPTIMISTIC_READ_ATTEMPTS = 8;                 // optimistic descents of a lookup before it latches
+static constexpr int MAX_TREE_HEIGHT = 32;                         // levels of a BPlusTree a LatchContext can hold
+static constexpr int MULTI_GET_GROUP = 64;                         // keys BPlusTree::MultiGet searches in lockstep
 
 };  // namespace miniKV
 
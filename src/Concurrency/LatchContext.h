@@ -0,0 +1,89 @@
+#ifndef MINIKV_LATCHCONTEXT_H
+#define MINIKV_LATCHCONTEXT_H
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+#include "Common/Config.h"
+#include "Common/Macros.h"
+#include "Storage/BufferPool/PageGuard.h"
+
+namespace miniKV {
+
+/**
+ * Pages latched by one tree operation that crabs down holding several latches, and pages it frees, for
+ * the operation to release once it is done. It is a small object on the stack of the operation, with
+ * room for MAX_TREE_HEIGHT pages of each kind, so unlike a Transaction it allocates nothing.
+ */
+class LatchContext {
+ public:
+  LatchContext() = default;
+  ~LatchContext() { ReleasePages(); }
+  DISALLOW_COPY_AND_MOVE(LatchContext);
+
+  /**
+   * Hold a latched page, below the pages already held.
+   * @throw std::runtime_error if the context holds MAX_TREE_HEIGHT pages
+   */
+  void AddPage(WritePageGuard &&page) {
+    if (page_count == pages.size()) {
+      throw std::runtime_error("LatchContext: the tree is higher than MAX_TREE_HEIGHT");
+    }
+    pages[page_count++] = std::move(page);
+  }
+
+  /** @return true if no page is held */
+  bool IsEmpty() const { return page_count == 0; }
+
+  /** @return the highest page held, the context must not be empty */
+  const WritePageGuard &FrontPage() const { return pages[0]; }
+
+  /**
+   * @return the page held right above page_id, its parent in a latch-crabbing descent, nullptr if page_id
+   * is not held or is the highest page held
+   */
+  WritePageGuard *PageAbove(page_id_t page_id) {
+    for (size_t i = 1; i < page_count; ++i) {
+      if (pages[i].PageId() == page_id) {
+        return &pages[i - 1];
+      }
+    }
+    return nullptr;
+  }
+
+  /** Unlatch and unpin the pages held, top-down. */
+  void ReleasePages() {
+    for (size_t i = 0; i < page_count; ++i) {
+      pages[i].Drop();
+    }
+    page_count = 0;
+  }
+
+  /**
+   * Record a page to delete once the pages held are released, a pinned page cannot be deleted.
+   * @throw std::runtime_error if the context recorded 2 * MAX_TREE_HEIGHT pages
+   */
+  void AddDeletedPage(page_id_t page_id) {
+    if (deleted_count == deleted_pages.size()) {
+      throw std::runtime_error("LatchContext: the tree is higher than MAX_TREE_HEIGHT");
+    }
+    deleted_pages[deleted_count++] = page_id;
+  }
+
+  size_t GetDeletedPageCount() const { return deleted_count; }
+  page_id_t GetDeletedPage(size_t index) const { return deleted_pages[index]; }
+  void ClearDeletedPages() { deleted_count = 0; }
+
+ private:
+  std::array<WritePageGuard, MAX_TREE_HEIGHT> pages;
+  size_t page_count = 0;
+  // A merge frees one page per level, and the old root when the tree shrinks.
+  std::array<page_id_t, 2 * MAX_TREE_HEIGHT> deleted_pages{};
+  size_t deleted_count = 0;
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_LATCHCONTEXT_H
@@ -24,9 +24,10 @@
 #include <memory>
 #include <thread>  // NOLINT
 #include <unordered_set>
+#include <utility>
 
 #include "Common/Config.h"
-#include "Storage/Page/Page.h"
+#include "Storage/BufferPool/PageGuard.h"
 
 namespace miniKV {
 
@@ -41,7 +42,6 @@ enum class WType { INSERT = 0, DELETE, UPDATE };
 class Transaction {
  public:
   explicit Transaction(txn_id_t txn_id) : thread_id_(std::this_thread::get_id()), txn_id_(txn_id) {
-    page_set_ = std::make_shared<std::deque<std::shared_ptr<Page>>>();
     deleted_page_set_ = std::make_shared<std::unordered_set<page_id_t>>();
   }
 
@@ -55,14 +55,14 @@ class Transaction {
   /** @return the id of this transaction */
   inline txn_id_t GetTransactionId() const { return txn_id_; }
 
-  /** @return the page set */
-  inline std::shared_ptr<std::deque<std::shared_ptr<Page>>> GetPageSet() { return page_set_; }
+  /** @return the page set, released by clearing it */
+  inline std::deque<WritePageGuard> *GetPageSet() { return &page_set_; }
 
   /**
    * Adds a page into the page set.
-   * @param page page to be added
+   * @param page pinned and write latched page to be added
    */
-  inline void AddIntoPageSet(std::shared_ptr<Page> page) { page_set_->push_back(page); }
+  inline void AddIntoPageSet(WritePageGuard &&page) { page_set_.push_back(std::move(page)); }
 
   /** @return the deleted page set */
   inline std::shared_ptr<std::unordered_set<page_id_t>> GetDeletedPageSet() { return deleted_page_set_; }
@@ -80,7 +80,7 @@ class Transaction {
   txn_id_t txn_id_;
 
   /** Concurrent index: the pages that were latched during index operation. */
-  std::shared_ptr<std::deque<std::shared_ptr<Page>>> page_set_;
+  std::deque<WritePageGuard> page_set_;
   /** Concurrent index: the page IDs that were deleted during index operation.*/
   std::shared_ptr<std::unordered_set<page_id_t>> deleted_page_set_;
 };
@@ -4,19 +4,98 @@
 
 #include "Container/BPlusTree.h"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 #include "Storage/Page/Page.h"
 
 namespace miniKV {
+
+namespace {
+
+// Set or clear bit index of the found bitmap of MultiGet.
+inline void SetFound(uint64_t *found, size_t index, bool hit) {
+  uint64_t bit = uint64_t{1} << (index % 64);
+  found[index / 64] = hit ? found[index / 64] | bit : found[index / 64] & ~bit;
+}
+
+/*
+ * Sort a MultiGet batch by key. Integer keys are first distributed over about one bucket per key by their
+ * bits above the smallest key, which orders a batch of spread out keys but for a few buckets of two or
+ * three keys, and only those buckets are sorted, far fewer comparisons than sorting the whole batch.
+ */
+template <typename KeyType>
+void SortBatch(std::vector<std::pair<KeyType, size_t>> *batch) {
+  if constexpr (std::is_integral_v<KeyType>) {
+    if (batch->size() >= 32) {
+      auto [min, max] = std::minmax_element(batch->begin(), batch->end());
+      uint64_t base = static_cast<uint64_t>(min->first);
+      uint64_t range = static_cast<uint64_t>(max->first) - base;
+      size_t buckets = 1;
+      while (buckets < batch->size()) {
+        buckets <<= 1;
+      }
+      int shift = 0;
+      while (shift < 64 && (range >> shift) >= buckets) {
+        shift++;
+      }
+      auto bucket = [base, shift](const std::pair<KeyType, size_t> &entry) {
+        return shift < 64 ? (static_cast<uint64_t>(entry.first) - base) >> shift : 0;
+      };
+
+      // ends[b] is the start of bucket b, and its end once the entries are scattered.
+      std::vector<uint32_t> ends(buckets + 1);
+      for (const auto &entry : *batch) {
+        ends[bucket(entry) + 1]++;
+      }
+      for (size_t b = 1; b <= buckets; ++b) {
+        ends[b] += ends[b - 1];
+      }
+      std::vector<std::pair<KeyType, size_t>> sorted(batch->size());
+      for (const auto &entry : *batch) {
+        sorted[ends[bucket(entry)]++] = entry;
+      }
+      for (size_t b = 0, start = 0; b < buckets; start = ends[b++]) {
+        if (ends[b] - start > 1) {
+          std::sort(sorted.begin() + start, sorted.begin() + ends[b]);
+        }
+      }
+      batch->swap(sorted);
+      return;
+    }
+  }
+  std::sort(batch->begin(), batch->end());
+}
+
+}  // namespace
+
 INDEX_TEMPLATE_ARGUMENTS
-BPLUSTREE::BPlusTree(std::shared_ptr<BufferPoolManager> buffer_pool_manager, size_t leaf_max_size,
+BPLUSTREE::BPlusTree(std::shared_ptr<IBufferPoolManager> buffer_pool_manager, size_t leaf_max_size,
                      size_t internal_max_size)
     : root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      leaf_max_size_(leaf_max_size != 0 ? leaf_max_size : LeafPage::MaxSizeFor(buffer_pool_manager->GetPageSize())),
+      internal_max_size_(internal_max_size != 0 ? internal_max_size
+                                                : InternalPage::MaxSizeFor(buffer_pool_manager->GetPageSize())) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE::BPlusTree(std::string index_name, std::shared_ptr<IBufferPoolManager> buffer_pool_manager,
+                     size_t leaf_max_size, size_t internal_max_size)
+    : BPlusTree(buffer_pool_manager, leaf_max_size, internal_max_size) {
+  index_name_ = std::move(index_name);
+  auto page = buffer_pool_manager_->FetchPageRead(HEADER_PAGE_ID);
+  if (!page) {
+    throw std::runtime_error("out of memory");
+  }
+  page_id_t root_page_id = INVALID_PAGE_ID;
+  reinterpret_cast<HeaderPage *>(page.GetData())->GetRootId(index_name_, &root_page_id);
+  root_page_id_ = root_page_id;
+}
 
 // This function doesn't provide concurrency control for accessing root_page_id.
 // The caller should acquire root_mutex throughout the call.
@@ -32,37 +111,378 @@ bool BPLUSTREE::IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID; }
  * @return : true means key exists
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE::GetValue(const KeyType &key, ValueType &value, Transaction *transaction) {
-  if (root_page_id_ == INVALID_PAGE_ID) {
+bool BPLUSTREE::GetValue(const KeyType &key, ValueType &value, Transaction * /*transaction*/) {
+  // Optimistic descents first, latch crabbing once they keep conflicting with writers or hit a page that is
+  // not in the buffer pool, which FetchPage loads.
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; ++attempt) {
+    OptimisticResult result = OptimisticGetValue(key, &value);
+    if (result == OptimisticResult::Found || result == OptimisticResult::NotFound) {
+      return result == OptimisticResult::Found;
+    }
+    if (result == OptimisticResult::Miss) {
+      break;
+    }
+  }
+
+  auto page = FindLeafPageBLink<ReadPageGuard>(key, false, nullptr, false);
+  if (!page) {
     return false;
   }
+  return page.template As<LeafPage>()->Lookup(key, &value);
+}
 
-  bool allocated = false;
-  if (transaction == nullptr) {
-    transaction = new Transaction(0);
-    allocated = true;
+/*
+ * Optimistic lock coupling: descend without latching or pinning, taking the version of every page before
+ * reading it and validating it once the version of the child is taken. A validated page was not modified
+ * while it was read, and a validated parent means its child was still its child, not a page freed or
+ * evicted since. A page split since its parent was read is left for its right sibling, as in a latched
+ * descent. Writers latch, WLatch changes the version of the page, so they never wait for optimistic readers.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE::OptimisticResult BPLUSTREE::OptimisticGetValue(const KeyType &key, ValueType *value) {
+  page_id_t page_id = root_page_id_.load();
+  if (page_id == INVALID_PAGE_ID) {
+    return OptimisticResult::NotFound;
   }
 
-  std::unique_lock root_lock(root_mutex);  // locked, guaranteed unlock before return
+  Page *parent = nullptr;
+  uint64_t parent_version = 0;
+  for (;;) {
+    Page *page = buffer_pool_manager_->PeekPage(page_id);
+    if (page == nullptr) {
+      return OptimisticResult::Miss;
+    }
+    uint64_t version = page->GetVersion();
+    if (version % 2 != 0 || page->GetPageId() != page_id) {
+      return OptimisticResult::Restart;
+    }
+    // The root has no parent to validate, a new root changes root_page_id_ instead.
+    if (parent == nullptr ? root_page_id_.load() != page_id : !parent->ValidateVersion(parent_version)) {
+      return OptimisticResult::Restart;
+    }
 
-  auto page = FindLeafPageRW(key, false, OpType::Read, transaction);  // pinned, latched
-  bool root_page_safe = transaction->GetPageSet()->front()->GetPageId() != root_page_id_;
-  if (root_page_safe) {
-    root_lock.unlock();
+    auto *node = reinterpret_cast<const BPlusTreePage *>(page->GetData());
+    if (IsPastHighKey(node, key)) {
+      // Split since the parent was read, the right sibling is validated against this page like a child.
+      page_id = GetNextPageId(node);
+      parent = page;
+      parent_version = version;
+      continue;
+    }
+    if (node->IsLeafPage()) {
+      bool found;
+      if (!reinterpret_cast<const LeafPage *>(node)->OptimisticLookup(key, page->GetPageSize(), value, &found) ||
+          !page->ValidateVersion(version)) {
+        return OptimisticResult::Restart;
+      }
+      return found ? OptimisticResult::Found : OptimisticResult::NotFound;
+    }
+    if (!reinterpret_cast<const InternalPage *>(node)->OptimisticLookup(key, page->GetPageSize(), &page_id)) {
+      return OptimisticResult::Restart;
+    }
+    parent = page;
+    parent_version = version;
+  }
+}
+
+/*
+ * Sort the batch, with the index of every key so values and found are written in the order of keys, and
+ * resolve it optimistically. A leaf that keeps changing under the optimistic reads, or a page that is not in
+ * the buffer pool, is left to LatchedMultiGet, which fetches the pages it needs, for the keys of one leaf.
+ * A single key is left to GetValue.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE::MultiGet(const KeyType *keys, size_t count, ValueType *values, uint64_t *found) {
+  if (count == 1) {
+    found[0] = GetValue(keys[0], values[0]) ? 1 : 0;
+    return found[0];
   }
+  std::vector<BatchKey> batch(count);
+  for (size_t i = 0; i < count; ++i) {
+    batch[i] = {keys[i], i};
+  }
+  SortBatch(&batch);
+  std::fill(found, found + (count + 63) / 64, 0);
+
+  size_t next = 0;
+  int attempt = 0;
+  while (next < count) {
+    size_t start = next;
+    OptimisticResult result = OptimisticMultiGet(batch.data(), count, &next, values, found);
+    if (result == OptimisticResult::Found || result == OptimisticResult::NotFound) {
+      break;
+    }
+    attempt = next > start ? 1 : attempt + 1;
+    if (result == OptimisticResult::Miss || attempt >= OPTIMISTIC_READ_ATTEMPTS) {
+      next = LatchedMultiGet(batch.data(), count, next, values, found);
+      attempt = 0;
+    }
+  }
+
+  size_t hits = 0;
+  for (size_t i = 0; i < (count + 63) / 64; ++i) {
+    hits += __builtin_popcountll(found[i]);
+  }
+  return hits;
+}
+
+/*
+ * OptimisticGetValue for a sorted batch. The pages on the path to the last leaf are kept with their
+ * versions: keys ascend, so a page whose keys start at or before the previous key covers the next key
+ * unless it is past the high key of the page, and the next descent starts at the lowest page that
+ * covers it. Child page ids read from a kept page are validated against its version as in
+ * OptimisticGetValue, so a page changed since it was kept restarts the descent from the root.
+ *
+ * The first key descends to its leaf, and the keys landing on that leaf are looked up one after the other,
+ * each search starting at the position of the previous key, with one validation of the leaf for all of
+ * them. The keys after them are children of the same parent until one is past its high key, they are
+ * resolved in groups by OptimisticMultiGetGroup.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE::OptimisticResult BPLUSTREE::OptimisticMultiGet(const BatchKey *batch, size_t count, size_t *next,
+                                                                  ValueType *values, uint64_t *found) {
+  struct PathEntry {
+    Page *page;
+    uint64_t version;
+  };
+  std::array<PathEntry, MAX_TREE_HEIGHT> path;
+  size_t depth = 0;
+  bool leaf_parent = false;  // path[depth - 1] is the parent of leaves
+
+  while (*next < count) {
+    const KeyType &key = batch[*next].first;
+    while (depth > 0 && IsPastHighKey(AsTreePage(path[depth - 1].page), key)) {
+      depth--;
+      leaf_parent = false;
+    }
+    if (leaf_parent) {
+      OptimisticResult result =
+          OptimisticMultiGetGroup(batch, count, next, path[depth - 1].page, path[depth - 1].version, values, found);
+      if (result != OptimisticResult::Found) {
+        return result;
+      }
+      continue;
+    }
 
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(page->GetData());
+    page_id_t page_id;
+    Page *parent = nullptr;
+    uint64_t parent_version = 0;
+    if (depth == 0) {
+      page_id = root_page_id_.load();
+      if (page_id == INVALID_PAGE_ID) {
+        for (; *next < count; ++*next) {
+          SetFound(found, batch[*next].second, false);
+        }
+        return OptimisticResult::NotFound;
+      }
+    } else {
+      parent = path[depth - 1].page;
+      parent_version = path[depth - 1].version;
+      if (!reinterpret_cast<const InternalPage *>(parent->GetData())
+               ->OptimisticLookup(key, parent->GetPageSize(), &page_id)) {
+        return OptimisticResult::Restart;
+      }
+    }
 
-  bool exists = leaf_node->Lookup(key, &value);
+    for (;;) {
+      Page *page = buffer_pool_manager_->PeekPage(page_id);
+      if (page == nullptr) {
+        return OptimisticResult::Miss;
+      }
+      uint64_t version = page->GetVersion();
+      if (version % 2 != 0 || page->GetPageId() != page_id) {
+        return OptimisticResult::Restart;
+      }
+      if (parent == nullptr ? root_page_id_.load() != page_id : !parent->ValidateVersion(parent_version)) {
+        return OptimisticResult::Restart;
+      }
 
-  UnlatchAndUnpin(OpType::Read, transaction);  // unlatch and unpin
+      auto *node = reinterpret_cast<const BPlusTreePage *>(page->GetData());
+      if (IsPastHighKey(node, key)) {
+        page_id = GetNextPageId(node);
+        parent = page;
+        parent_version = version;
+        continue;
+      }
+      if (!node->IsLeafPage()) {
+        if (depth == path.size() ||
+            !reinterpret_cast<const InternalPage *>(node)->OptimisticLookup(key, page->GetPageSize(), &page_id)) {
+          return OptimisticResult::Restart;
+        }
+        path[depth++] = {page, version};
+        parent = page;
+        parent_version = version;
+        continue;
+      }
 
-  if (allocated) {
-    delete transaction;
+      auto *leaf = reinterpret_cast<const LeafPage *>(node);
+      size_t end = count;
+      if (leaf->GetNextPageId() != INVALID_PAGE_ID) {
+        KeyType high_key = leaf->GetHighKey();
+        auto below_high_key = [&high_key](const BatchKey &entry) { return entry.first < high_key; };
+        end = std::partition_point(batch + *next + 1, batch + count, below_high_key) - batch;
+      }
+      int position = 0;
+      for (size_t i = *next; i < end; ++i) {
+        bool hit;
+        if (!leaf->OptimisticLookup(batch[i].first, page->GetPageSize(), &values[batch[i].second], &hit, &position)) {
+          return OptimisticResult::Restart;
+        }
+        SetFound(found, batch[i].second, hit);
+      }
+      if (!page->ValidateVersion(version)) {
+        return OptimisticResult::Restart;
+      }
+      *next = end;
+      // Not when the leaf was reached through a right link, its parent is not on the path.
+      leaf_parent = depth > 0 && path[depth - 1].page == parent;
+      break;
+    }
   }
-  return exists;
+  return OptimisticResult::Found;
+}
+
+/*
+ * A leaf search is a binary search over thousands of keys, most probes miss the cache. Searching the
+ * leaves of a group of keys in lockstep, one probe of each key per round with the next probe prefetched,
+ * overlaps those misses, as prefetching the leaves themselves, before any of them is read, overlaps the
+ * misses of their headers. Keys whose leaves changed are left for a restart, the keys before them are
+ * resolved.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE::OptimisticResult BPLUSTREE::OptimisticMultiGetGroup(const BatchKey *batch, size_t count,
+                                                                       size_t *next, Page *parent,
+                                                                       uint64_t parent_version, ValueType *values,
+                                                                       uint64_t *found) {
+  struct Probe {
+    Page *page;
+    page_id_t page_id;
+    uint64_t version;
+    const KeyType *keys;  // of the leaf
+    const ValueType *values;
+    int size;
+    const KeyType *base;  // the key is in [base, base + n] of keys
+    int n;
+    ValueType value;
+    bool hit;
+  };
+  std::array<Probe, MULTI_GET_GROUP> group;
+  size_t size = 0;
+  OptimisticResult stop = OptimisticResult::Found;
+
+  auto *parent_node = reinterpret_cast<const InternalPage *>(parent->GetData());
+  for (; size < group.size() && *next + size < count; ++size) {
+    const KeyType &key = batch[*next + size].first;
+    if (parent_node->IsPastHighKey(key)) {
+      break;
+    }
+    Probe &probe = group[size];
+    if (!parent_node->OptimisticLookup(key, parent->GetPageSize(), &probe.page_id)) {
+      return OptimisticResult::Restart;
+    }
+    probe.page = size > 0 && group[size - 1].page_id == probe.page_id ? group[size - 1].page
+                                                                       : buffer_pool_manager_->PeekPage(probe.page_id);
+    if (probe.page == nullptr) {
+      stop = OptimisticResult::Miss;
+      break;
+    }
+    __builtin_prefetch(probe.page);
+    __builtin_prefetch(probe.page->GetData());
+  }
+  if (size == 0 && stop == OptimisticResult::Found) {
+    return OptimisticResult::Restart;
+  }
+
+  // Versions and key arrays of the leaves, then the parent they were looked up in is validated.
+  for (size_t i = 0; i < size; ++i) {
+    Probe &probe = group[i];
+    probe.version = probe.page->GetVersion();
+    auto *leaf = reinterpret_cast<const LeafPage *>(probe.page->GetData());
+    if (probe.version % 2 != 0 || probe.page->GetPageId() != probe.page_id ||
+        !leaf->OptimisticArrays(probe.page->GetPageSize(), &probe.keys, &probe.values, &probe.size) ||
+        leaf->IsPastHighKey(batch[*next + i].first)) {
+      size = i;
+      stop = OptimisticResult::Restart;
+      break;
+    }
+    probe.base = probe.keys;
+    probe.n = probe.size;
+    __builtin_prefetch(probe.base + probe.n / 2);
+  }
+  if (!parent->ValidateVersion(parent_version)) {
+    return OptimisticResult::Restart;
+  }
+
+  for (bool searching = true; searching;) {
+    searching = false;
+    for (size_t i = 0; i < size; ++i) {
+      Probe &probe = group[i];
+      if (probe.n > 1) {
+        int half = probe.n / 2;
+        probe.base = probe.base[half] < batch[*next + i].first ? probe.base + half : probe.base;
+        probe.n -= half;
+        __builtin_prefetch(probe.base + probe.n / 2);
+        searching = true;
+      }
+    }
+  }
+  for (size_t i = 0; i < size; ++i) {
+    Probe &probe = group[i];
+    const KeyType &key = batch[*next + i].first;
+    int position = static_cast<int>(probe.base - probe.keys) + (probe.n == 1 && *probe.base < key);
+    probe.hit = position < probe.size && probe.keys[position] == key;
+    if (probe.hit) {
+      probe.value = probe.values[position];
+    }
+  }
+
+  // Keys on the same leaf, read at the same version, are validated once.
+  for (size_t i = 0; i < size; ++i) {
+    Probe &probe = group[i];
+    if ((i == 0 || probe.page != group[i - 1].page || probe.version != group[i - 1].version) &&
+        !probe.page->ValidateVersion(probe.version)) {
+      return OptimisticResult::Restart;
+    }
+    size_t index = batch[*next].second;
+    if (probe.hit) {
+      values[index] = probe.value;
+    }
+    SetFound(found, index, probe.hit);
+    ++*next;
+  }
+  return stop;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE::LatchedMultiGet(const BatchKey *batch, size_t count, size_t next, ValueType *values,
+                                  uint64_t *found) {
+  auto page = FindLeafPageBLink<ReadPageGuard>(batch[next].first, false, nullptr, false);
+  if (!page) {
+    SetFound(found, batch[next].second, false);
+    return next + 1;
+  }
+  auto *leaf = page.template As<LeafPage>();
+  do {
+    SetFound(found, batch[next].second, leaf->Lookup(batch[next].first, &values[batch[next].second]));
+    next++;
+  } while (next < count && !leaf->IsPastHighKey(batch[next].first));
+  return next;
 }
 
+/*****************************************************************************
+ * INDEX ITERATOR
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeyType, ValueType> BPLUSTREE::Begin() { return IndexIterator<KeyType, ValueType>(this, true, KeyType{}); }
+
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeyType, ValueType> BPLUSTREE::Begin(const KeyType &key) {
+  return IndexIterator<KeyType, ValueType>(this, false, key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeyType, ValueType> BPLUSTREE::End() { return IndexIterator<KeyType, ValueType>(); }
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -74,9 +494,42 @@ bool BPLUSTREE::GetValue(const KeyType &key, ValueType &value, Transaction *tran
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+bool BPLUSTREE::Insert(const KeyType &key, const ValueType &value, Transaction * /*transaction*/) {
   // If necessary, split is performed.
-  return InsertIntoLeaf(key, value, transaction);
+  return InsertIntoLeaf(key, [&value](const ValueType *, ValueType *new_value) {
+    *new_value = value;
+    return false;
+  });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE::Upsert(const KeyType &key, const ValueType &value) {
+  return InsertIntoLeaf(key, [&value](const ValueType *, ValueType *new_value) {
+    *new_value = value;
+    return true;
+  });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE::Merge(const KeyType &key, const std::function<ValueType(const ValueType *)> &merge) {
+  return InsertIntoLeaf(key, [&merge](const ValueType *existing, ValueType *new_value) {
+    *new_value = merge(existing);
+    return true;
+  });
+}
+
+/*
+ * Only the leaf is write latched, like the first descent of InsertIntoLeaf, and as the leaf does not change
+ * size, Update never takes structure_latch_ nor restarts.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE::Update(const KeyType &key, const ValueType &value) {
+  auto leaf_page = FindLeafPageBLink<WritePageGuard>(key, false, nullptr, false);
+  if (!leaf_page || !leaf_page.template As<LeafPage>()->Update(key, value)) {
+    return false;
+  }
+  leaf_page.SetDirty();
+  return true;
 }
 
 /*
@@ -90,29 +543,31 @@ bool BPLUSTREE::Insert(const KeyType &key, const ValueType &value, Transaction *
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE::StartNewTree(const KeyType &key, const ValueType &value) {
   // Ask for new page from buffer pool manager
-  auto new_page = buffer_pool_manager_->NewPage();  // pinned
+  auto new_page = buffer_pool_manager_->NewPageGuarded();  // pinned
 
-  if (new_page == nullptr) {
+  if (!new_page) {
     throw std::runtime_error("out of memory");
   }
+  new_page.SetDirty();
 
-  root_page_id_ = new_page->GetPageId();
+  page_id_t root_page_id = new_page.PageId();
 
-  LeafPage *leaf_page = reinterpret_cast<LeafPage *>(new_page->GetData());
-  leaf_page->Init(root_page_id_, INVALID_PAGE_ID, leaf_max_size_);
-
-  // Update root page id in the header page.
-  // We are inserting a new root page id, so insert_record = 1.
-  UpdateRootPageId(1);
+  LeafPage *leaf_page = new_page.template As<LeafPage>();
+  leaf_page->Init(root_page_id, INVALID_PAGE_ID, leaf_max_size_);
 
   // Insert entry directly into leaf page.
   // For a new B+ tree, the root page IS the leaf page.
   leaf_page->Insert(key, value);
 
+  // Publish the root once it is written, optimistic readers do not take root_mutex.
+  root_page_id_ = root_page_id;
+
+  // Update root page id in the header page.
+  // We are inserting a new root page id, so insert_record = 1.
+  UpdateRootPageId(1);
+
   LOG(INFO) << "Created a new BPLUS Tree, ENTRY_SIZE " << sizeof(MappingType) << " LEAF_MAX_SIZE " << leaf_max_size_
             << " INTERNAL_MAX_SIZE " << internal_max_size_ << std::endl;
-
-  buffer_pool_manager_->UnpinPage(root_page_id_, true);  // unpin
 }
 
 /*
@@ -120,61 +575,191 @@ void BPLUSTREE::StartNewTree(const KeyType &key, const ValueType &value) {
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
  * immediately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @param value_of value_of(existing, &value) sets the value to store, existing points to the value of key in
+ *                 the leaf, or is nullptr if key is not in the tree, and returns false to keep the existing
+ *                 value. It is called once, with the leaf latched, when the key is found or about to be
+ *                 inserted. The value of an existing key is set in place.
+ * @return: true if key was inserted, false if it was in the tree already.
+ *
+ * Only the leaf is write latched. An insert that fills the leaf restarts holding structure_latch_ shared,
+ * so no merge runs until its split reached the parent levels, and splits the leaf B-link style, see
+ * InsertIntoParent. Inserts do not use transaction.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  std::unique_lock root_lock(root_mutex);  // locked, guaranteed unlock before return
-  if (IsEmpty()) {
-    StartNewTree(key, value);  // root_mutex held throughout the call
-    return true;
-  }
+template <typename ValueOf>
+bool BPLUSTREE::InsertIntoLeaf(const KeyType &key, ValueOf &&value_of) {
+  std::shared_lock<std::shared_mutex> structure_lock(structure_latch_, std::defer_lock);
+  std::vector<page_id_t> path;  // only a split needs the path
+  ValueType value;
+  for (;;) {
+    bool split = structure_lock.owns_lock();
+    auto leaf_page = FindLeafPageBLink<WritePageGuard>(key, false, split ? &path : nullptr, split);
+    if (!leaf_page) {
+      std::lock_guard<std::mutex> root_lock(root_mutex);
+      if (IsEmpty()) {
+        value_of(nullptr, &value);
+        StartNewTree(key, value);  // root_mutex held throughout the call
+        return true;
+      }
+      continue;  // another insert started the tree
+    }
+    auto leaf_node = leaf_page.template As<LeafPage>();
+
+    // duplicate, set in place and return immediately, the leaf does not change size
+    bool append;
+    ValueType *existing = FindExisting(leaf_node, key, &append);
+    if (existing != nullptr) {
+      if (value_of(existing, &value)) {
+        *existing = value;
+        leaf_page.SetDirty();
+      }
+      return false;
+    }
 
-  bool allocated = false;
-  if (transaction == nullptr) {
-    transaction = new Transaction(0);
-    allocated = true;
-  }
+    if (!split && !isSafe(leaf_node, OpType::Insert)) {
+      leaf_page.Drop();
+      insert_restarts_.fetch_add(1, std::memory_order_relaxed);
+      structure_lock.lock();
+      continue;
+    }
 
-  // root_mutex already held
-  auto leaf_page = FindLeafPageRW(key, false, OpType::Insert, transaction);  // leaf_page pinned, page(s) latched
-  bool root_page_safe = transaction->GetPageSet()->front()->GetPageId() != root_page_id_;
-  if (root_page_safe) {
-    root_lock.unlock();
+    // no duplicate: insert
+    value_of(nullptr, &value);
+    leaf_node->Insert(key, value);
+    leaf_page.SetDirty();
+
+    // Split if necessary. When size=leaf_max_size, split. See SplitTest.
+    if (leaf_node->GetSize() == maxSize(leaf_node) + 1) {
+      // Split: 1. Redistribute evenly; 2. Copy up middle key.
+      // Appending to the last leaf moves only the new key, increasing keys would leave every leaf half full.
+      // The new page is reachable through the right link of the leaf once the leaf is unlatched.
+      bool append_split = append && leaf_node->GetNextPageId() == INVALID_PAGE_ID;
+      auto new_leaf_page = Split(leaf_node, append_split);  // pinned
+      KeyType separator = new_leaf_page.template As<LeafPage>()->KeyAt(0);
+      page_id_t new_page_id = new_leaf_page.PageId();
+      page_id_t leaf_page_id = leaf_page.PageId();
+      leaf_page.Drop();
+      new_leaf_page.Drop();
+      InsertIntoParent(leaf_page_id, separator, new_page_id, &path);
+      return true;
+    }
+
+    //        LOG(INFO) << "Entry " << key << " : " << value << " inserted\n";
+    return true;
   }
+}
 
-  auto leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+/*
+ * Find the value of key in leaf, which is write latched.
+ * @param[out] append true if key is past the last key of the leaf, such a key, like an increasing
+ *                    time-series id, cannot be a duplicate and is found without a search
+ * @return the value of key in the leaf, nullptr if key is not a duplicate
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType *BPLUSTREE::FindExisting(LeafPage *leaf, const KeyType &key, bool *append) {
+  *append = leaf->GetSize() == 0 || leaf->KeyAt(leaf->GetSize() - 1) < key;
+  return *append ? nullptr : leaf->FindValue(key);
+}
 
-  // duplicate, return immediately
-  if (leaf_node->Lookup(key, nullptr)) {
-    UnlatchAndUnpin(OpType::Insert, transaction);
-    return false;
+/*
+ * Build the tree from count entries sorted by strictly increasing key.
+ * The size of every level is planned first, and the entries of a level are spread evenly over its
+ * nodes, so that no node is underfull. Then the leaves are filled left to right. Starting a node adds
+ * its first key and page id to the node being filled one level up, which starts a new node when it is
+ * full, so the parent of every node is known when the node is created. Only the node being filled on
+ * every level is pinned, a finished node is never touched again.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE::BulkLoad(size_t count, const std::function<void(KeyType *, ValueType *)> &next, double fill_factor) {
+  std::lock_guard<std::mutex> root_lock(root_mutex);
+  if (!IsEmpty()) {
+    throw std::runtime_error("BulkLoad: the tree is not empty");
+  }
+  if (count == 0) {
+    return;
   }
 
-  // no duplicate: insert
-  leaf_node->Insert(key, value);
-
-  // Split if necessary. When size=leaf_max_size, split. See SplitTest.
-  if (leaf_node->GetSize() == maxSize(leaf_node) + 1) {
-    // If we enter this branch, leaf_node is not safe, so parent must have been latched.
+  // Nodes are filled at least to the minimum size, and at most to the size that triggers a split.
+  size_t leaf_min = std::max<size_t>(1, leaf_max_size_ / 2);
+  size_t leaf_capacity =
+      std::clamp(static_cast<size_t>(fill_factor * (leaf_max_size_ - 1)), leaf_min, std::max<size_t>(1, leaf_max_size_ - 1));
+  size_t internal_min = std::max<size_t>(2, (internal_max_size_ + 1) / 2);
+  size_t internal_capacity = std::clamp(static_cast<size_t>(fill_factor * internal_max_size_), internal_min,
+                                        std::max<size_t>(2, internal_max_size_));
+
+  std::vector<BulkLevel> levels;
+  for (size_t entries = count, capacity = leaf_capacity, min = leaf_min;;
+       capacity = internal_capacity, min = internal_min) {
+    size_t nodes = (entries + capacity - 1) / capacity;
+    if (entries / nodes < min) {
+      // Too few entries to fill the last node to the minimum, spread them over one node less.
+      nodes = std::max<size_t>(1, entries / min);
+    }
+    levels.push_back(BulkLevel{entries, nodes});
+    if (nodes == 1) {
+      break;
+    }
+    entries = nodes;
+  }
 
-    // Split: 1. Redistribute evenly; 2. Copy up middle key.
-    // No need to wlatch the new page. No other thread can access it simultaneously, as parent is wlatched.
-    LeafPage *new_leaf_page = Split(leaf_node);  // new_leaf_page pinned
-    InsertIntoParent(leaf_node, new_leaf_page->KeyAt(0), new_leaf_page, transaction);
+  KeyType key;
+  ValueType value;
+  for (size_t i = 0; i < count; ++i) {
+    next(&key, &value);
+    if (!levels[0].page || levels[0].page.template As<LeafPage>()->GetSize() == static_cast<int>(levels[0].target)) {
+      StartBulkNode(&levels, 0, key);
+    }
+    levels[0].page.template As<LeafPage>()->Insert(key, value);
+  }
 
-    buffer_pool_manager_->UnpinPage(new_leaf_page->GetPageId(), true);  // new_leaf_page unpin
+  root_page_id_ = levels.back().page.PageId();
+  for (auto &level : levels) {
+    level.page.Drop();
   }
+  UpdateRootPageId(1);
+}
 
-  UnlatchAndUnpin(OpType::Insert, transaction);
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE::StartBulkNode(std::vector<BulkLevel> *levels, size_t level, const KeyType &key) {
+  auto page = buffer_pool_manager_->NewPageGuarded();  // pinned until the next node of the level is started
+  if (!page) {
+    throw std::runtime_error("out of memory");
+  }
+  page.SetDirty();
+  page_id_t page_id = page.PageId();
+
+  page_id_t parent_page_id = INVALID_PAGE_ID;
+  if (level + 1 < levels->size()) {
+    BulkLevel &parent_level = (*levels)[level + 1];
+    if (!parent_level.page ||
+        parent_level.page.template As<InternalPage>()->GetSize() == static_cast<int>(parent_level.target)) {
+      StartBulkNode(levels, level + 1, key);
+    }
+    auto *parent = parent_level.page.template As<InternalPage>();
+    parent->AppendChild(key, page_id);
+    parent_page_id = parent->GetPageId();
+  }
 
-  if (allocated) {
-    delete transaction;
+  // The previous node of the level links to the new one, which starts at its high key.
+  BulkLevel &bulk_level = (*levels)[level];
+  if (level == 0) {
+    page.template As<LeafPage>()->Init(page_id, parent_page_id, leaf_max_size_);
+    if (bulk_level.page) {
+      bulk_level.page.template As<LeafPage>()->SetNextPageId(page_id);
+      bulk_level.page.template As<LeafPage>()->SetHighKey(key);
+    }
+  } else {
+    page.template As<InternalPage>()->Init(page_id, parent_page_id, internal_max_size_);
+    if (bulk_level.page) {
+      bulk_level.page.template As<InternalPage>()->SetNextPageId(page_id);
+      bulk_level.page.template As<InternalPage>()->SetHighKey(key);
+    }
   }
 
-  //        LOG(INFO) << "Entry " << key << " : " << value << " inserted\n";
-  return true;
+  bulk_level.page = std::move(page);  // unpins the finished node
+  bulk_level.target =
+      bulk_level.entries / bulk_level.nodes + (bulk_level.started < bulk_level.entries % bulk_level.nodes ? 1 : 0);
+  bulk_level.started++;
 }
 
 /*
@@ -183,114 +768,262 @@ bool BPLUSTREE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Trans
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page.
+ * If last_only, only the last entry of a leaf is moved.
+ * The new page takes the right link and the high key of the input page, which links to the new page, and
+ * whose high key becomes the first key of the new page.
  *
- * The new page is pinned. (NOT wlatched)
+ * @return the new page, pinned and NOT latched
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-N *BPLUSTREE::Split(N *node) {
+BasicPageGuard BPLUSTREE::Split(N *node, bool last_only) {
   // Allocate new page
-  auto new_page = buffer_pool_manager_->NewPage();  // pinned
-  if (new_page == nullptr) {
+  auto new_page = buffer_pool_manager_->NewPageGuarded();  // pinned
+  if (!new_page) {
     throw std::runtime_error("out of memory");
   }
-  page_id_t new_page_id = new_page->GetPageId();
+  new_page.SetDirty();
+  page_id_t new_page_id = new_page.PageId();
   // Move suffix to the new node
-  N *new_node;
   if (node->IsLeafPage()) {
     LeafPage *leaf_node = reinterpret_cast<LeafPage *>(node);
 
-    LeafPage *new_leaf_node = reinterpret_cast<LeafPage *>(new_page->GetData());
+    LeafPage *new_leaf_node = new_page.template As<LeafPage>();
     new_leaf_node->Init(new_page_id, leaf_node->GetParentPageId(), leaf_max_size_);
-    leaf_node->MoveHalfTo(new_leaf_node);
+    if (last_only) {
+      leaf_node->MoveTailTo(new_leaf_node, 1);
+    } else {
+      leaf_node->MoveHalfTo(new_leaf_node);
+    }
 
     new_leaf_node->SetNextPageId(leaf_node->GetNextPageId());  // [Attention] when leaf_node already has a right sibling
+    new_leaf_node->SetHighKey(leaf_node->GetHighKey());
     leaf_node->SetNextPageId(new_page_id);
-
-    new_node = reinterpret_cast<N *>(new_leaf_node);
+    leaf_node->SetHighKey(new_leaf_node->KeyAt(0));
   } else {
     InternalPage *internal_page = reinterpret_cast<InternalPage *>(node);
-    InternalPage *new_internal_page = reinterpret_cast<InternalPage *>(new_page->GetData());
+    InternalPage *new_internal_page = new_page.template As<InternalPage>();
     new_internal_page->Init(new_page_id, internal_page->GetParentPageId(), internal_max_size_);
     internal_page->MoveHalfTo(new_internal_page, buffer_pool_manager_);
 
-    new_node = reinterpret_cast<N *>(new_internal_page);
+    new_internal_page->SetNextPageId(internal_page->GetNextPageId());
+    new_internal_page->SetHighKey(internal_page->GetHighKey());
+    internal_page->SetNextPageId(new_page_id);
+    internal_page->SetHighKey(new_internal_page->KeyAt(0));
   }
 
-  // New page pinned
-  return new_node;
+  return new_page;
 }
 
 /*
- * Insert key & value pair into internal page after split
- * @param   old_node      input page from split() method (assume to be pinned)
- * @param   key
- * @param   new_node      returned page from split() method (assume to be pinned)
- *
- * The caller should handling unpin old_node and new_node.
+ * Insert the separator of a split into the parent level: the keys from key on of page left_page_id were
+ * moved to its new right sibling right_page_id, which is reachable through the right link of
+ * left_page_id meanwhile. The caller holds structure_latch_ shared and no latch.
  *
- * User needs to first find the parent page of old_node, parent node must be
- * adjusted to take info of new_node into account. Remember to deal with split
- * recursively if necessary.
- *
- * Only old_node is latched, new_node is not latched. If the parent node already exists, it's already latched.
- * Otherwise, a new root will be created, and the root page will be latched.
+ * The parent is the page the descent went through one level up, popped from path, or a right sibling of
+ * it, when it was split since: MoveRight finds the page whose key range holds key. When path is empty,
+ * left_page_id was at the level of the root when the descent started. Either it is still the root and
+ * the tree grows by one level, or another split grew the tree and set the parent id of left_page_id,
+ * which may be stale but never right of the parent, as only splits move children, to the right.
+ * A parent that overflows is split the same way, holding only its own latch.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                 Transaction *transaction) {
-  // Parent page must have been latched, as old_node cannot be safe. Root_mutex might not be held.
-
-  std::shared_ptr<Page> parent_page;
-  if (old_node->IsRootPage()) {
-    // Splitting original root page, B+ tree height will grow by one
-    parent_page = buffer_pool_manager_->NewPage();  // new root pinned
-    if (parent_page == nullptr) {
-      throw std::runtime_error("out of memory");
+void BPLUSTREE::InsertIntoParent(page_id_t left_page_id, const KeyType &separator, page_id_t right_page_id,
+                                 std::vector<page_id_t> *path) {
+  KeyType key = separator;
+  for (;;) {
+    page_id_t parent_page_id;
+    if (path->empty()) {
+      std::unique_lock root_lock(root_mutex);
+      if (root_page_id_ == left_page_id) {
+        // Splitting original root page, B+ tree height will grow by one
+        auto root_page = buffer_pool_manager_->NewPageGuarded();  // new root pinned
+        if (!root_page) {
+          throw std::runtime_error("out of memory");
+        }
+        root_page.SetDirty();
+        parent_page_id = root_page.PageId();
+        InternalPage *root = root_page.template As<InternalPage>();
+        root->Init(parent_page_id, INVALID_PAGE_ID, internal_max_size_);
+        root->PopulateNewRoot(left_page_id, key, right_page_id);
+        SetParentPageId(left_page_id, parent_page_id);
+        SetParentPageId(right_page_id, parent_page_id);
+
+        // Publish the root once it is written, optimistic readers do not take root_mutex.
+        root_page_id_ = parent_page_id;
+        UpdateRootPageId(0);
+        return;
+      }
+      parent_page_id = GetParentPageId(left_page_id);
+      if (parent_page_id == INVALID_PAGE_ID) {
+        // left_page_id is the right sibling of a root whose split is about to publish the new root.
+        root_lock.unlock();
+        std::this_thread::yield();
+        continue;
+      }
+    } else {
+      parent_page_id = path->back();
+      path->pop_back();
     }
 
-    page_id_t parent_page_id = parent_page->GetPageId();
-    root_page_id_ = parent_page_id;
-    UpdateRootPageId(0);
-
-    InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
-    parent_node->Init(parent_page_id, INVALID_PAGE_ID, internal_max_size_);
-
-    parent_node->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    auto parent_page = buffer_pool_manager_->FetchPageWrite(parent_page_id);
+    if (!parent_page) {
+      throw std::runtime_error("FetchPage returns nullptr");
+    }
+    MoveRight(&parent_page, key, true);
+    InternalPage *parent_node = parent_page.template As<InternalPage>();
 
-    old_node->SetParentPageId(parent_page_id);
-    new_node->SetParentPageId(parent_page_id);
+    // The separator goes after the keys less than it, the entry of left_page_id may have moved since.
+    parent_node->Insert(key, right_page_id);
+    parent_page.SetDirty();
+    SetParentPageId(right_page_id, parent_node->GetPageId());
 
-    buffer_pool_manager_->UnpinPage(parent_page_id, true);  // new root unpin
-  } else {
-    // This else branch handles both copy-up and push-up behavior.
-    // - When splitting a leaf node, do copy-up, when splitting an internal node, do push-up.
-    // - Split() distributes key&value pairs. Half key&value pairs are moved to the new node. For internal page, new
-    //   page's 0-th element's key is filled (and effectively ignored), this is correct! This key can be considered
-    //   removed the B+ tree (because this key is not used for lookup).
-    // - InsertNodeAfter() adds middle_key to the parent. Both copy-up and push-up achieved.
+    if (parent_node->GetSize() <= maxSize(parent_node)) {
+      return;
+    }
 
-    page_id_t parent_page_id = old_node->GetParentPageId();
-    parent_page = buffer_pool_manager_->FetchPage(parent_page_id);  // parent pinned
-    InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+    // Push up the middle key, the new page is reachable through the right link like a new leaf.
+    auto new_parent_page = Split(parent_node);  // pinned
+    left_page_id = parent_node->GetPageId();
+    key = new_parent_page.template As<InternalPage>()->KeyAt(0);
+    right_page_id = new_parent_page.PageId();
+  }
+}
 
-    // <key, old node's page id> is one entry in the parent page, Insert <new key, new node's page id> after that.
-    //    <key, old node> ...   ->   <key, old node> <new key, new node> ...
-    // where new key is the minimum key of the new node.
-    parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+// Parent page ids are written under the latch of the parent, not of the child, see InsertIntoParent.
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE::GetParentPageId(page_id_t page_id) {
+  auto page = buffer_pool_manager_->FetchPageBasic(page_id);
+  if (!page) {
+    throw std::runtime_error("FetchPage returns nullptr");
+  }
+  return page.template As<BPlusTreePage>()->GetParentPageId();
+}
 
-    if (parent_node->GetSize() == maxSize(parent_node) + 1) {
-      // no need to wlatch new_parent_node
-      InternalPage *new_parent_node = Split(parent_node);  // new_parent_node pinned
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE::SetParentPageId(page_id_t page_id, page_id_t parent_page_id) {
+  auto page = buffer_pool_manager_->FetchPageBasic(page_id);
+  if (!page) {
+    throw std::runtime_error("FetchPage returns nullptr");
+  }
+  page.template As<BPlusTreePage>()->SetParentPageId(parent_page_id);
+  page.SetDirty();
+}
 
-      // The parent of parent_node must have been latched (or needs to be created), as parent_node cannot be safe.
-      KeyType middle_key = new_parent_node->KeyAt(0);
-      InsertIntoParent(parent_node, middle_key, new_parent_node);
+//*****************************************************************************
+//* WRITE BATCH
+//*****************************************************************************
 
-      buffer_pool_manager_->UnpinPage(new_parent_node->GetPageId(), true);  // unpin new parent
+/*
+ * Apply the operations sorted by key, leaf by leaf. A visit write latches the leaf of the next operation
+ * and applies every operation on a key of the leaf, as long as it leaves the leaf neither overfull nor
+ * underfull. The new keys of a visit are inserted in one pass over the leaf, and its deletes removed in
+ * another, an Insert per key would move half of the leaf every time. A put into a full leaf restarts the
+ * visit holding structure_latch_ shared, as an insert does, and splits the leaf once, which ends the visit,
+ * the next visit descends to the half the next key belongs to. A delete that would leave the leaf underfull
+ * is left to Remove, which merges.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE::Write(const WriteBatch<KeyType, ValueType> &batch) {
+  using Operation = typename WriteBatch<KeyType, ValueType>::Operation;
+  std::vector<Operation> operations = batch.GetOperations();
+  std::stable_sort(operations.begin(), operations.end(),
+                   [](const Operation &a, const Operation &b) { return a.key < b.key; });
+  // Of the operations on a key, the last one added is kept.
+  size_t count = 0;
+  for (const auto &operation : operations) {
+    if (count > 0 && operations[count - 1].key == operation.key) {
+      operations[count - 1] = operation;
+    } else {
+      operations[count++] = operation;
+    }
+  }
+  operations.resize(count);
+
+  std::shared_lock<std::shared_mutex> structure_lock(structure_latch_, std::defer_lock);
+  std::vector<page_id_t> path;  // only a split needs the path
+  std::vector<MappingType> inserts;
+  std::vector<KeyType> deletes;
+  size_t next = 0;
+  while (next < operations.size()) {
+    bool split = structure_lock.owns_lock();
+    auto leaf_page = FindLeafPageBLink<WritePageGuard>(operations[next].key, false, split ? &path : nullptr, split);
+    if (!leaf_page) {
+      // Deletes do nothing on an empty tree, the first put starts it.
+      std::lock_guard<std::mutex> root_lock(root_mutex);
+      if (IsEmpty()) {
+        if (!operations[next].is_delete) {
+          StartNewTree(operations[next].key, operations[next].value);  // root_mutex held throughout the call
+        }
+        next++;
+      }
+      continue;
+    }
+    auto leaf_node = leaf_page.template As<LeafPage>();
+
+    // Puts of existing keys are applied at once, new keys and deletes are counted against the size of the
+    // leaf and applied after the loop, one pass over the leaf for each.
+    bool needs_split = false;
+    bool needs_merge = false;
+    int size = leaf_node->GetSize();
+    inserts.clear();
+    deletes.clear();
+    for (; next < operations.size() && !leaf_node->IsPastHighKey(operations[next].key); ++next) {
+      const Operation &operation = operations[next];
+      if (operation.is_delete) {
+        if (!leaf_node->Lookup(operation.key, nullptr)) {
+          continue;
+        }
+        if (size <= minSize(leaf_node)) {
+          needs_merge = true;
+          break;
+        }
+        deletes.push_back(operation.key);
+        size--;
+      } else if (leaf_node->Update(operation.key, operation.value)) {
+        leaf_page.SetDirty();
+      } else if (size < maxSize(leaf_node)) {
+        inserts.emplace_back(operation.key, operation.value);
+        size++;
+      } else {
+        needs_split = true;
+        break;
+      }
+    }
+    if (!deletes.empty() || !inserts.empty()) {
+      leaf_node->RemoveAll(deletes.data(), static_cast<int>(deletes.size()));
+      leaf_node->InsertAll(inserts.data(), static_cast<int>(inserts.size()));
+      leaf_page.SetDirty();
     }
 
-    buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);  // unpin parent
+    if (needs_split && !split) {
+      leaf_page.Drop();
+      insert_restarts_.fetch_add(1, std::memory_order_relaxed);
+      structure_lock.lock();
+      continue;
+    }
+    if (needs_split) {
+      const Operation &operation = operations[next++];
+      bool append_split = leaf_node->GetNextPageId() == INVALID_PAGE_ID &&
+                          leaf_node->KeyAt(leaf_node->GetSize() - 1) < operation.key;
+      leaf_node->Insert(operation.key, operation.value);
+      leaf_page.SetDirty();
+      auto new_leaf_page = Split(leaf_node, append_split);  // pinned
+      KeyType separator = new_leaf_page.template As<LeafPage>()->KeyAt(0);
+      page_id_t new_page_id = new_leaf_page.PageId();
+      page_id_t leaf_page_id = leaf_page.PageId();
+      leaf_page.Drop();
+      new_leaf_page.Drop();
+      InsertIntoParent(leaf_page_id, separator, new_page_id, &path);
+    }
+    leaf_page.Drop();
+    if (structure_lock.owns_lock()) {
+      structure_lock.unlock();
+      path.clear();
+    }
+    if (needs_merge) {
+      Remove(operations[next++].key);
+    }
   }
 }
 
@@ -304,44 +1037,57 @@ void BPLUSTREE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BP
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ *
+ * The pages latched by a merge are held by a LatchContext on the stack, removes do not use transaction.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE::Remove(const KeyType &key, Transaction *transaction) {
+void BPLUSTREE::Remove(const KeyType &key, Transaction * /*transaction*/) {
   if (IsEmpty()) {
     throw std::runtime_error("Empty tree");
   }
 
-  bool allocated = false;
-  if (transaction == nullptr) {
-    transaction = new Transaction(0);
-    allocated = true;
+  // A remove that leaves the leaf at least half full changes no other page, it latches the leaf only.
+  auto optimistic_page = FindLeafPageBLink<WritePageGuard>(key, false, nullptr, false);
+  if (!optimistic_page) {
+    return;  // emptied meanwhile
+  }
+  auto optimistic_node = optimistic_page.template As<LeafPage>();
+  if (optimistic_node->GetSize() > minSize(optimistic_node) || !optimistic_node->Lookup(key, nullptr)) {
+    int size = optimistic_node->GetSize();
+    if (optimistic_node->RemoveAndDeleteRecord(key) != size) {
+      optimistic_page.SetDirty();
+    }
+    return;
   }
+  optimistic_page.Drop();
 
-  std::unique_lock root_lock(root_mutex);                                    // locked, guaranteed unlock before return
-  auto leaf_page = FindLeafPageRW(key, false, OpType::Remove, transaction);  // leaf_page pinned, page(s) latched
+  // Merges and redistributions latch-crab from the root, with no split half done, see BPlusTree.
+  std::unique_lock<std::shared_mutex> structure_lock(structure_latch_);
+  std::unique_lock root_lock(root_mutex);  // locked, guaranteed unlock before return
+  if (IsEmpty()) {
+    return;
+  }
 
-  bool root_page_safe = transaction->GetPageSet()->front()->GetPageId() != root_page_id_;
+  LatchContext context;
+  LeafPage *leaf_node = FindLeafPageRW(key, false, OpType::Remove, &context);  // held by context
+
+  bool root_page_safe = context.FrontPage().PageId() != root_page_id_;
   if (root_page_safe) {
     root_lock.unlock();
   }
 
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
   page_id_t leaf_page_id = leaf_node->GetPageId();
 
   leaf_node->RemoveAndDeleteRecord(key);
 
   if (leaf_node->GetSize() < minSize(leaf_node)) {
-    bool delete_leaf = CoalesceOrRedistribute(leaf_node, transaction, key);  // leaf_page will be unpinned
+    bool delete_leaf = CoalesceOrRedistribute(leaf_node, &context);
     if (delete_leaf) {
-      buffer_pool_manager_->DeletePage(leaf_page_id);
+      context.AddDeletedPage(leaf_page_id);
     }
   }
 
-  UnlatchAndUnpin(OpType::Remove, transaction);
-
-  if (allocated) {
-    delete transaction;
-  }
+  UnlatchAndUnpin(&context);
 }
 
 /*
@@ -350,12 +1096,15 @@ void BPLUSTREE::Remove(const KeyType &key, Transaction *transaction) {
  * Using template N to represent either internal page or leaf page.
  * @return: true means target leaf page should be deleted, false means no deletion happens
  *
- * node will be unpinned if coalesce/redistribute succeeds.
+ * node stays pinned and latched, the pages of context are released by UnlatchAndUnpin. The siblings
+ * are released on return.
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE::CoalesceOrRedistribute(N *node, Transaction *txn, const KeyType &key) {
-  if (node->IsRootPage()) {
+bool BPLUSTREE::CoalesceOrRedistribute(N *node, LatchContext *context) {
+  // Parent page ids are written without the latch of the child, see InsertIntoParent, so they are not read
+  // here: removes exclude splits, root_page_id_ is stable, and the parent is taken from context.
+  if (node->GetPageId() == root_page_id_) {
     if (node->GetSize() <= 1) {
       // The root page might change if node's size <= 1:
       // when root is internal page, when size=1, its only child is promoted as the new root;
@@ -367,18 +1116,18 @@ bool BPLUSTREE::CoalesceOrRedistribute(N *node, Transaction *txn, const KeyType
       bool del_root = AdjustRoot(old_root);
 
       if (del_root) {
-        buffer_pool_manager_->UnpinPage(old_root->GetPageId(), true);
-        buffer_pool_manager_->DeletePage(old_root->GetPageId());
+        context->AddDeletedPage(old_root->GetPageId());
       }
     }
 
     return false;
   }
 
-  // parent is already latched
-  page_id_t parent_page_id = node->GetParentPageId();
-  auto parent_page = buffer_pool_manager_->FetchPage(parent_page_id);  // parent_page pinned
-  InternalPage *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  // An underfull page was not safe, so the descent kept its parent latched, right above it.
+  WritePageGuard *parent_page = context->PageAbove(node->GetPageId());
+  MINIKV_ASSERT(parent_page != nullptr, "the parent of an underfull page is held by the context");
+  page_id_t parent_page_id = parent_page->PageId();
+  InternalPage *parent = parent_page->template As<InternalPage>();
 
   int index_in_parent = parent->ValueIndex(node->GetPageId());
   int left_sib_index = index_in_parent - 1;
@@ -386,96 +1135,62 @@ bool BPLUSTREE::CoalesceOrRedistribute(N *node, Transaction *txn, const KeyType
 
   // Coalesce wth left sibling
   if (left_sib_index >= 0) {
-    int left_sib_page_id = parent->ValueAt(left_sib_index);
-    auto left_sib_page = buffer_pool_manager_->FetchPage(left_sib_page_id);  // left_sib_page pinned
-    left_sib_page->WLatch();
-    N *left_sib = reinterpret_cast<N *>(left_sib_page->GetData());
+    auto left_sib_page = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(left_sib_index));
+    N *left_sib = left_sib_page.template As<N>();
 
     if (fitOne(left_sib, node)) {
-      bool del_parent = Coalesce(&left_sib, &node, &parent, index_in_parent, txn);  // node unpinned and deleted
-
-      left_sib_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(parent_page_id, true);    // parent_page unpinned
-      buffer_pool_manager_->UnpinPage(left_sib_page_id, true);  // left_sib_page unpinned
+      bool del_parent = Coalesce(&left_sib, &node, &parent, index_in_parent, context);  // node deleted
+      left_sib_page.SetDirty();
+      parent_page->SetDirty();
       if (del_parent) {
-        buffer_pool_manager_->DeletePage(parent_page_id);
+        context->AddDeletedPage(parent_page_id);
       }
 
       return false;  // node is merged into left_sib, and already deleted
     }
-    left_sib_page->WUnlatch();
-
-    buffer_pool_manager_->UnpinPage(left_sib_page_id, false);  // left_sib_page unpinned
   }
 
   // Coalesce with right sibling
   if (right_sib_index < parent->GetSize()) {
-    int right_sib_page_id = parent->ValueAt(right_sib_index);
-    auto right_sib_page = buffer_pool_manager_->FetchPage(right_sib_page_id);  // right_sib_page pinned
-    right_sib_page->WLatch();
-    N *right_sib = reinterpret_cast<N *>(right_sib_page->GetData());
+    auto right_sib_page = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(right_sib_index));
+    N *right_sib = right_sib_page.template As<N>();
 
     if (fitOne(right_sib, node)) {
-      bool del_parent = Coalesce(&node, &right_sib, &parent, right_sib_index, txn);  // right_sib unpinned and deleted
-
-      right_sib_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(parent_page_id, true);     // parent_page unpinned
-      buffer_pool_manager_->UnpinPage(node->GetPageId(), true);  // node unpinned
+      bool del_parent = Coalesce(&node, &right_sib, &parent, right_sib_index, context);  // right_sib deleted
+      right_sib_page.SetDirty();
+      parent_page->SetDirty();
       if (del_parent) {
-        buffer_pool_manager_->DeletePage(parent_page_id);
+        context->AddDeletedPage(parent_page_id);
       }
 
       return false;  // right_sib is deleted, and node shouldn't be deleted
     }
-
-    right_sib_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(right_sib_page_id, false);  // right_sib_page unpinned
   }
 
   // Redistribute from left sibling
   if (left_sib_index >= 0) {
-    int left_sib_page_id = parent->ValueAt(left_sib_index);
-    auto left_sib_page = buffer_pool_manager_->FetchPage(left_sib_page_id);  // left_sib_page pinned
-    left_sib_page->WLatch();
-    N *left_sib = reinterpret_cast<N *>(left_sib_page->GetData());
+    auto left_sib_page = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(left_sib_index));
+    N *left_sib = left_sib_page.template As<N>();
 
     if (left_sib->GetSize() > minSize(left_sib)) {
-      // std::cout << strf("-(%d): borrow from page %d (l) to page %d\n", key, left_sib->GetPageId(),
-      // node->GetPageId());
-      Redistribute(left_sib, node, -1);  // Move left_sib's last key&value pair to the head of node
-
-      left_sib_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(parent_page_id, true);     // parent_page unpin
-      buffer_pool_manager_->UnpinPage(node->GetPageId(), true);  // node unpin
-      buffer_pool_manager_->UnpinPage(left_sib_page_id, true);   // left_sib_page unpin
+      Redistribute(left_sib, node, parent, -1);  // Move left_sib's last key&value pair to the head of node
+      left_sib_page.SetDirty();
+      parent_page->SetDirty();
       return false;
     }
-
-    left_sib_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(left_sib_page_id, false);  // left_sib_page unpinned
   }
 
   // Redistribute from right sibling
   if (right_sib_index < parent->GetSize()) {
-    int right_sib_page_id = parent->ValueAt(right_sib_index);
-    auto right_sib_page = buffer_pool_manager_->FetchPage(right_sib_page_id);  // right_sib_page pinned
-    right_sib_page->WLatch();
-    N *right_sib = reinterpret_cast<N *>(right_sib_page->GetData());
+    auto right_sib_page = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(right_sib_index));
+    N *right_sib = right_sib_page.template As<N>();
 
     if (right_sib->GetSize() > minSize(right_sib)) {
-      // std::cout << strf("-(%d): borrow from page %d (r) to page %d\n",key, right_sib->GetPageId(),
-      // node->GetPageId());
-      Redistribute(right_sib, node, 0);  // Move right_sib's first key&value pair to the head of node
-
-      right_sib_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(parent_page_id, true);     // parent_page unpin
-      buffer_pool_manager_->UnpinPage(node->GetPageId(), true);  // node unpin
-      buffer_pool_manager_->UnpinPage(right_sib_page_id, true);  // right_sib_page unpin
+      Redistribute(right_sib, node, parent, 0);  // Move right_sib's first key&value pair to the head of node
+      right_sib_page.SetDirty();
+      parent_page->SetDirty();
       return false;
     }
-
-    right_sib_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(right_sib_page_id, false);  // right_sib_page unpinned
   }
 
   throw std::runtime_error("Not root, cannot merge, cannot redistribute? This shouldn't happen");
@@ -494,13 +1209,14 @@ bool BPLUSTREE::CoalesceOrRedistribute(N *node, Transaction *txn, const KeyType
  * @return  true means parent node should be deleted, false means no deletion happens
  *
  * neighbor_node, node, and parent are assumed to be pinned.
- * Node will be merged into neighbor_node, so node will be unpinned and deleted.
- * This function doesn't operate on the buffer of neighbor_node and parent.
+ * Node will be merged into neighbor_node, so node is added to the deleted pages of context, it is deleted once
+ * the operation releases its latches.
+ * This function doesn't operate on the buffer of neighbor_node, node and parent.
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE::Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t> **parent, int index,
-                         Transaction *transaction) {
+                         LatchContext *context) {
   // Assume that *neighbor_node is the left sibling of *node
 
   // Move entries from node to neighbor_node
@@ -517,14 +1233,13 @@ bool BPLUSTREE::Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyT
     internal_node->MoveAllTo(internal_neighbor, (*parent)->KeyAt(index), buffer_pool_manager_);
   }
 
-  buffer_pool_manager_->UnpinPage((*node)->GetPageId(), true);
-  buffer_pool_manager_->DeletePage((*node)->GetPageId());
+  context->AddDeletedPage((*node)->GetPageId());
 
   (*parent)->Remove(index);
 
   // If parent is underfull, recursive operation
   if ((*parent)->GetSize() < minSize(*parent)) {
-    return CoalesceOrRedistribute(*parent, transaction, KeyType{});
+    return CoalesceOrRedistribute(*parent, context);
   }
 
   return false;
@@ -536,36 +1251,36 @@ bool BPLUSTREE::Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyT
  * otherwise move sibling page's last key & value pair into head of input
  * "node".
  * Using template N to represent either internal page or leaf page.
+ * The high key of the left page of the two follows the separator in the parent.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @param   parent             parent page of both, write latched by the caller
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE::Redistribute(N *neighbor_node, N *node, int index) {
+void BPLUSTREE::Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index) {
   // Assume neighbor_node and node are pinned
-  page_id_t parent_page_id = node->GetParentPageId();
-  auto parent_page = buffer_pool_manager_->FetchPage(parent_page_id);
 
   if (node->IsLeafPage()) {
     LeafPage *leaf_node = reinterpret_cast<LeafPage *>(node);
     LeafPage *leaf_neighbor = reinterpret_cast<LeafPage *>(neighbor_node);
-    InternalPage *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
 
     if (index == 0) {  // neighbor_node is the right sibling
       leaf_neighbor->MoveFirstToEndOf(leaf_node);
 
       int update_index = parent->ValueIndex(leaf_neighbor->GetPageId());
       parent->SetKeyAt(update_index, leaf_neighbor->KeyAt(0));
+      leaf_node->SetHighKey(leaf_neighbor->KeyAt(0));
     } else {  // neighbor_node is the left sibling
       leaf_neighbor->MoveLastToFrontOf(leaf_node);
 
       int update_index = parent->ValueIndex(leaf_node->GetPageId());
       parent->SetKeyAt(update_index, leaf_node->KeyAt(0));
+      leaf_neighbor->SetHighKey(leaf_node->KeyAt(0));
     }
   } else {
     InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
     InternalPage *internal_neighbor = reinterpret_cast<InternalPage *>(neighbor_node);
-    InternalPage *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
 
     if (index == 0) {  // neighbor_node is the right sibling
       KeyType middle_key = parent->KeyAt(parent->ValueIndex(internal_neighbor->GetPageId()));
@@ -573,12 +1288,14 @@ void BPLUSTREE::Redistribute(N *neighbor_node, N *node, int index) {
 
       int update_index = parent->ValueIndex(internal_neighbor->GetPageId());
       parent->SetKeyAt(update_index, internal_neighbor->KeyAt(0));
+      internal_node->SetHighKey(internal_neighbor->KeyAt(0));
     } else {  // neighbor_node is the left sibling
       KeyType middle_key = parent->KeyAt(parent->ValueIndex(internal_node->GetPageId()));
       internal_neighbor->MoveLastToFrontOf(internal_node, middle_key, buffer_pool_manager_);
 
       int update_index = parent->ValueIndex(internal_node->GetPageId());
       parent->SetKeyAt(update_index, internal_node->KeyAt(0));
+      internal_neighbor->SetHighKey(internal_node->KeyAt(0));
     }
   }
 }
@@ -609,10 +1326,7 @@ bool BPLUSTREE::AdjustRoot(BPlusTreePage *old_root_node) {
     root_page_id_ = new_root_page_id;
     UpdateRootPageId(0);
 
-    auto new_root_page = buffer_pool_manager_->FetchPage(new_root_page_id);
-    BPlusTreePage *new_root = reinterpret_cast<BPlusTreePage *>(new_root_page->GetData());
-    new_root->SetParentPageId(INVALID_PAGE_ID);
-    buffer_pool_manager_->UnpinPage(new_root_page_id, true);
+    SetParentPageId(new_root_page_id, INVALID_PAGE_ID);
 
     return true;
   }
@@ -634,10 +1348,10 @@ INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE::fitOne(N *node1, N *node2) {
   if (node1->IsLeafPage()) {
-    return node1->GetSize() + node2->GetSize() <= leaf_max_size_ - 1;
+    return static_cast<size_t>(node1->GetSize() + node2->GetSize()) <= leaf_max_size_ - 1;
   }
 
-  return node1->GetSize() + node2->GetSize() <= internal_max_size_;
+  return static_cast<size_t>(node1->GetSize() + node2->GetSize()) <= internal_max_size_;
 }
 
 /*
@@ -670,66 +1384,170 @@ bool BPLUSTREE::isSafe(N *node, enum OpType op) {
 
 /*
  * Find leaf page containing particular key.
- * It's similar to FindLeafPage, but with concurrency control for read/write operations.
+ * It's similar to FindLeafPage, but with concurrency control for write operations.
  *
- * Index iterator is not tested for concurrent access, so they use FindLeafPage.
- * Other read/write operations to the B+ tree should use this function, with concurrency control.
+ * Latch crabbing, for removes that may merge or redistribute, under structure_latch_ held exclusively: no
+ * split is half done, so every page is reached from its parent and right links need not be followed.
+ * Lookups, inserts and scans use FindLeafPageBLink.
  *
  * root_mutex is held throughout the call, to avoid deadlock.
  *
- * @param latched latched page ids. This is not needed if read_only = true.
+ * @param op Insert or Remove, a page safe for op releases the pages above it
+ * @return the leaf, write latched and held by context like the pages above it
  */
 INDEX_TEMPLATE_ARGUMENTS
-std::shared_ptr<Page> BPLUSTREE::FindLeafPageRW(const KeyType &key, bool left_most, enum OpType op,
-                                                Transaction *transaction) {
-  for (auto page = buffer_pool_manager_->FetchPage(root_page_id_);;) {
-    if (page == nullptr) {
+typename BPLUSTREE::LeafPage *BPLUSTREE::FindLeafPageRW(const KeyType &key, bool left_most, enum OpType op,
+                                                        LatchContext *context) {
+  for (page_id_t page_id = root_page_id_;;) {
+    auto page = buffer_pool_manager_->FetchPageWrite(page_id);
+    if (!page) {
       throw std::runtime_error("FetchPage returns nullptr");
     }
+    page.SetDirty();
 
-    BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
-
-    if (op == OpType::Read) {
-      page->RLatch();
-      UnlatchAndUnpin(op, transaction);
-    } else {
-      page->WLatch();
-      if (isSafe(node, op)) {
-        UnlatchAndUnpin(op, transaction);
-      }
+    BPlusTreePage *node = page.template As<BPlusTreePage>();
+    if (isSafe(node, op)) {
+      context->ReleasePages();
     }
-    transaction->AddIntoPageSet(page);
+    context->AddPage(std::move(page));
 
     if (node->IsLeafPage()) {
-      return page;  // pinned, latched
+      return reinterpret_cast<LeafPage *>(node);
     }
 
     InternalPage *internal = reinterpret_cast<InternalPage *>(node);
-    page_id_t child_page_id = left_most ? internal->ValueAt(0) : internal->Lookup(key);
-    page = buffer_pool_manager_->FetchPage(child_page_id);
+    page_id = left_most ? internal->ValueAt(0) : internal->Lookup(key);
   }
 }
 
-// Unlatch and unpin all pages in the PageSet of a transaction, according to the operation type.
+/*
+ * Find the leaf page containing key, or the left most leaf page, following the B-link protocol.
+ * Internal pages are read latched top-down and released as soon as their child is latched, a page whose
+ * high key is not greater than key was split since its parent was read, MoveRight follows its right link.
+ * The leaf is latched the way of LeafGuard, ReadPageGuard or WritePageGuard. A page is never latched before
+ * its type is known, the type of a pinned page does not change, so a child is pinned first and latched
+ * depending on its type. root_mutex is held until the root page is latched.
+ *
+ * @param path if not nullptr, set to the internal pages the descent went through, from the root down
+ * @param structure_held true if the caller holds structure_latch_
+ * @return the latched leaf page, an empty guard if the tree is empty
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE::UnlatchAndUnpin(enum OpType op, Transaction *transaction) const {
-  if (transaction == nullptr) {
-    return;
-  }
+template <typename LeafGuard>
+LeafGuard BPLUSTREE::FindLeafPageBLink(const KeyType &key, bool left_most, std::vector<page_id_t> *path,
+                                       bool structure_held) {
+  for (;;) {
+    if (path != nullptr) {
+      path->clear();
+    }
+    std::unique_lock root_lock(root_mutex);
+    if (root_page_id_ == INVALID_PAGE_ID) {
+      return LeafGuard();
+    }
+    auto root = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+    if (!root) {
+      throw std::runtime_error("FetchPage returns nullptr");
+    }
+    if (root.template As<BPlusTreePage>()->IsLeafPage()) {
+      LeafGuard leaf(std::move(root));
+      root_lock.unlock();
+      // The left most page of a level is never merged away and holds the smallest keys.
+      if (!left_most && !MoveRight(&leaf, key, structure_held)) {
+        continue;  // restart from the root
+      }
+      return leaf;
+    }
+    ReadPageGuard page(std::move(root));
+    root_lock.unlock();
 
-  auto pages = transaction->GetPageSet();
-  for (auto page : *pages) {
-    page_id_t page_id = page->GetPageId();
+    for (;;) {
+      if (!left_most && !MoveRight(&page, key, structure_held)) {
+        break;  // restart from the root
+      }
+      if (path != nullptr) {
+        path->push_back(page.PageId());
+      }
 
-    if (op == OpType::Read) {
-      page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page_id, false);
-    } else {
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page_id, true);
+      auto *internal = page.template As<InternalPage>();
+      auto child = buffer_pool_manager_->FetchPageBasic(left_most ? internal->ValueAt(0) : internal->Lookup(key));
+      if (!child) {
+        throw std::runtime_error("FetchPage returns nullptr");
+      }
+      if (child.template As<BPlusTreePage>()->IsLeafPage()) {
+        LeafGuard leaf(std::move(child));
+        page.Drop();
+        if (!left_most && !MoveRight(&leaf, key, structure_held)) {
+          break;
+        }
+        return leaf;
+      }
+      page = ReadPageGuard(std::move(child));  // latches the child, then releases the parent
     }
   }
-  pages->clear();
+}
+
+/*
+ * Move from page, latched, to the page of the same level whose key range holds key, following right
+ * links while key is not less than the high key. The right sibling is pinned before page is released, and
+ * latched after: merges latch a left sibling while holding the right one, so no two siblings are latched
+ * left to right. structure_latch_ held shared keeps the right sibling from being merged away in between,
+ * without it the latch is only tried, and the descent restarts if a merge holds it or waits for it.
+ *
+ * @param page ReadPageGuard or WritePageGuard, set to the page whose key range holds key
+ * @return false if page was released for a restart
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename Guard>
+bool BPLUSTREE::MoveRight(Guard *page, const KeyType &key, bool structure_held) {
+  while (IsPastHighKey(page->template As<BPlusTreePage>(), key)) {
+    std::shared_lock<std::shared_mutex> structure_lock(structure_latch_, std::defer_lock);
+    if (!structure_held && !structure_lock.try_lock()) {
+      page->Drop();
+      return false;
+    }
+    auto next = buffer_pool_manager_->FetchPageBasic(GetNextPageId(page->template As<BPlusTreePage>()));
+    page->Drop();
+    if (!next) {
+      throw std::runtime_error("FetchPage returns nullptr");
+    }
+    *page = Guard(std::move(next));
+    move_rights_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+/*
+ * Find the leaf page containing key, or the left most leaf page, for a range scan.
+ * Only the returned leaf is latched, see FindLeafPageBLink.
+ *
+ * @param[out] high_key smallest key the leaves after the returned leaf may hold, its high key
+ * @param[out] has_high_key false if the returned leaf is the last leaf
+ * @return pinned and read latched leaf page, nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE::FindLeafPageForScan(const KeyType &key, bool left_most, KeyType *high_key,
+                                             bool *has_high_key) {
+  auto page = FindLeafPageBLink<ReadPageGuard>(key, left_most, nullptr, false);
+  if (!page) {
+    *has_high_key = false;
+    return page;
+  }
+  auto *leaf = page.template As<LeafPage>();
+  *has_high_key = leaf->GetNextPageId() != INVALID_PAGE_ID;
+  *high_key = leaf->GetHighKey();
+  return page;
+}
+
+// Unlatch and unpin all pages held by context, then delete the pages it freed.
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE::UnlatchAndUnpin(LatchContext *context) const {
+  context->ReleasePages();
+
+  // Pages merged away are deleted once unlatched and unpinned, one a reader still pins on its last unpin.
+  for (size_t i = 0; i < context->GetDeletedPageCount(); ++i) {
+    buffer_pool_manager_->DeletePage(context->GetDeletedPage(i));
+  }
+  context->ClearDeletedPages();
 }
 
 /*
@@ -764,28 +1582,40 @@ int BPLUSTREE::maxSize(N *node) {
  * This is implemented for test purpose. You should use FindLeafPageRW.
  */
 INDEX_TEMPLATE_ARGUMENTS
-std::shared_ptr<Page> BPLUSTREE::FindLeafPage(const KeyType &key, bool leftMost) {
-  auto page = buffer_pool_manager_->FetchPage(root_page_id_);
-  BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+BasicPageGuard BPLUSTREE::FindLeafPage(const KeyType &key, bool leftMost) {
+  auto page = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+  BPlusTreePage *node = page.template As<BPlusTreePage>();
 
   while (!node->IsLeafPage()) {
     InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
     page_id_t next_page_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key);
 
-    auto next_page = buffer_pool_manager_->FetchPage(next_page_id);  // next_level_page pinned
-    BPlusTreePage *next_node = reinterpret_cast<BPlusTreePage *>(next_page->GetData());
-
-    buffer_pool_manager_->UnpinPage(node->GetPageId(), false);  // curr_node unpinned
-
-    page = next_page;
-    node = next_node;
+    page = buffer_pool_manager_->FetchPageBasic(next_page_id);  // next level pinned, current level unpinned
+    node = page.template As<BPlusTreePage>();
   }
 
   return page;  // pinned
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE::UpdateRootPageId(int insert_record) {}
+void BPLUSTREE::UpdateRootPageId(int insert_record) {
+  if (index_name_.empty()) {
+    return;
+  }
+  auto page = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  if (!page) {
+    throw std::runtime_error("out of memory");
+  }
+  page.SetDirty();
+  auto *header_page = page.template As<HeaderPage>();
+  // A tree emptied by Remove keeps its record, so a new first root updates it.
+  if (insert_record != 0 && header_page->InsertRecord(index_name_, root_page_id_, buffer_pool_manager_->GetPageSize())) {
+    return;
+  }
+  if (!header_page->UpdateRecord(index_name_, root_page_id_)) {
+    throw std::runtime_error("header page is full");
+  }
+}
 
 template class BPlusTree<key_t, value_t>;
 }  // namespace miniKV
@@ -17,17 +17,28 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
+#include <functional>
+#include <iterator>
 #include <queue>
+#include <shared_mutex>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Common/Config.h"
+#include "Concurrency/LatchContext.h"
 #include "Concurrency/Transaction.h"
+#include "Container/IndexIterator.h"
+#include "Container/WriteBatch.h"
 #include "Storage/BufferPool/BufferPoolManager.h"
 #include "Storage/Page/BPlusTreeInternalPage.h"
 #include "Storage/Page/BPlusTreeLeafPage.h"
 #include "Storage/Page/BPlusTreePage.h"
+#include "Storage/Page/HeaderPage.h"
 
 namespace miniKV {
 
@@ -42,17 +53,34 @@ namespace miniKV {
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency follows the B-link tree of Lehman and Yao. Every page has a high key and a right link to
+ * the next page of its level, and holds keys less than its high key. A split moves the upper half of a page
+ * to a new right sibling while holding the latch of that page only, then inserts the separator into the
+ * parent, latching one page at a time. Meanwhile the new page is reached through the right link: a descent
+ * landing on a page whose high key is not greater than its key moves right. Merges and redistributions
+ * latch-crab from the root holding structure_latch_ exclusively, splits hold it shared, so merges never
+ * see a split that has not reached the parent.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
+  friend class IndexIterator<KeyType, ValueType>;
+
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType>;
 
   enum class OpType { Read, Insert, Remove };
+  enum class OptimisticResult { Found, NotFound, Restart, Miss };
+  using BatchKey = std::pair<KeyType, size_t>;  // a key of a MultiGet batch and its index in the batch
 
  public:
-  explicit BPlusTree(std::shared_ptr<BufferPoolManager> buffer_pool_manager, size_t leaf_max_size = LEAF_PAGE_SIZE,
-                     size_t internal_max_size = INTERNAL_PAGE_SIZE);
+  // A max size of 0 fills the pages, their capacity is computed from the page size of the buffer pool.
+  explicit BPlusTree(std::shared_ptr<IBufferPoolManager> buffer_pool_manager, size_t leaf_max_size = 0,
+                     size_t internal_max_size = 0);
+
+  // A named tree records its root page id in the header page, which must exist, and reopens from it.
+  BPlusTree(std::string index_name, std::shared_ptr<IBufferPoolManager> buffer_pool_manager,
+            size_t leaf_max_size = 0, size_t internal_max_size = 0);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -60,12 +88,63 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   bool Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
-  // Remove a key and its value from this B+ tree.
+  // Insert a key-value pair, or set the value of key if it is in the tree already, in one descent.
+  // Returns true if the key was inserted.
+  bool Upsert(const KeyType &key, const ValueType &value);
+
+  // Set the value of key in place, under the write latch of its leaf, the tree is never split or merged.
+  // Returns false if the key is not in the tree.
+  bool Update(const KeyType &key, const ValueType &value);
+
+  /**
+   * Read-modify-write of key, like Upsert of merge(existing), where existing points to the value of key, or
+   * is nullptr if key is not in the tree. merge is called once, with the leaf of key write latched, so the
+   * merges of a key are serialized and counters lose no increments. merge must not use the tree.
+   * @return true if the key was inserted
+   */
+  bool Merge(const KeyType &key, const std::function<ValueType(const ValueType *)> &merge);
+
+  /**
+   * Apply the puts and deletes of batch, see WriteBatch. Operations are sorted by key and applied leaf by leaf,
+   * every leaf is write latched once for all the operations on its keys and split at most once per visit,
+   * see the implementation. The batch is not atomic, readers may see some of its operations and not others.
+   */
+  void Write(const WriteBatch<KeyType, ValueType> &batch);
+
+  // Remove a key and its value from this B+ tree, transaction is not used.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Return the value associated with a given key. Optimistic, see OptimisticGetValue, transaction is not
+  // used.
   bool GetValue(const KeyType &key, ValueType &value, Transaction *transaction = nullptr);
 
+  /**
+   * Look up a batch of keys, in any order. The batch is sorted and resolved in key order: a descent
+   * continues from the lowest page on the path of the previous key that still covers the next one, and
+   * the leaves of a group of keys are prefetched and searched in lockstep, so their cache misses overlap.
+   * Optimistic like GetValue, a leaf that keeps conflicting with writers is read latched once for all
+   * of its keys.
+   * @param values values[i] is set to the value of keys[i] if it is found
+   * @param found bitmap of count bits, bit i % 64 of found[i / 64] is set if keys[i] is found
+   * @return number of keys found
+   */
+  size_t MultiGet(const KeyType *keys, size_t count, ValueType *values, uint64_t *found);
+
+  // Iterator at the first entry, see IndexIterator for what a scan may see and latch.
+  IndexIterator<KeyType, ValueType> Begin();
+
+  // Iterator at the first entry whose key is not less than key.
+  IndexIterator<KeyType, ValueType> Begin(const KeyType &key);
+
+  // Iterator past the last entry.
+  IndexIterator<KeyType, ValueType> End();
+
+  // Number of inserts that found a full leaf and restarted holding structure_latch_ to split it.
+  uint64_t GetInsertRestarts() const { return insert_restarts_.load(std::memory_order_relaxed); }
+
+  // Number of times a latched descent followed a right link, to a page split since its parent was read.
+  uint64_t GetMoveRights() const { return move_rights_.load(std::memory_order_relaxed); }
+
   //        void Draw(std::shared_ptr<BufferPoolManager> bpm, const std::string &outf) {
   //            std::ofstream out(outf);
   //            out << "digraph G {" << std::endl;
@@ -74,6 +153,33 @@ class BPlusTree {
   //            out.close();
   //        }
 
+  /**
+   * Build this tree from entries sorted by strictly increasing key, the tree must be empty.
+   * Leaves are filled left to right to fill_factor of their capacity, and internal levels are built
+   * bottom-up along the way, so there is no descent per key and every page is written once.
+   * @param first, last range of std::pair<KeyType, ValueType>, iterated twice
+   * @throw std::runtime_error if the tree is not empty or the keys are not strictly increasing
+   */
+  template <typename Iterator>
+  void BulkLoad(Iterator first, Iterator last, double fill_factor = BULK_LOAD_FILL_FACTOR) {
+    if (std::adjacent_find(first, last, [](const auto &a, const auto &b) { return !(a.first < b.first); }) != last) {
+      throw std::runtime_error("BulkLoad: keys are not strictly increasing");
+    }
+    auto next = [&first](KeyType *key, ValueType *value) {
+      *key = first->first;
+      *value = first->second;
+      ++first;
+    };
+    BulkLoad(static_cast<size_t>(std::distance(first, last)), next, fill_factor);
+  }
+
+  /**
+   * Build this tree from count entries returned by next, the tree must be empty.
+   * The caller guarantees that next returns strictly increasing keys.
+   */
+  void BulkLoad(size_t count, const std::function<void(KeyType *, ValueType *)> &next,
+                double fill_factor = BULK_LOAD_FILL_FACTOR);
+
   // read data from file and insert one by one
   void InsertFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
@@ -85,30 +191,49 @@ class BPlusTree {
 
  private:
   // expose for test purpose
-  std::shared_ptr<Page> FindLeafPage(const KeyType &key, bool leftMost = false);
+  BasicPageGuard FindLeafPage(const KeyType &key, bool leftMost = false);
 
   void StartNewTree(const KeyType &key, const ValueType &value);
 
-  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+  template <typename ValueOf>
+  bool InsertIntoLeaf(const KeyType &key, ValueOf &&value_of);
+
+  ValueType *FindExisting(LeafPage *leaf, const KeyType &key, bool *append);
 
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+  void InsertIntoParent(page_id_t left_page_id, const KeyType &separator, page_id_t right_page_id,
+                        std::vector<page_id_t> *path);
+
+  page_id_t GetParentPageId(page_id_t page_id);
+  void SetParentPageId(page_id_t page_id, page_id_t parent_page_id);
 
   template <typename N>
-  N *Split(N *node);
+  BasicPageGuard Split(N *node, bool last_only = false);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *txn, const KeyType &key);
+  bool CoalesceOrRedistribute(N *node, LatchContext *context);
 
   template <typename N>
   bool Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t> **parent, int index,
-                Transaction *transaction = nullptr);
+                LatchContext *context);
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, int index);
+  void Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index);
 
   bool AdjustRoot(BPlusTreePage *node);
 
+  // One level of a tree being bulk loaded, its entries are spread evenly over its nodes.
+  struct BulkLevel {
+    size_t entries = 0;          // entries of the level, keys for leaves, children for internal pages
+    size_t nodes = 0;            // nodes of the level
+    size_t started = 0;          // nodes started so far
+    size_t target = 0;           // entries of the node being filled
+    BasicPageGuard page{};       // node being filled, pinned
+  };
+
+  // Unpin the node being filled at a level and start its next one, whose first key is key.
+  void StartBulkNode(std::vector<BulkLevel> *levels, size_t level, const KeyType &key);
+
+  // Record root_page_id_ in the header page, insert_record is 1 when the tree gets its first root.
   void UpdateRootPageId(int insert_record = 0);
 
   //        void ToGraph(BPlusTreePage *page, std::shared_ptr<BufferPoolManager> bpm, std::ofstream &out) const;
@@ -118,8 +243,38 @@ class BPlusTree {
   // Safe ToString, without affecting the behavior of the buffer pool manager.
   //        void SafeToString(BPlusTreePage *page, std::shared_ptr<BufferPoolManager> bpm) const;
 
+  // GetValue without latches and pins, Restart if a page changed while it was read, Miss if a page is not in
+  // the buffer pool.
+  OptimisticResult OptimisticGetValue(const KeyType &key, ValueType *value);
+
+  // MultiGet of the keys of batch from batch[*next], sorted, without latches and pins. *next is advanced past
+  // the keys resolved, Found once all are.
+  OptimisticResult OptimisticMultiGet(const BatchKey *batch, size_t count, size_t *next, ValueType *values,
+                                      uint64_t *found);
+
+  // OptimisticMultiGet of up to MULTI_GET_GROUP keys from batch[*next] landing on leaves that are children of
+  // parent, read at parent_version. Found if all of them are resolved, *next is advanced past those that are.
+  OptimisticResult OptimisticMultiGetGroup(const BatchKey *batch, size_t count, size_t *next, Page *parent,
+                                           uint64_t parent_version, ValueType *values, uint64_t *found);
+
+  // MultiGet of batch[next] and the keys after it on the same leaf, under one read latch.
+  // @return the index in batch of the first key not resolved
+  size_t LatchedMultiGet(const BatchKey *batch, size_t count, size_t next, ValueType *values, uint64_t *found);
+
   // Similar to FindLeafPage, but with concurrency control
-  std::shared_ptr<Page> FindLeafPageRW(const KeyType &key, bool left_most, enum OpType op, Transaction *transaction);
+  LeafPage *FindLeafPageRW(const KeyType &key, bool left_most, enum OpType op, LatchContext *context);
+
+  // Latched leaf, the internal pages above it are only read latched one at a time.
+  template <typename LeafGuard>
+  LeafGuard FindLeafPageBLink(const KeyType &key, bool left_most, std::vector<page_id_t> *path,
+                              bool structure_held);
+
+  // Follow right links from page to the page holding key.
+  template <typename Guard>
+  bool MoveRight(Guard *page, const KeyType &key, bool structure_held);
+
+  // Read latched leaf for IndexIterator, and the key starting the leaf after it.
+  ReadPageGuard FindLeafPageForScan(const KeyType &key, bool left_most, KeyType *high_key, bool *has_high_key);
 
   template <typename N>
   bool fitOne(N *node1, N *node2);
@@ -133,13 +288,34 @@ class BPlusTree {
   template <typename N>
   bool isSafe(N *node, enum OpType op);
 
-  void UnlatchAndUnpin(enum OpType op, Transaction *transaction) const;
-
-  page_id_t root_page_id_;  // acquire root_mutex before r/w root_page_id
-  std::mutex root_mutex;    // protect root_page_id
-  std::shared_ptr<BufferPoolManager> buffer_pool_manager_;
+  void UnlatchAndUnpin(LatchContext *context) const;
+
+  static const BPlusTreePage *AsTreePage(Page *page) {
+    return reinterpret_cast<const BPlusTreePage *>(page->GetData());
+  }
+
+  // Right link fields of a leaf or internal page.
+  static bool IsPastHighKey(const BPlusTreePage *node, const KeyType &key) {
+    return node->IsLeafPage() ? reinterpret_cast<const LeafPage *>(node)->IsPastHighKey(key)
+                              : reinterpret_cast<const InternalPage *>(node)->IsPastHighKey(key);
+  }
+  static page_id_t GetNextPageId(const BPlusTreePage *node) {
+    return node->IsLeafPage() ? reinterpret_cast<const LeafPage *>(node)->GetNextPageId()
+                              : reinterpret_cast<const InternalPage *>(node)->GetNextPageId();
+  }
+
+  // Acquire root_mutex before changing root_page_id_, or reading it to latch the root. Optimistic readers
+  // read it without the mutex, so a new root is written out before its id is stored.
+  std::atomic<page_id_t> root_page_id_;
+  std::mutex root_mutex;  // protect root_page_id
+  std::shared_ptr<IBufferPoolManager> buffer_pool_manager_;
   size_t leaf_max_size_;
   size_t internal_max_size_;
+  std::string index_name_;  // name of the header page record, empty if the root is not recorded
+  // Held shared by splits from the leaf to the last parent they change, exclusively by merges.
+  std::shared_mutex structure_latch_;
+  std::atomic<uint64_t> insert_restarts_{0};
+  std::atomic<uint64_t> move_rights_{0};
 };
 
 }  // namespace miniKV
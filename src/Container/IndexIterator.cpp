@@ -0,0 +1,85 @@
+#include "Container/IndexIterator.h"
+
+#include <utility>
+
+#include "Container/BPlusTree.h"
+
+namespace miniKV {
+
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeyType, ValueType>::IndexIterator(BPlusTree<KeyType, ValueType> *tree_, bool left_most,
+                                                 const KeyType &key)
+    : tree(tree_) {
+  page = tree->FindLeafPageForScan(key, left_most, &high_key, &has_high_key);
+  if (!page) {
+    return;  // empty tree
+  }
+  leaf = page.As<LeafPage>();
+  index = left_most ? 0 : leaf->KeyIndex(key);
+  if (index == leaf->GetSize()) {
+    NextLeaf(key, true);
+  }
+  LoadItem();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeyType, ValueType> &IndexIterator<KeyType, ValueType>::operator=(IndexIterator &&other) noexcept {
+  if (this != &other) {
+    Release();
+    tree = other.tree;
+    page = std::move(other.page);
+    leaf = other.leaf;
+    index = other.index;
+    item = other.item;
+    high_key = other.high_key;
+    has_high_key = other.has_high_key;
+    other.leaf = nullptr;
+    other.index = 0;
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+IndexIterator<KeyType, ValueType> &IndexIterator<KeyType, ValueType>::operator++() {
+  if (++index == leaf->GetSize()) {
+    NextLeaf(leaf->KeyAt(index - 1), false);
+  }
+  LoadItem();
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void IndexIterator<KeyType, ValueType>::NextLeaf(const KeyType &bound_, bool inclusive) {
+  // bound may refer to the leaf being released.
+  KeyType bound = bound_;
+  while (has_high_key) {
+    KeyType key = high_key;
+    Release();
+    page = tree->FindLeafPageForScan(key, false, &high_key, &has_high_key);
+    if (!page) {
+      return;  // the tree was emptied
+    }
+    leaf = page.As<LeafPage>();
+
+    // The leaf starts at key unless a merge moved entries, check every entry after bound.
+    index = leaf->KeyIndex(bound);
+    if (!inclusive && index < leaf->GetSize() && leaf->KeyAt(index) == bound) {
+      index++;
+    }
+    if (index < leaf->GetSize()) {
+      return;
+    }
+  }
+  Release();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void IndexIterator<KeyType, ValueType>::Release() {
+  page.Drop();
+  leaf = nullptr;
+  index = 0;
+}
+
+template class IndexIterator<key_t, value_t>;
+
+}  // namespace miniKV
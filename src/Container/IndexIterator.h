@@ -0,0 +1,87 @@
+#ifndef MINIKV_INDEXITERATOR_H
+#define MINIKV_INDEXITERATOR_H
+
+#include <memory>
+
+#include "Common/Macros.h"
+#include "Storage/Page/BPlusTreeLeafPage.h"
+#include "Storage/BufferPool/PageGuard.h"
+
+namespace miniKV {
+
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree;
+
+/**
+ * Iterator over the entries of a BPlusTree in key order, for range scans.
+ *
+ * The iterator pins and read latches the leaf of its current entry, and no other page, so a scan holds
+ * one leaf latch at a time. To step past a leaf, it releases the leaf and descends again to the leaf
+ * starting at the high key of the released one, skipping keys it already returned. Following the
+ * next page id of the released leaf instead would be unsafe: the next leaf may be merged away, and its
+ * page reused, or lend entries to the released leaf before the iterator gets there.
+ * Entries present for the whole scan are returned once, concurrent inserts and removes may or may not
+ * be seen.
+ *
+ * A thread holding an iterator that is not at the end must not modify the tree, nor open a second
+ * iterator, it would wait for the latch held by the first one.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType>;
+
+ public:
+  // The end iterator.
+  IndexIterator() = default;
+
+  /**
+   * Iterator at the first entry of tree, or at the first entry whose key is not less than key.
+   * @param left_most true to start at the first entry, key is ignored then
+   */
+  IndexIterator(BPlusTree<KeyType, ValueType> *tree, bool left_most, const KeyType &key);
+
+  ~IndexIterator() { Release(); }
+
+  IndexIterator(IndexIterator &&other) noexcept { *this = std::move(other); }
+  IndexIterator &operator=(IndexIterator &&other) noexcept;
+  DISALLOW_COPY(IndexIterator);
+
+  bool IsEnd() const { return !page; }
+
+  const MappingType &operator*() const { return item; }
+  const MappingType *operator->() const { return &item; }
+
+  IndexIterator &operator++();
+
+  bool operator==(const IndexIterator &other) const { return leaf == other.leaf && index == other.index; }
+  bool operator!=(const IndexIterator &other) const { return !(*this == other); }
+
+ private:
+  /**
+   * Move to the first entry after bound, or at bound if inclusive, in the leaves after the current one.
+   * Releases the current leaf, the iterator is at the end if there is no such entry.
+   */
+  void NextLeaf(const KeyType &bound, bool inclusive);
+
+  // Unlatch and unpin the current leaf, the iterator is at the end.
+  void Release();
+
+  // Copy the current entry into item, leaves store keys and values in separate arrays.
+  void LoadItem() {
+    if (page) {
+      item = leaf->GetItem(index);
+    }
+  }
+
+  BPlusTree<KeyType, ValueType> *tree = nullptr;
+  ReadPageGuard page;         // leaf of the current entry, empty at the end
+  const LeafPage *leaf = nullptr;
+  int index = 0;              // current entry in leaf
+  MappingType item{};         // copy of the current entry
+  KeyType high_key{};         // keys of the leaves after leaf are not less than high_key
+  bool has_high_key = false;  // false if leaf is the last leaf
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_INDEXITERATOR_H
@@ -0,0 +1,43 @@
+#ifndef MINIKV_WRITEBATCH_H
+#define MINIKV_WRITEBATCH_H
+
+#include <vector>
+
+#include "Storage/Page/BPlusTreePage.h"
+
+namespace miniKV {
+
+/**
+ * Puts and deletes collected to be applied to a BPlusTree together, see BPlusTree::Write. A put sets the
+ * value of its key, whether the key is in the tree or not, a delete of a key that is not in the tree does
+ * nothing. Of several operations on one key, the last one added is applied.
+ *
+ * A batch is only a list of operations, it latches nothing until it is written, and can be written again
+ * or cleared and reused.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class WriteBatch {
+ public:
+  struct Operation {
+    KeyType key;
+    ValueType value;  // unused by deletes
+    bool is_delete;
+  };
+
+  void Put(const KeyType &key, const ValueType &value) { operations.push_back({key, value, false}); }
+  void Delete(const KeyType &key) { operations.push_back({key, ValueType{}, true}); }
+
+  size_t Size() const { return operations.size(); }
+  bool IsEmpty() const { return operations.empty(); }
+  void Clear() { operations.clear(); }
+
+  /** @return the operations, in the order they were added */
+  const std::vector<Operation> &GetOperations() const { return operations; }
+
+ private:
+  std::vector<Operation> operations;
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_WRITEBATCH_H
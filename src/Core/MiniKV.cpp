@@ -4,12 +4,37 @@
 
 #include "Core/MiniKV.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "Storage/BufferPool/ParallelBufferPoolManager.h"
+#include "Util/ExternalSort.h"
+
 namespace miniKV {
 
-MiniKV::MiniKV()
-    : disk_manager(new DiskManager("miniKV.db")),
-      bpm(new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager)),
-      container(bpm) {}
+MiniKV::MiniKV(const std::string &db_file, const DatabaseOptions &options)
+    : disk_manager(new DiskManager(db_file, options)), bpm(OpenBufferPool(disk_manager)), container("miniKV", bpm) {}
+
+MiniKV::~MiniKV() { bpm->FlushAllPages(); }
+
+std::shared_ptr<IBufferPoolManager> MiniKV::OpenBufferPool(std::shared_ptr<DiskManager> disk_manager) {
+  bool new_database = disk_manager->GetNextPageId() == 0;
+  std::shared_ptr<IBufferPoolManager> bpm(new ParallelBufferPoolManager(
+      BUFFER_POOL_INSTANCES, std::max<size_t>(1, disk_manager->GetOptions().buffer_pool_size / BUFFER_POOL_INSTANCES),
+      disk_manager));
+  if (new_database) {
+    auto header_page = bpm->NewPage();
+    if (header_page == nullptr || header_page->GetPageId() != HEADER_PAGE_ID) {
+      throw std::runtime_error("can't create the header page");
+    }
+    reinterpret_cast<HeaderPage *>(header_page->GetData())->Init();
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+  }
+  return bpm;
+}
 
 value_t MiniKV::get(key_t key) {
   value_t value;
@@ -18,13 +43,75 @@ value_t MiniKV::get(key_t key) {
   return -1;
 }
 
+size_t MiniKV::multi_get(const key_t *keys, size_t count, value_t *values, uint64_t *found) {
+  size_t hits = container.MultiGet(keys, count, values, found);
+  for (size_t i = 0; i < count; ++i) {
+    if ((found[i / 64] >> (i % 64) & 1) == 0) {
+      values[i] = -1;
+    }
+  }
+  return hits;
+}
+
 bool MiniKV::insert(key_t key, value_t value) { return container.Insert(key, value); }
 
-bool MiniKV::update(key_t key, value_t value) { return container.Insert(key, value); }
+bool MiniKV::update(key_t key, value_t value) { return container.Upsert(key, value); }
+
+bool MiniKV::merge(key_t key, const std::function<value_t(const value_t *)> &fn) { return container.Merge(key, fn); }
 
 bool MiniKV::remove(key_t key) {
   container.Remove(key);
   return true;
 }
 
+void MiniKV::write(const WriteBatch<key_t, value_t> &batch) { container.Write(batch); }
+
+size_t MiniKV::range(key_t lo, key_t hi, std::pair<key_t, value_t> *buffer, size_t capacity) {
+  size_t count = 0;
+  if (capacity == 0) {
+    return 0;
+  }
+  for (auto it = container.Begin(lo); !it.IsEnd() && it->first <= hi; ++it) {
+    buffer[count++] = *it;
+    if (count == capacity) {
+      break;
+    }
+  }
+  return count;
+}
+
+size_t MiniKV::import(const std::string &data_file, size_t run_size) {
+  if (!container.IsEmpty()) {
+    throw std::runtime_error("import: the database is not empty");
+  }
+  FILE *file = fopen(data_file.c_str(), "rb");
+  if (file == nullptr) {
+    throw std::runtime_error("can't open " + data_file + ": " + strerror(errno));
+  }
+
+  // Records are packed, 12 bytes each.
+  constexpr size_t record_size = sizeof(key_t) + sizeof(value_t);
+  std::vector<char> block(record_size * 64 * 1024);
+  ExternalSorter sorter(data_file, run_size);
+  size_t read;
+  while ((read = fread(block.data(), record_size, block.size() / record_size, file)) > 0) {
+    for (size_t i = 0; i < read; ++i) {
+      key_t key;
+      value_t value;
+      memcpy(&key, block.data() + i * record_size, sizeof(key_t));
+      memcpy(&value, block.data() + i * record_size + sizeof(key_t), sizeof(value_t));
+      sorter.Add(key, value);
+    }
+  }
+  bool failed = ferror(file) != 0;
+  fclose(file);
+  if (failed) {
+    throw std::runtime_error("can't read " + data_file);
+  }
+
+  size_t count = sorter.Sort();
+  container.BulkLoad(count, [&sorter](key_t *key, value_t *value) { sorter.Next(key, value); });
+  return count;
+}
+
 }  // namespace miniKV
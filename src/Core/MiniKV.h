@@ -5,27 +5,87 @@
 #ifndef MINIKV_MINIKV_H
 #define MINIKV_MINIKV_H
 
+#include <functional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "Common/Config.h"
 #include "Container/BPlusTree.h"
-#include "Storage/BufferPool/BufferPoolManager.h"
+#include "Storage/BufferPool/IBufferPoolManager.h"
 
 namespace miniKV {
 
 class MiniKV {
  public:
-  MiniKV();
+  /**
+   * Open or create a database. An existing database is opened from its header page,
+   * without reading the tree.
+   * @param db_file path of the database file
+   * @param options page size and buffer pool size of the database, zero values keep the stored ones
+   */
+  explicit MiniKV(const std::string &db_file = "miniKV.db", const DatabaseOptions &options = DatabaseOptions());
+
+  /** Flush every page, so the database can be reopened. */
+  ~MiniKV();
 
   bool insert(key_t k, value_t v);
+
+  /**
+   * Set the value of k, inserting k if it is not in the database, with one descent of the tree, see
+   * BPlusTree::Upsert.
+   * @return true if k was inserted
+   */
   bool update(key_t k, value_t v);
+
+  /**
+   * Set the value of k to fn(existing) atomically, existing points to the value of k or is nullptr if k
+   * is not in the database, e.g. fn = [](const value_t *v) { return v ? *v + 1 : 1; } counts. See
+   * BPlusTree::Merge.
+   * @return true if k was inserted
+   */
+  bool merge(key_t k, const std::function<value_t(const value_t *)> &fn);
+
   bool remove(key_t);
   value_t get(key_t);
-  values range(key_t);
+
+  /**
+   * Look up count keys at once, faster than get for each of them, see BPlusTree::MultiGet. values[i] is
+   * the value of keys[i], or -1 like get if it is not found.
+   * @param found bitmap of count bits, bit i % 64 of found[i / 64] is set if keys[i] is found
+   * @return number of keys found
+   */
+  size_t multi_get(const key_t *keys, size_t count, value_t *values, uint64_t *found);
+
+  /**
+   * Apply the puts and deletes of batch, faster than one insert, update or remove per key, see
+   * BPlusTree::Write. A put sets the value of its key whether the key is in the database or not.
+   */
+  void write(const WriteBatch<key_t, value_t> &batch);
+
+  /**
+   * Copy the entries with lo <= key <= hi, in key order, into buffer, stopping after capacity entries.
+   * A range larger than the buffer is read in parts, calling range again from the last key copied + 1.
+   * Only one leaf is latched at a time, see IndexIterator.
+   * @return number of entries copied
+   */
+  size_t range(key_t lo, key_t hi, std::pair<key_t, value_t> *buffer, size_t capacity);
+
+  /**
+   * Load a database that is still empty from a file of records in any order, each an 8 byte key
+   * followed by a 4 byte value in native byte order. The records are sorted externally, in runs of
+   * run_size records, and the tree is bulk loaded. Of records with the same key, the first is kept.
+   * @return number of keys loaded
+   * @throw std::runtime_error if the database is not empty or the file cannot be read
+   */
+  size_t import(const std::string &data_file, size_t run_size = EXTERNAL_SORT_RUN_SIZE);
 
  private:
+  /** Create the buffer pool, and the header page when the database is new. */
+  static std::shared_ptr<IBufferPoolManager> OpenBufferPool(std::shared_ptr<DiskManager> disk_manager);
+
   std::shared_ptr<DiskManager> disk_manager;
-  std::shared_ptr<BufferPoolManager> bpm;
+  std::shared_ptr<IBufferPoolManager> bpm;
   BPlusTree<key_t, value_t> container;
 };
 
@@ -4,23 +4,65 @@
 
 #include "Storage/BufferPool/BufferPoolManager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 
+#include "Storage/BufferPool/ClockReplacer.h"
+#include "Storage/BufferPool/LRUKReplacer.h"
 #include "Storage/BufferPool/LRUReplaceer.h"
 
 namespace miniKV {
 
-BufferPoolManager::BufferPoolManager(size_t slot_num_, std::shared_ptr<DiskManager> disk_manager_)
-    : slot_num(slot_num_), disk_manager(disk_manager_) {
+BufferPoolManager::BufferPoolManager(size_t slot_num_, std::shared_ptr<DiskManager> disk_manager_,
+                                     ReplacerType replacer_type, bool async_io_, bool huge_pages)
+    : BufferPoolManager(slot_num_, 1, 0, disk_manager_, replacer_type, async_io_, huge_pages) {}
+
+BufferPoolManager::BufferPoolManager(size_t slot_num_, uint32_t num_instances_, uint32_t instance_index_,
+                                     std::shared_ptr<DiskManager> disk_manager_, ReplacerType replacer_type,
+                                     bool async_io_, bool huge_pages)
+    : slot_num(slot_num_),
+      num_instances(num_instances_),
+      instance_index(instance_index_),
+      disk_manager(disk_manager_),
+      frames(slot_num_, disk_manager_->GetPageSize(), huge_pages),
+      page_table(slot_num_),
+      async_io(async_io_) {
+  MINIKV_ASSERT(num_instances > 0, "a buffer pool has at least one instance");
+  MINIKV_ASSERT(instance_index < num_instances, "instance index out of range");
+
   for (int i = 0; i < slot_num; ++i) {
-    pages.push_back(std::shared_ptr<Page>(new Page));
+    pages.push_back(std::make_shared<Page>(frames.GetFrame(i), frames.GetPageSize()));
     free_list.push_back(i);
   }
 
-  replacer = std::make_unique<LRUReplacer>(slot_num);
+  switch (replacer_type) {
+    case ReplacerType::Clock:
+      replacer = std::make_unique<ClockReplacer>(slot_num);
+      break;
+    case ReplacerType::LRUK:
+      replacer = std::make_unique<LRUKReplacer>(slot_num);
+      break;
+    case ReplacerType::LRU:
+    default:
+      replacer = std::make_unique<LRUReplacer>(slot_num);
+      break;
+  }
 }
 
+BufferPoolManager::~BufferPoolManager() { StopPageCleaner(); }
+
 std::shared_ptr<Page> BufferPoolManager::FetchPage(page_id_t page_id) {
+  frame_id_t frame_id = FetchFrame(page_id);
+  return frame_id < 0 ? nullptr : pages[frame_id];
+}
+
+Page *BufferPoolManager::PinPage(page_id_t page_id) {
+  frame_id_t frame_id = FetchFrame(page_id);
+  return frame_id < 0 ? nullptr : pages[frame_id].get();
+}
+
+frame_id_t BufferPoolManager::FetchFrame(page_id_t page_id) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the
@@ -30,70 +72,126 @@ std::shared_ptr<Page> BufferPoolManager::FetchPage(page_id_t page_id) {
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then
   // return a pointer to P.
-  std::lock_guard<std::mutex> guard{latch};
 
-  if (page_table.count(page_id) != 0) {
-    frame_id_t frame_id = page_table[page_id];
-    auto page_ptr = pages.at(frame_id);
-    ++page_ptr->pin_count;
+  // Hit path, without the latch. Only misses and lost races fall through.
+  frame_id_t frame_id;
+  if (page_table.Find(page_id, &frame_id) && TryPin(frame_id, page_id)) {
+    replacer->RecordAccess(frame_id);
+    WaitForIO(pages[frame_id].get());
+    return frame_id;
+  }
+
+  std::unique_lock<std::mutex> guard{latch};
+
+  // The page on disk is stale until its write-back has landed.
+  for (auto writing = writing_back.find(page_id); writing != writing_back.end();
+       writing = writing_back.find(page_id)) {
+    auto written = writing->second;
+    guard.unlock();
+    written.wait();
+    guard.lock();
+  }
+
+  if (page_table.Find(page_id, &frame_id)) {
+    // Frames in the page table are never being evicted while the latch is held.
+    Page *page_ptr = pages[frame_id].get();
+    page_ptr->AddPin();
     replacer->Pin(frame_id);
-    return page_ptr;
+    replacer->RecordAccess(frame_id);
+    guard.unlock();
+    WaitForIO(page_ptr);
+    return frame_id;
   }
 
-  if (free_list.empty()) {
-    frame_id_t victimFrameId;
-    if (replacer->Victim(&victimFrameId)) {
-      auto page_ptr = pages.at(victimFrameId);
-      if (page_ptr->IsDirty()) {
-        disk_manager->WritePage(page_ptr->GetPageId(), page_ptr->GetData());
-      }
-      page_table.erase(page_ptr->page_id);
-      page_ptr->ResetMemory();
-      page_ptr->page_id = INVALID_PAGE_ID;
-      page_ptr->is_dirty = false;
-      free_list.emplace_back(victimFrameId);
-    } else {
-      // Can not find any victim frame in replacer.
-      return nullptr;
+  frame_id_t freeFrameID;
+  page_id_t victim_page_id = INVALID_PAGE_ID;
+  if (!FindFreeFrame(&freeFrameID, async_io ? &victim_page_id : nullptr)) {
+    // Can not find any victim frame in replacer.
+    return -1;
+  }
+
+  Page *page_ptr = pages[freeFrameID].get();
+  page_ptr->SetPinState(page_id, -1);
+  page_ptr->is_dirty.store(false, std::memory_order_release);
+  if (!async_io) {
+    try {
+      disk_manager->ReadPage(page_id, page_ptr->GetData());
+    } catch (...) {
+      ;
     }
+    // Publish the frame only after its content is loaded.
+    page_ptr->EndWrite();
+    page_ptr->SetPinState(page_id, 1);
+    replacer->Pin(freeFrameID);
+    replacer->RecordAccess(freeFrameID);
+    page_table.Insert(page_id, freeFrameID);
+    return freeFrameID;
   }
 
-  frame_id_t freeFrameID = free_list.back();
-  free_list.pop_back();
-  auto page_ptr = pages.at(freeFrameID);
-  ++page_ptr->pin_count;
-  page_ptr->page_id = page_id;
-  page_ptr->is_dirty = false;
+  // Publish the frame right away, threads hitting it wait in WaitForIO until it is loaded.
+  page_ptr->io_in_progress.store(true, std::memory_order_release);
+  page_ptr->SetPinState(page_id, 1);
   replacer->Pin(freeFrameID);
-  page_table[page_id] = freeFrameID;
+  replacer->RecordAccess(freeFrameID);
+  page_table.Insert(page_id, freeFrameID);
+  std::promise<void> written;
+  if (victim_page_id != INVALID_PAGE_ID) {
+    writing_back[victim_page_id] = written.get_future().share();
+  }
+  guard.unlock();
+
+  if (victim_page_id != INVALID_PAGE_ID) {
+    WriteBack(victim_page_id, page_ptr, &written);
+  }
   try {
-    disk_manager->ReadPage(page_id, page_ptr->GetData());
+    disk_manager->ReadPageAsync(page_id, page_ptr->GetData()).get();
   } catch (...) {
     ;
   }
-  return page_ptr;
-}  // namespace bustub
+  page_ptr->EndWrite();
+  FinishIO(page_ptr);
+  return freeFrameID;
+}
+
+Page *BufferPoolManager::PeekPage(page_id_t page_id) {
+  frame_id_t frame_id;
+  if (!page_table.Find(page_id, &frame_id)) {
+    return nullptr;
+  }
+  return pages[frame_id].get();
+}
 
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  std::lock_guard<std::mutex> guard{latch};
-  if (page_table.count(page_id) == 0) {
-    return false;
+  // The caller holds a pin, so the frame cannot be evicted under us; the page table
+  // lookup may still miss spuriously while an entry is shifted, then retry under the latch.
+  frame_id_t frame_id;
+  if (!page_table.Find(page_id, &frame_id) || pages[frame_id]->GetPageId() != page_id) {
+    std::lock_guard<std::mutex> guard{latch};
+    if (!page_table.Find(page_id, &frame_id)) {
+      return false;
+    }
   }
 
-  frame_id_t frame_id = page_table[page_id];
-  auto page_ptr = pages.at(frame_id);
+  auto &page_ptr = pages[frame_id];
   // If page is not dirty, set its state to new state
   // Or just skip new state
-  if (!page_ptr->is_dirty) {
-    page_ptr->is_dirty = is_dirty;
+  if (is_dirty) {
+    page_ptr->is_dirty.store(true, std::memory_order_release);
   }
 
-  if (page_ptr->pin_count <= 0) {
+  bool last = false;
+  if (!page_ptr->DropPin(page_id, &last)) {
     return false;
   }
-
-  if (--page_ptr->pin_count == 0) {
+  if (last) {
     replacer->Unpin(frame_id);
+    if (page_ptr->delete_pending.load()) {
+      // Eviction or another unpin may have deleted it meanwhile, or a pin come back.
+      std::lock_guard<std::mutex> guard{latch};
+      if (page_ptr->GetPageId() == page_id && page_ptr->delete_pending.load() && page_ptr->TryEvict()) {
+        RemovePage(frame_id, page_id);
+      }
+    }
   }
   return true;
 }
@@ -101,104 +199,303 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
   std::lock_guard<std::mutex> guard{latch};
   // If page is not in buffer
-  if (page_table.count(page_id) == 0) {
+  frame_id_t frame_id;
+  if (!page_table.Find(page_id, &frame_id)) {
     return false;
   }
 
-  frame_id_t frame_id = page_table[page_id];
-  auto page_ptr = pages.at(frame_id);
+  auto &page_ptr = pages[frame_id];
+  if (page_ptr->io_in_progress.load(std::memory_order_acquire)) {
+    return true;  // still being loaded, the page on disk is up to date
+  }
   disk_manager->WritePage(page_id, page_ptr->GetData());
-  page_ptr->is_dirty = false;
+  page_ptr->is_dirty.store(false, std::memory_order_release);
   return true;
 }
 
 std::shared_ptr<Page> BufferPoolManager::NewPage() {
+  frame_id_t frame_id = NewFrame();
+  return frame_id < 0 ? nullptr : pages[frame_id];
+}
+
+Page *BufferPoolManager::PinNewPage() {
+  frame_id_t frame_id = NewFrame();
+  return frame_id < 0 ? nullptr : pages[frame_id].get();
+}
+
+frame_id_t BufferPoolManager::NewFrame() {
   // 0.   Make sure you call DiskManager::AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always
   // pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::lock_guard<std::mutex> guard{latch};
+  std::unique_lock<std::mutex> guard{latch};
 
-  /*
-   * Free list is empty.
-   * Find a victim page from replacer, flush it to disk
-   */
-  if (free_list.empty()) {
-    if (replacer->Size() == 0) {
-      // There is no unpinned pages in replacer.
-      return nullptr;
-    }
-    frame_id_t victim_frame;
-    if (replacer->Victim(&victim_frame)) {
-      auto page_ptr = pages.at(victim_frame);
-      if (page_ptr->IsDirty()) {
-        disk_manager->WritePage(page_ptr->GetPageId(), page_ptr->GetData());
-      }
-      page_table.erase(page_ptr->GetPageId());
-      page_ptr->ResetMemory();
-      page_ptr->page_id = INVALID_PAGE_ID;
-      page_ptr->is_dirty = false;
-      free_list.push_back(victim_frame);
-    } else {
-      // Can not find any victim frame in replacer.
-      return nullptr;
-    }
+  frame_id_t free_frame;
+  page_id_t victim_page_id = INVALID_PAGE_ID;
+  if (!FindFreeFrame(&free_frame, async_io ? &victim_page_id : nullptr)) {
+    // There is no unpinned pages in replacer.
+    return -1;
   }
 
-  // At least one free frame in free_list here
-  frame_id_t free_frame = free_list.front();
-  auto freePage = pages.at(free_frame);
-  page_id_t newPageID = disk_manager->AllocatePage();
-  freePage->page_id = newPageID;
-  page_table[newPageID] = free_frame;
+  Page *freePage = pages[free_frame].get();
+  page_id_t newPageID = disk_manager->AllocatePage(num_instances, instance_index);
+  freePage->is_dirty.store(false, std::memory_order_release);
+  freePage->SetPinState(newPageID, 1);
   replacer->Pin(free_frame);
-  freePage->pin_count = 1;
-  freePage->is_dirty = false;
-  free_list.pop_front();
+  replacer->RecordAccess(free_frame);
+  page_table.Insert(newPageID, free_frame);
   //        LOG(INFO) << "Created a new page, page_id: " << freePage->page_id << std::endl ;
-  return freePage;
-}  // namespace bustub
+  if (victim_page_id != INVALID_PAGE_ID) {
+    freePage->io_in_progress.store(true, std::memory_order_release);
+    std::promise<void> written;
+    writing_back[victim_page_id] = written.get_future().share();
+    guard.unlock();
+    WriteBack(victim_page_id, freePage, &written);
+    freePage->ResetMemory();
+    freePage->EndWrite();
+    FinishIO(freePage);
+  } else {
+    freePage->EndWrite();
+  }
+  return free_frame;
+}
 
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
   // 0.   Make sure you call DiskManager::DeallocatePage!
   // 1.   Search the page table for the requested page (P).
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is
-  // using the page.
+  // using the page, P is deleted by its last unpin, or by its eviction.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its
   // metadata and return it to the free list.
   std::lock_guard<std::mutex> guard{latch};
 
-  if (page_table.count(page_id) == 0) {
+  frame_id_t frameId;
+  if (!page_table.Find(page_id, &frameId)) {
+    disk_manager->DeallocatePage(page_id);  // evicted, only its copy on disk is left
     return true;
   }
 
-  frame_id_t frameId = page_table[page_id];
-  auto page_ptr = pages.at(frameId);
-  if (page_ptr->GetPinCount() != 0) {
+  // The flag is set before the pin count is checked and UnpinPage checks it after dropping the pin,
+  // both sequentially consistent, so either the page is unpinned here or its last unpin sees the flag.
+  auto &page_ptr = pages[frameId];
+  page_ptr->delete_pending.store(true);
+  if (!page_ptr->TryEvict()) {
+    return false;
   }
+  RemovePage(frameId, page_id);
+  return true;
+}
 
+void BufferPoolManager::RemovePage(frame_id_t frame_id, page_id_t page_id) {
+  auto &page_ptr = pages[frame_id];
   disk_manager->DeallocatePage(page_id);
+  page_table.Erase(page_id);
+  page_ptr->BeginWrite();  // frames on the free list stay odd until they hold a page again
   page_ptr->ResetMemory();
-  page_ptr->is_dirty = false;
-  page_ptr->page_id = INVALID_PAGE_ID;
-  page_table.erase(page_id);
-  replacer->Unpin(frameId);
-  free_list.push_back(frameId);
-  return true;
+  page_ptr->is_dirty.store(false, std::memory_order_release);
+  page_ptr->delete_pending.store(false, std::memory_order_relaxed);
+  page_ptr->SetPinState(INVALID_PAGE_ID, -1);
+  replacer->Remove(frame_id);  // no longer a victim candidate
+  free_list.push_back(frame_id);
 }
 
 void BufferPoolManager::FlushAllPages() {
-  std::lock_guard<std::mutex> guard{latch};
-  for (auto item : page_table) {
-    page_id_t page_id = item.first;
-    frame_id_t frame_id = item.second;
-    auto page = pages.at(frame_id);
+  std::unique_lock<std::mutex> guard{latch};
+  page_table.ForEach([&](page_id_t page_id, frame_id_t frame_id) {
+    auto &page = pages[frame_id];
+    if (page->io_in_progress.load(std::memory_order_acquire)) {
+      return;
+    }
     disk_manager->WritePage(page_id, page->GetData());
-    page->is_dirty = false;
+    page->is_dirty.store(false, std::memory_order_release);
+  });
+
+  std::vector<std::shared_future<void>> pending;
+  for (auto &writing : writing_back) {
+    pending.push_back(writing.second);
+  }
+  guard.unlock();
+  for (auto &written : pending) {
+    written.wait();
+  }
+  disk_manager->Sync();
+}
+
+bool BufferPoolManager::TryPin(frame_id_t frame_id, page_id_t page_id) {
+  // The frame may have been reused for another page between the lookup and the pin, then it is left alone.
+  return pages[frame_id]->TryPin(page_id);
+}
+
+bool BufferPoolManager::FindFreeFrame(frame_id_t *frame_id, page_id_t *dirty_victim) {
+  if (!free_list.empty()) {
+    *frame_id = free_list.front();
+    free_list.pop_front();
+    return true;
+  }
+
+  /*
+   * Free list is empty.
+   * Find a victim page from replacer, flush it to disk
+   */
+  frame_id_t victim_frame;
+  while (replacer->Victim(&victim_frame)) {
+    auto &page_ptr = pages[victim_frame];
+    // A lock-free hit may have pinned the frame after it was handed to the replacer.
+    // It is dropped from the replacer here and comes back on its last unpin.
+    if (!page_ptr->TryEvict()) {
+      continue;
+    }
+    // Optimistic readers of the victim restart from here on, the frame is published again with its new page.
+    page_ptr->BeginWrite();
+    if (page_ptr->delete_pending.exchange(false)) {
+      // DeletePage found the victim pinned, it is deleted now instead of written back.
+      disk_manager->DeallocatePage(page_ptr->GetPageId());
+      page_ptr->is_dirty.store(false, std::memory_order_release);
+    }
+
+    if (page_ptr->IsDirty()) {
+      inline_flushes.fetch_add(1, std::memory_order_relaxed);
+      cleaner_cond.notify_one();
+    }
+    bool defer_write = dirty_victim != nullptr && page_ptr->IsDirty();
+    if (dirty_victim != nullptr) {
+      *dirty_victim = defer_write ? page_ptr->GetPageId() : INVALID_PAGE_ID;
+    }
+    if (page_ptr->IsDirty() && !defer_write) {
+      disk_manager->WritePage(page_ptr->GetPageId(), page_ptr->GetData());
+    }
+    page_table.Erase(page_ptr->GetPageId());
+    if (!defer_write) {
+      page_ptr->ResetMemory();
+    }
+    page_ptr->SetPinState(INVALID_PAGE_ID, -1);
+    page_ptr->is_dirty.store(false, std::memory_order_release);
+    *frame_id = victim_frame;
+    return true;
+  }
+  return false;
+}
+
+void BufferPoolManager::WriteBack(page_id_t victim_page_id, Page *frame, std::promise<void> *written) {
+  try {
+    disk_manager->WritePageAsync(victim_page_id, frame->GetData()).get();
+  } catch (std::exception &e) {
+    LOG(ERROR) << "write back of page " << victim_page_id << " failed: " << e.what();
+  }
+  {
+    std::lock_guard<std::mutex> guard{latch};
+    writing_back.erase(victim_page_id);
+  }
+  written->set_value();
+}
+
+void BufferPoolManager::WaitForIO(Page *page) {
+  if (!page->io_in_progress.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock{io_mutex};
+  io_cond.wait(lock, [page]() { return !page->io_in_progress.load(std::memory_order_acquire); });
+}
+
+void BufferPoolManager::FinishIO(Page *page) {
+  {
+    std::lock_guard<std::mutex> guard{io_mutex};
+    page->io_in_progress.store(false, std::memory_order_release);
+  }
+  io_cond.notify_all();
+}
+
+void BufferPoolManager::StartPageCleaner(int clean_percent) {
+  MINIKV_ASSERT(clean_percent >= 0 && clean_percent <= 100, "clean_percent is a percentage");
+  StopPageCleaner();
+  cleaner_stopping = false;
+  cleaner = std::thread([this, clean_percent]() { RunPageCleaner(clean_percent); });
+}
+
+void BufferPoolManager::StopPageCleaner() {
+  if (!cleaner.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard{cleaner_mutex};
+    cleaner_stopping = true;
+  }
+  cleaner_cond.notify_one();
+  cleaner.join();
+}
+
+void BufferPoolManager::RunPageCleaner(int clean_percent) {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{cleaner_mutex};
+      cleaner_cond.wait_for(lock, std::chrono::milliseconds(CLEANER_PERIOD_MS));
+      if (cleaner_stopping) {
+        return;
+      }
+    }
+
+    // Keep writing batches while the pool is short of clean frames.
+    bool failed = false;
+    std::vector<std::pair<page_id_t, frame_id_t>> batch;
+    while (!failed && !(batch = PickPagesToClean(clean_percent)).empty()) {
+      for (auto &[page_id, frame_id] : batch) {
+        auto &page_ptr = pages[frame_id];
+        // The read latch keeps writers out while the page is copied to disk. Writers that
+        // modified the page before mark it dirty again when they unpin it.
+        page_ptr->RLatch();
+        page_ptr->is_dirty.store(false, std::memory_order_release);
+        try {
+          disk_manager->WritePage(page_id, page_ptr->GetData());
+        } catch (std::exception &e) {
+          page_ptr->is_dirty.store(true, std::memory_order_release);
+          failed = true;
+          LOG(ERROR) << "page cleaner failed to write page " << page_id << ": " << e.what();
+        }
+        page_ptr->RUnlatch();
+        background_flushes.fetch_add(1, std::memory_order_relaxed);
+        UnpinPage(page_id, false);
+      }
+    }
+  }
+}
+
+std::vector<std::pair<page_id_t, frame_id_t>> BufferPoolManager::PickPagesToClean(int clean_percent) {
+  std::lock_guard<std::mutex> guard{latch};
+  size_t unpinned = free_list.size();
+  size_t clean = free_list.size();
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty;
+  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(slot_num); ++frame_id) {
+    auto &page_ptr = pages[frame_id];
+    if (page_ptr->GetPinCount() != 0 || page_ptr->io_in_progress.load(std::memory_order_acquire)) {
+      continue;
+    }
+    unpinned++;
+    if (page_ptr->IsDirty()) {
+      dirty.emplace_back(page_ptr->GetPageId(), frame_id);
+    } else {
+      clean++;
+    }
+  }
+
+  size_t target = (unpinned * clean_percent + 99) / 100;
+  size_t wanted = target > clean ? std::min<size_t>(target - clean, CLEANER_BATCH) : 0;
+  std::sort(dirty.begin(), dirty.end());
+  if (dirty.size() > wanted) {
+    dirty.resize(wanted);
+  }
+
+  // Pin the batch like a lock-free hit does, so the frames are not evicted while being written.
+  for (auto iter = dirty.begin(); iter != dirty.end();) {
+    if (TryPin(iter->second, iter->first)) {
+      ++iter;
+    } else {
+      iter = dirty.erase(iter);
+    }
   }
+  return dirty;
 }
 
 }  // namespace miniKV
\ No newline at end of file
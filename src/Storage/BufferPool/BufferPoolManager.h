@@ -5,40 +5,157 @@
 #ifndef MINIKV_BUFFERPOOLMANAGER_H
 #define MINIKV_BUFFERPOOLMANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <future>
 #include <list>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include "Common/Config.h"
+#include "Storage/BufferPool/FrameRegion.h"
+#include "Storage/BufferPool/IBufferPoolManager.h"
 #include "Storage/BufferPool/IReplacer.h"
+#include "Storage/BufferPool/PageTable.h"
 #include "Storage/Disk/DiskManager.h"
 #include "Storage/Page/Page.h"
 
 namespace miniKV {
-class BufferPoolManager {
+class BufferPoolManager : public IBufferPoolManager {
  public:
   BufferPoolManager() = default;
   /**
    * Create a new buffer pool manager.
-   * @param slot_num Number of pages in buffer, page size is defiend in src/Common/Config.h.
+   * @param slot_num Number of pages in buffer, the page size is the one of the database file.
    * @param disk_manager_ A buffer pool manager.
+   * @param replacer_type Replacement policy used to pick victim frames.
+   * @param async_io Read missed pages and write back victims without holding the latch.
+   * @param huge_pages Back the frames with huge pages.
    */
-  BufferPoolManager(size_t slot_num, std::shared_ptr<DiskManager> disk_manager_);
+  BufferPoolManager(size_t slot_num, std::shared_ptr<DiskManager> disk_manager_,
+                    ReplacerType replacer_type = ReplacerType::LRU, bool async_io = false, bool huge_pages = false);
 
-  std::shared_ptr<Page> FetchPage(miniKV::page_id_t page_id);
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
-  bool FlushPage(page_id_t page_id);
-  std::shared_ptr<Page> NewPage();
-  bool DeletePage(page_id_t page_id);
-  void FlushAllPages();
+  /**
+   * Create a buffer pool manager that is one shard of a ParallelBufferPoolManager.
+   * Page ids allocated by this instance satisfy page_id % num_instances == instance_index.
+   * @param slot_num Number of pages in this instance.
+   * @param num_instances Number of instances in the parallel buffer pool.
+   * @param instance_index Index of this instance in the parallel buffer pool.
+   * @param disk_manager_ The disk manager shared by all instances.
+   * @param replacer_type Replacement policy used to pick victim frames.
+   * @param async_io Read missed pages and write back victims without holding the latch.
+   * @param huge_pages Back the frames with huge pages.
+   */
+  BufferPoolManager(size_t slot_num, uint32_t num_instances, uint32_t instance_index,
+                    std::shared_ptr<DiskManager> disk_manager_, ReplacerType replacer_type = ReplacerType::LRU,
+                    bool async_io = false, bool huge_pages = false);
+
+  ~BufferPoolManager() override;
+
+  std::shared_ptr<Page> FetchPage(miniKV::page_id_t page_id) override;
+  Page *PinPage(page_id_t page_id) override;
+  Page *PeekPage(page_id_t page_id) override;
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+  bool FlushPage(page_id_t page_id) override;
+  std::shared_ptr<Page> NewPage() override;
+  Page *PinNewPage() override;
+  bool DeletePage(page_id_t page_id) override;
+  void FlushAllPages() override;
+  size_t GetPoolSize() const override { return slot_num; }
+  size_t GetPageSize() const override { return frames.GetPageSize(); }
+
+  /** @return the memory holding the frames */
+  const FrameRegion &GetFrameRegion() const { return frames; }
+
+  /**
+   * Start a background thread that writes dirty unpinned pages ahead of eviction, so that
+   * clean_percent of the unpinned frames stay clean and victims rarely need a write inline.
+   * Pages are written in batches sorted by page id.
+   */
+  void StartPageCleaner(int clean_percent = CLEANER_PERCENT);
+
+  /** Stop the page cleaner thread, if it runs. */
+  void StopPageCleaner();
+
+  /** @return number of dirty victims written back by the thread that needed their frame */
+  uint64_t GetInlineFlushes() const { return inline_flushes.load(std::memory_order_relaxed); }
+
+  /** @return number of pages written back by the page cleaner */
+  uint64_t GetBackgroundFlushes() const { return background_flushes.load(std::memory_order_relaxed); }
 
  private:
+  /** Fetch and pin a page, @return its frame, -1 if every frame is pinned */
+  frame_id_t FetchFrame(page_id_t page_id);
+
+  /** Create and pin a new page, @return its frame, -1 if every frame is pinned */
+  frame_id_t NewFrame();
+
+  /**
+   * Pin a frame found by a lock-free page table lookup.
+   * @return false if the frame is being evicted or no longer holds page_id
+   */
+  bool TryPin(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Deallocate the page held by a frame and put the frame on the free list, the latch must be held
+   * and the frame marked as being evicted by Page::TryEvict.
+   */
+  void RemovePage(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Take a frame from the free list, or evict an unpinned page, the latch must be held.
+   * @param[out] dirty_victim if not nullptr, a dirty victim is not written back and not cleared,
+   * its page id is returned here for WriteBack instead, INVALID_PAGE_ID otherwise
+   * @return false if every frame is pinned
+   */
+  bool FindFreeFrame(frame_id_t *frame_id, page_id_t *dirty_victim = nullptr);
+
+  /**
+   * Write a victim page still held by frame to disk, without the latch.
+   * Fetches of the victim page wait on written until the write has landed.
+   */
+  void WriteBack(page_id_t victim_page_id, Page *frame, std::promise<void> *written);
+
+  /** Wait until the I/O on a pinned page started by another thread has finished. */
+  void WaitForIO(Page *page);
+
+  /** Mark the I/O on a page finished and wake up the threads waiting for it. */
+  void FinishIO(Page *page);
+
+  /** Page cleaner thread body. */
+  void RunPageCleaner(int clean_percent);
+
+  /**
+   * Pick and pin the dirty unpinned frames the page cleaner writes next.
+   * @return (page id, frame id) pairs sorted by page id
+   */
+  std::vector<std::pair<page_id_t, frame_id_t>> PickPagesToClean(int clean_percent);
+
   std::size_t slot_num;
+  uint32_t num_instances = 1;
+  uint32_t instance_index = 0;
   std::shared_ptr<DiskManager> disk_manager;
   std::unique_ptr<IReplacer> replacer;
+  FrameRegion frames;  // one aligned region for all frames, so they can be used for O_DIRECT I/O
   std::vector<std::shared_ptr<Page>> pages;
   std::list<frame_id_t> free_list;
-  std::mutex latch;
-  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::mutex latch;  // serializes misses, page table updates and eviction
+  PageTable page_table;
+
+  // Async I/O mode: misses and write-backs run with the latch released while the frame
+  // is marked io_in_progress, threads hitting such a frame wait on io_cond.
+  bool async_io = false;
+  std::mutex io_mutex;
+  std::condition_variable io_cond;
+  std::unordered_map<page_id_t, std::shared_future<void>> writing_back;  // protected by latch
+
+  std::thread cleaner;
+  std::mutex cleaner_mutex;
+  std::condition_variable cleaner_cond;  // wakes the cleaner up early, when a victim was dirty
+  bool cleaner_stopping = false;         // protected by cleaner_mutex
+  std::atomic<uint64_t> inline_flushes{0};
+  std::atomic<uint64_t> background_flushes{0};
 };
 }  // namespace miniKV
 
@@ -0,0 +1,57 @@
+#include "Storage/BufferPool/ClockReplacer.h"
+
+namespace miniKV {
+
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_pages_(num_pages), states_(new std::atomic<uint8_t>[num_pages]) {
+  for (size_t i = 0; i < num_pages_; ++i) {
+    states_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  /*
+   * The first revolution may only clear reference bits, the second one then finds
+   * an unreferenced frame unless other threads keep referencing or pinning them.
+   */
+  for (size_t step = 0; step < 2 * num_pages_ + 1; ++step) {
+    if (size_.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+
+    size_t frame = hand_.fetch_add(1, std::memory_order_relaxed) % num_pages_;
+    auto &state = states_[frame];
+    uint8_t current = state.load(std::memory_order_acquire);
+    if ((current & IN_REPLACER) == 0) {
+      continue;
+    }
+    if ((current & REFERENCED) != 0) {
+      state.compare_exchange_strong(current, current & ~REFERENCED, std::memory_order_acq_rel);
+      continue;
+    }
+    if (state.compare_exchange_strong(current, 0, std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_acq_rel);
+      *frame_id = static_cast<frame_id_t>(frame);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  uint8_t old = states_[frame_id].fetch_and(static_cast<uint8_t>(~IN_REPLACER), std::memory_order_acq_rel);
+  if ((old & IN_REPLACER) != 0) {
+    size_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  uint8_t old = states_[frame_id].fetch_or(IN_REPLACER | REFERENCED, std::memory_order_acq_rel);
+  if ((old & IN_REPLACER) == 0) {
+    size_.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
+
+size_t ClockReplacer::Size() { return size_.load(std::memory_order_acquire); }
+
+}  // namespace miniKV
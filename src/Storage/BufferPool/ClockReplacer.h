@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "Common/Config.h"
+#include "Storage/BufferPool/IReplacer.h"
+
+namespace miniKV {
+
+/**
+ * ClockReplacer implements the clock (second chance) replacement policy.
+ * Every frame has a fixed state byte holding an "in replacer" bit and a reference bit,
+ * and the clock hand sweeps over frames clearing reference bits until it finds an
+ * unreferenced one. Nothing is allocated after construction and no mutex is taken.
+ */
+class ClockReplacer : public IReplacer {
+ public:
+  /**
+   * Create a new ClockReplacer.
+   * @param num_pages the maximum number of pages the ClockReplacer will be required to store
+   */
+  explicit ClockReplacer(size_t num_pages);
+
+  ~ClockReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  static constexpr uint8_t IN_REPLACER = 1;
+  static constexpr uint8_t REFERENCED = 2;
+
+  size_t num_pages_;
+  std::unique_ptr<std::atomic<uint8_t>[]> states_;
+  std::atomic<size_t> hand_{0};
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace miniKV
@@ -0,0 +1,38 @@
+#include "Storage/BufferPool/FrameRegion.h"
+
+#include <sys/mman.h>
+
+#include <new>
+
+namespace miniKV {
+
+static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+FrameRegion::FrameRegion(size_t num_frames, size_t page_size_, bool huge_pages)
+    : page_size(page_size_), size(num_frames * page_size_) {
+  void *ptr = MAP_FAILED;
+  if (huge_pages) {
+    size_t huge_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    ptr = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      size = huge_size;
+      huge_tlb = true;
+    }
+  }
+  if (ptr == MAP_FAILED) {
+    // No swap is reserved for the whole pool up front, like the per-frame allocations it replaced,
+    // so heuristic overcommit does not refuse a large pool that is never filled.
+    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptr == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    if (huge_pages) {
+      madvise(ptr, size, MADV_HUGEPAGE);
+    }
+  }
+  base = static_cast<char *>(ptr);
+}
+
+FrameRegion::~FrameRegion() { munmap(base, size); }
+
+}  // namespace miniKV
@@ -0,0 +1,48 @@
+#ifndef MINIKV_FRAMEREGION_H
+#define MINIKV_FRAMEREGION_H
+
+#include <cstddef>
+
+#include "Common/Config.h"
+
+namespace miniKV {
+
+/**
+ * FrameRegion is the memory of all frames of a buffer pool instance, a single anonymous
+ * mapping of num_frames * page_size zeroed bytes. Frames are page aligned, so they can be
+ * the buffers of O_DIRECT I/O, and memory is only committed when a frame is first used
+ * (MAP_NORESERVE, so the size of the pool is not checked against the overcommit limit).
+ *
+ * With huge_pages the region is backed by explicit huge pages (MAP_HUGETLB) when the system has
+ * enough of them reserved, and by transparent huge pages (MADV_HUGEPAGE) otherwise.
+ */
+class FrameRegion {
+ public:
+  FrameRegion(size_t num_frames, size_t page_size, bool huge_pages);
+  ~FrameRegion();
+
+  FrameRegion(const FrameRegion &) = delete;
+  FrameRegion &operator=(const FrameRegion &) = delete;
+
+  /** @return the first byte of a frame */
+  char *GetFrame(frame_id_t frame_id) const { return base + static_cast<size_t>(frame_id) * page_size; }
+
+  /** @return the size of a frame in bytes */
+  size_t GetPageSize() const { return page_size; }
+
+  /** @return the size of the mapping in bytes */
+  size_t GetSize() const { return size; }
+
+  /** @return true if the region is backed by explicit huge pages */
+  bool IsHugeTLB() const { return huge_tlb; }
+
+ private:
+  char *base = nullptr;
+  size_t page_size;
+  size_t size = 0;
+  bool huge_tlb = false;
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_FRAMEREGION_H
@@ -0,0 +1,103 @@
+#ifndef MINIKV_IBUFFERPOOLMANAGER_H
+#define MINIKV_IBUFFERPOOLMANAGER_H
+
+#include <memory>
+
+#include "Common/Config.h"
+#include "Storage/BufferPool/PageGuard.h"
+#include "Storage/Page/Page.h"
+
+namespace miniKV {
+
+/**
+ * IBufferPoolManager is the interface consumed by BPlusTree and MiniKV.
+ * It is implemented by a single BufferPoolManager and by ParallelBufferPoolManager,
+ * which shards pages over several BufferPoolManager instances.
+ */
+class IBufferPoolManager {
+ public:
+  IBufferPoolManager() = default;
+  virtual ~IBufferPoolManager() = default;
+
+  /**
+   * Fetch the requested page from the buffer pool, the page is pinned.
+   * @param page_id id of page to be fetched
+   * @return the requested page, nullptr if every frame is pinned
+   */
+  virtual std::shared_ptr<Page> FetchPage(page_id_t page_id) = 0;
+
+  /**
+   * Fetch the requested page like FetchPage, as the raw frame, which the buffer pool owns. Page guards pin
+   * pages this way, without the reference count of a shared_ptr.
+   * @return the frame holding the pinned page, nullptr if every frame is pinned
+   */
+  virtual Page *PinPage(page_id_t page_id) = 0;
+
+  /**
+   * Find the frame holding the requested page, without pinning it or recording the access, for
+   * optimistic readers. The frame may be evicted and reused at any time, so the caller checks the page id
+   * and validates the version of the frame, see Page::GetVersion.
+   * @param page_id id of page to be found
+   * @return the frame that held the page, nullptr if the page is not in the buffer pool
+   */
+  virtual Page *PeekPage(page_id_t page_id) = 0;
+
+  /**
+   * Unpin the target page from the buffer pool.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty) = 0;
+
+  /**
+   * Flush the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  virtual bool FlushPage(page_id_t page_id) = 0;
+
+  /**
+   * Create a new page in the buffer pool, the page is pinned.
+   * @return the new page, nullptr if every frame is pinned
+   */
+  virtual std::shared_ptr<Page> NewPage() = 0;
+
+  /**
+   * Create a new page like NewPage, as the raw frame, see PinPage.
+   * @return the frame holding the new pinned page, nullptr if every frame is pinned
+   */
+  virtual Page *PinNewPage() = 0;
+
+  /**
+   * Delete a page from the buffer pool. A pinned page is deleted once it is unpinned.
+   * @param page_id id of page to be deleted
+   * @return false if the page is pinned and its deletion deferred, true otherwise
+   */
+  virtual bool DeletePage(page_id_t page_id) = 0;
+
+  /** Flush all pages in the buffer pool to disk. */
+  virtual void FlushAllPages() = 0;
+
+  /** @return the total number of frames in the buffer pool */
+  virtual size_t GetPoolSize() const = 0;
+
+  /** @return the size of every page in bytes, set per database by the DiskManager */
+  virtual size_t GetPageSize() const = 0;
+
+  /** @return the pinned page, an empty guard if every frame is pinned */
+  BasicPageGuard FetchPageBasic(page_id_t page_id) { return BasicPageGuard(this, PinPage(page_id)); }
+
+  /** @return the pinned and read latched page, an empty guard if every frame is pinned */
+  ReadPageGuard FetchPageRead(page_id_t page_id) { return ReadPageGuard(FetchPageBasic(page_id)); }
+
+  /** @return the pinned and write latched page, an empty guard if every frame is pinned */
+  WritePageGuard FetchPageWrite(page_id_t page_id) { return WritePageGuard(FetchPageBasic(page_id)); }
+
+  /** @return the new pinned page, not latched, an empty guard if every frame is pinned */
+  BasicPageGuard NewPageGuarded() { return BasicPageGuard(this, PinNewPage()); }
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_IBUFFERPOOLMANAGER_H
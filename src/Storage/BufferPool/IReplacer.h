@@ -16,6 +16,9 @@
 
 namespace miniKV {
 
+/** Replacement policies a BufferPoolManager can be constructed with. */
+enum class ReplacerType { LRU, Clock, LRUK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,6 +46,19 @@ class IReplacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Records that the page held by a frame was accessed, called on every fetch, including
+   * buffer pool hits that do not go through Pin. Policies that only track recency ignore it.
+   * @param frame_id the id of the accessed frame
+   */
+  virtual void RecordAccess(frame_id_t /*frame_id*/) {}
+
+  /**
+   * Drops a frame whose page was deleted, together with any access history kept for it.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
@@ -0,0 +1,103 @@
+#include "Storage/BufferPool/LRUKReplacer.h"
+
+#include <algorithm>
+
+namespace miniKV {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_period)
+    : k_(k), correlated_period_(correlated_period), frames_(num_pages) {
+  MINIKV_ASSERT(k_ > 0, "LRU-K needs at least one reference per frame");
+  for (auto &frame : frames_) {
+    frame.references.resize(k_);
+  }
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard{lock_};
+  if (evictable_.empty()) {
+    return false;
+  }
+
+  // Skip frames whose next reference would still be correlated with their last one,
+  // at most correlated_period_ frames are in that state.
+  auto victim = evictable_.begin();
+  for (auto iter = evictable_.begin(); iter != evictable_.end(); ++iter) {
+    if (current_timestamp_ + 1 - frames_[iter->second].last_reference > correlated_period_) {
+      victim = iter;
+      break;
+    }
+  }
+
+  *frame_id = victim->second;
+  evictable_.erase(victim);
+  frames_[*frame_id] = FrameHistory{};
+  frames_[*frame_id].references.resize(k_);
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard{lock_};
+  auto &frame = frames_[frame_id];
+  if (frame.evictable) {
+    evictable_.erase({frame.key, frame_id});
+    frame.evictable = false;
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard{lock_};
+  auto &frame = frames_[frame_id];
+  if (!frame.evictable) {
+    frame.key = GetEvictionKey(frame);
+    evictable_.insert({frame.key, frame_id});
+    frame.evictable = true;
+  }
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard{lock_};
+  uint64_t now = ++current_timestamp_;
+  auto &frame = frames_[frame_id];
+  if (frame.num_references > 0 && now - frame.last_reference <= correlated_period_) {
+    // Move the history along with the correlated period, the most recent reference becomes this one.
+    uint64_t shift = now - frame.last_reference;
+    for (uint64_t i = 0; i < std::min<uint64_t>(frame.num_references, k_); ++i) {
+      frame.references[i] += shift;
+    }
+  } else {
+    frame.references[frame.num_references % k_] = now;
+    frame.num_references++;
+  }
+  frame.last_reference = now;
+  // Lock-free buffer pool hits record accesses on frames the replacer may still hold.
+  if (frame.evictable) {
+    evictable_.erase({frame.key, frame_id});
+    frame.key = GetEvictionKey(frame);
+    evictable_.insert({frame.key, frame_id});
+  }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard{lock_};
+  auto &frame = frames_[frame_id];
+  if (frame.evictable) {
+    evictable_.erase({frame.key, frame_id});
+  }
+  frame = FrameHistory{};
+  frame.references.resize(k_);
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> guard{lock_};
+  return evictable_.size();
+}
+
+LRUKReplacer::EvictionKey LRUKReplacer::GetEvictionKey(const FrameHistory &frame) const {
+  if (frame.num_references < k_) {
+    return {0, frame.last_reference};
+  }
+  // The ring slot written next holds the K-th most recent reference.
+  return {1, frame.references[frame.num_references % k_]};
+}
+
+}  // namespace miniKV
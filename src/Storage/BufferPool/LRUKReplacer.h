@@ -0,0 +1,75 @@
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "Common/Config.h"
+#include "Storage/BufferPool/IReplacer.h"
+
+namespace miniKV {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy (O'Neil et al., SIGMOD 1993).
+ *
+ * The victim is the evictable frame with the largest backward K-distance, the time since its
+ * K-th most recent reference. Frames with fewer than K references have an infinite distance and
+ * are evicted first, least recently referenced first, so pages touched once by a scan go before
+ * pages touched by every descent. A reference closer than the correlated reference period to the
+ * previous one is not a new reference, it shifts the history of the frame by the time since the
+ * previous one, so a burst of correlated references counts as one reference at its end, as in the
+ * paper. Frames referenced within that period are not evicted while any other frame can be.
+ *
+ * Time is a logical clock advanced by every RecordAccess call.
+ */
+class LRUKReplacer : public IReplacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of past references a frame is ranked by
+   * @param correlated_period references closer than this many accesses count as one
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        uint64_t correlated_period = LRUK_CRP);
+
+  ~LRUKReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  // (1 if the frame has K references else 0, K-th most recent or last reference time),
+  // ascending order is eviction order.
+  using EvictionKey = std::pair<uint64_t, uint64_t>;
+
+  struct FrameHistory {
+    std::vector<uint64_t> references;  // ring buffer of the last K uncorrelated reference times, shifted
+                                       // by the correlated references after them
+    uint64_t num_references = 0;
+    uint64_t last_reference = 0;  // including correlated references
+    bool evictable = false;
+    EvictionKey key;
+  };
+
+  EvictionKey GetEvictionKey(const FrameHistory &frame) const;
+
+  std::mutex lock_;
+  size_t k_;
+  uint64_t correlated_period_;
+  uint64_t current_timestamp_ = 0;
+  std::vector<FrameHistory> frames_;
+  std::set<std::pair<EvictionKey, frame_id_t>> evictable_;
+};
+
+}  // namespace miniKV
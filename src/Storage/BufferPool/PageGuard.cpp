@@ -0,0 +1,27 @@
+#include "Storage/BufferPool/PageGuard.h"
+
+#include "Storage/BufferPool/IBufferPoolManager.h"
+
+namespace miniKV {
+
+BasicPageGuard &BasicPageGuard::operator=(BasicPageGuard &&other) noexcept {
+  if (this != &other) {
+    Drop();
+    bpm = other.bpm;
+    page = other.page;
+    is_dirty = other.is_dirty;
+    other.page = nullptr;
+  }
+  return *this;
+}
+
+void BasicPageGuard::Drop() {
+  if (page == nullptr) {
+    return;
+  }
+  bpm->UnpinPage(page->GetPageId(), is_dirty);
+  page = nullptr;
+  is_dirty = false;
+}
+
+}  // namespace miniKV
@@ -0,0 +1,151 @@
+#ifndef MINIKV_PAGEGUARD_H
+#define MINIKV_PAGEGUARD_H
+
+#include <utility>
+
+#include "Common/Config.h"
+#include "Common/Macros.h"
+#include "Storage/Page/Page.h"
+
+namespace miniKV {
+
+class IBufferPoolManager;
+
+/**
+ * Pin on a page of a buffer pool, released when the guard is destroyed or dropped.
+ *
+ * Guards hold the frame as a raw pointer, the buffer pool owns the frames, so taking, moving and releasing
+ * a guard touches no reference count. They are move-only, a moved-from guard holds no page.
+ * The page is unpinned dirty if SetDirty was called.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+  BasicPageGuard(IBufferPoolManager *bpm_, Page *page_) : bpm(bpm_), page(page_) {}
+  ~BasicPageGuard() { Drop(); }
+
+  BasicPageGuard(BasicPageGuard &&other) noexcept : bpm(other.bpm), page(other.page), is_dirty(other.is_dirty) {
+    other.page = nullptr;
+  }
+  BasicPageGuard &operator=(BasicPageGuard &&other) noexcept;
+  DISALLOW_COPY(BasicPageGuard);
+
+  /** Unpin the page now, the guard holds no page afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return page != nullptr; }
+
+  inline page_id_t PageId() const { return page->GetPageId(); }
+  inline char *GetData() const { return page->GetData(); }
+
+  /** @return the page content as T, a page type such as BPlusTreeLeafPage */
+  template <typename T>
+  T *As() const {
+    return reinterpret_cast<T *>(page->GetData());
+  }
+
+  /** Unpin the page dirty. */
+  inline void SetDirty() { is_dirty = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  IBufferPoolManager *bpm = nullptr;
+  Page *page = nullptr;
+  bool is_dirty = false;
+};
+
+/** Pin and read latch on a page, both released when the guard is destroyed or dropped. */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+  // Read latch a page pinned by guard, which is left empty.
+  explicit ReadPageGuard(BasicPageGuard &&guard_) : guard(std::move(guard_)) {
+    if (guard.page != nullptr) {
+      guard.page->RLatch();
+    }
+  }
+  ~ReadPageGuard() { Drop(); }
+
+  ReadPageGuard(ReadPageGuard &&other) noexcept = default;
+  ReadPageGuard &operator=(ReadPageGuard &&other) noexcept {
+    if (this != &other) {
+      Drop();
+      guard = std::move(other.guard);
+    }
+    return *this;
+  }
+  DISALLOW_COPY(ReadPageGuard);
+
+  /** Unlatch and unpin the page now, the guard holds no page afterwards. */
+  inline void Drop() {
+    if (guard.page != nullptr) {
+      guard.page->RUnlatch();
+      guard.Drop();
+    }
+  }
+
+  explicit operator bool() const { return static_cast<bool>(guard); }
+  inline page_id_t PageId() const { return guard.PageId(); }
+  inline char *GetData() const { return guard.GetData(); }
+
+  template <typename T>
+  const T *As() const {
+    return guard.As<const T>();
+  }
+
+ private:
+  BasicPageGuard guard;
+};
+
+/** Pin and write latch on a page, both released when the guard is destroyed or dropped. */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+  // Write latch a page pinned by guard, which is left empty.
+  explicit WritePageGuard(BasicPageGuard &&guard_) : guard(std::move(guard_)) {
+    if (guard.page != nullptr) {
+      guard.page->WLatch();
+    }
+  }
+  ~WritePageGuard() { Drop(); }
+
+  WritePageGuard(WritePageGuard &&other) noexcept = default;
+  WritePageGuard &operator=(WritePageGuard &&other) noexcept {
+    if (this != &other) {
+      Drop();
+      guard = std::move(other.guard);
+    }
+    return *this;
+  }
+  DISALLOW_COPY(WritePageGuard);
+
+  /** Unlatch and unpin the page now, the guard holds no page afterwards. */
+  inline void Drop() {
+    if (guard.page != nullptr) {
+      guard.page->WUnlatch();
+      guard.Drop();
+    }
+  }
+
+  explicit operator bool() const { return static_cast<bool>(guard); }
+  inline page_id_t PageId() const { return guard.PageId(); }
+  inline char *GetData() const { return guard.GetData(); }
+
+  template <typename T>
+  T *As() const {
+    return guard.As<T>();
+  }
+
+  /** Unpin the page dirty, a page that was written to. */
+  inline void SetDirty() { guard.SetDirty(); }
+
+ private:
+  BasicPageGuard guard;
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_PAGEGUARD_H
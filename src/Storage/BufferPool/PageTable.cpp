@@ -0,0 +1,71 @@
+#include "Storage/BufferPool/PageTable.h"
+
+namespace miniKV {
+
+PageTable::PageTable(size_t slot_num) {
+  // Keep the load factor at or below 1/2, so probe sequences stay short.
+  size_t capacity = 2;
+  shift = 63;
+  while (capacity < slot_num * 2) {
+    capacity <<= 1;
+    --shift;
+  }
+  mask = capacity - 1;
+  slots = std::make_unique<std::atomic<uint64_t>[]>(capacity);
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].store(EMPTY, std::memory_order_relaxed);
+  }
+}
+
+bool PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const {
+  for (size_t i = Slot(page_id);; i = (i + 1) & mask) {
+    uint64_t entry = slots[i].load(std::memory_order_acquire);
+    if (entry == EMPTY) {
+      return false;
+    }
+    if (PageIdOf(entry) == page_id) {
+      *frame_id = FrameIdOf(entry);
+      return true;
+    }
+  }
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  size_t i = Slot(page_id);
+  while (slots[i].load(std::memory_order_relaxed) != EMPTY) {
+    i = (i + 1) & mask;
+  }
+  slots[i].store(Pack(page_id, frame_id), std::memory_order_release);
+}
+
+void PageTable::Erase(page_id_t page_id) {
+  size_t i = Slot(page_id);
+  for (;; i = (i + 1) & mask) {
+    uint64_t entry = slots[i].load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      return;
+    }
+    if (PageIdOf(entry) == page_id) {
+      break;
+    }
+  }
+
+  // Backward shift deletion: move later entries of the probe sequence into the hole, so that
+  // no tombstones are needed and lookups keep stopping at the first empty slot.
+  for (size_t j = (i + 1) & mask;; j = (j + 1) & mask) {
+    uint64_t entry = slots[j].load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      break;
+    }
+    size_t home = Slot(PageIdOf(entry));
+    // The entry at j may fill the hole at i only if its home slot is not in (i, j] (cyclically).
+    bool home_in_range = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+    if (!home_in_range) {
+      slots[i].store(entry, std::memory_order_release);
+      i = j;
+    }
+  }
+  slots[i].store(EMPTY, std::memory_order_release);
+}
+
+}  // namespace miniKV
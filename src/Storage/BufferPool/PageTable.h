@@ -0,0 +1,73 @@
+#ifndef MINIKV_PAGETABLE_H
+#define MINIKV_PAGETABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "Common/Config.h"
+
+namespace miniKV {
+
+/**
+ * PageTable maps the page ids in a buffer pool to frame ids.
+ *
+ * It is a fixed-size open-addressing hash table with linear probing, every slot is one
+ * 64-bit word holding both page id and frame id, so readers never see a torn entry.
+ * Insert and Erase must be serialized by the caller (the buffer pool latch), Find is
+ * lock-free and may run concurrently with them. A concurrent Find may miss an entry that
+ * Erase is shifting back, or return a frame that is being reused, so the result is only a
+ * hint: callers validate the frame and fall back to the latched path.
+ */
+class PageTable {
+ public:
+  /** @param slot_num the maximum number of entries, i.e. the number of frames in the buffer pool */
+  explicit PageTable(size_t slot_num);
+
+  /**
+   * Look up a page id.
+   * @param[out] frame_id frame id of the page if found
+   * @return true if the page id was found
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const;
+
+  /** Insert a page id that is not in the table yet. */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /** Erase a page id, no-op if the page id is not in the table. */
+  void Erase(page_id_t page_id);
+
+  /** Call fn(page_id, frame_id) on every entry, must be serialized with Insert and Erase. */
+  template <typename Fn>
+  void ForEach(Fn &&fn) const {
+    for (size_t i = 0; i <= mask; ++i) {
+      uint64_t entry = slots[i].load(std::memory_order_relaxed);
+      if (entry != EMPTY) {
+        fn(PageIdOf(entry), FrameIdOf(entry));
+      }
+    }
+  }
+
+ private:
+  static constexpr uint64_t EMPTY = ~0ULL;
+
+  static uint64_t Pack(page_id_t page_id, frame_id_t frame_id) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32 | static_cast<uint32_t>(frame_id);
+  }
+  static page_id_t PageIdOf(uint64_t entry) { return static_cast<page_id_t>(entry >> 32); }
+  static frame_id_t FrameIdOf(uint64_t entry) { return static_cast<frame_id_t>(entry & 0xFFFFFFFF); }
+
+  /** @return the home slot of page_id */
+  size_t Slot(page_id_t page_id) const {
+    // Fibonacci hashing, page ids are dense and sharded pools only see every N-th id.
+    return static_cast<size_t>((static_cast<uint32_t>(page_id) * 0x9E3779B97F4A7C15ULL) >> shift);
+  }
+
+  std::unique_ptr<std::atomic<uint64_t>[]> slots;
+  size_t mask;
+  int shift;
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_PAGETABLE_H
@@ -0,0 +1,66 @@
+#include "Storage/BufferPool/ParallelBufferPoolManager.h"
+
+namespace miniKV {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t slot_num_,
+                                                     std::shared_ptr<DiskManager> disk_manager,
+                                                     ReplacerType replacer_type, bool async_io, bool huge_pages)
+    : slot_num(slot_num_) {
+  MINIKV_ASSERT(num_instances > 0, "a buffer pool has at least one instance");
+  for (size_t i = 0; i < num_instances; ++i) {
+    instances.push_back(std::make_unique<BufferPoolManager>(slot_num, num_instances, i, disk_manager, replacer_type,
+                                                            async_io, huge_pages));
+  }
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetInstance(page_id_t page_id) const {
+  return instances[static_cast<size_t>(page_id) % instances.size()].get();
+}
+
+std::shared_ptr<Page> ParallelBufferPoolManager::FetchPage(page_id_t page_id) {
+  return GetInstance(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::PinPage(page_id_t page_id) { return GetInstance(page_id)->PinPage(page_id); }
+
+Page *ParallelBufferPoolManager::PeekPage(page_id_t page_id) { return GetInstance(page_id)->PeekPage(page_id); }
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) { return GetInstance(page_id)->FlushPage(page_id); }
+
+std::shared_ptr<Page> ParallelBufferPoolManager::NewPage() {
+  // Start from a different instance on every call, and try each instance once.
+  // An instance only fails when all of its frames are pinned.
+  size_t start = next_instance.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < instances.size(); ++i) {
+    auto page = instances[(start + i) % instances.size()]->NewPage();
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+Page *ParallelBufferPoolManager::PinNewPage() {
+  size_t start = next_instance.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < instances.size(); ++i) {
+    Page *page = instances[(start + i) % instances.size()]->PinNewPage();
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) { return GetInstance(page_id)->DeletePage(page_id); }
+
+void ParallelBufferPoolManager::FlushAllPages() {
+  for (auto &instance : instances) {
+    instance->FlushAllPages();
+  }
+}
+
+}  // namespace miniKV
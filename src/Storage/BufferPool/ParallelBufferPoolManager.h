@@ -0,0 +1,59 @@
+#ifndef MINIKV_PARALLELBUFFERPOOLMANAGER_H
+#define MINIKV_PARALLELBUFFERPOOLMANAGER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Common/Config.h"
+#include "Storage/BufferPool/BufferPoolManager.h"
+#include "Storage/BufferPool/IBufferPoolManager.h"
+#include "Storage/Disk/DiskManager.h"
+
+namespace miniKV {
+
+/**
+ * ParallelBufferPoolManager splits the buffer pool into independent BufferPoolManager
+ * instances, each with its own latch, page table, free list and replacer.
+ * A page always lives in instance page_id % num_instances, new pages are created
+ * round-robin over the instances.
+ */
+class ParallelBufferPoolManager : public IBufferPoolManager {
+ public:
+  /**
+   * Create a new parallel buffer pool manager.
+   * @param num_instances Number of BufferPoolManager instances.
+   * @param slot_num Number of pages in each instance.
+   * @param disk_manager The disk manager shared by all instances.
+   * @param replacer_type Replacement policy of every instance.
+   * @param async_io Whether instances do I/O without holding their latch.
+   * @param huge_pages Back the frames of every instance with huge pages.
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t slot_num, std::shared_ptr<DiskManager> disk_manager,
+                            ReplacerType replacer_type = ReplacerType::LRU, bool async_io = false,
+                            bool huge_pages = false);
+
+  std::shared_ptr<Page> FetchPage(page_id_t page_id) override;
+  Page *PinPage(page_id_t page_id) override;
+  Page *PeekPage(page_id_t page_id) override;
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+  bool FlushPage(page_id_t page_id) override;
+  std::shared_ptr<Page> NewPage() override;
+  Page *PinNewPage() override;
+  bool DeletePage(page_id_t page_id) override;
+  void FlushAllPages() override;
+  size_t GetPoolSize() const override { return instances.size() * slot_num; }
+  size_t GetPageSize() const override { return instances.front()->GetPageSize(); }
+
+ private:
+  /** @return the instance responsible for page_id */
+  BufferPoolManager *GetInstance(page_id_t page_id) const;
+
+  size_t slot_num;
+  std::vector<std::unique_ptr<BufferPoolManager>> instances;
+  std::atomic<size_t> next_instance{0};  // starting instance of the next NewPage
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_PARALLELBUFFERPOOLMANAGER_H
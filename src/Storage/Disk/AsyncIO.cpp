@@ -0,0 +1,437 @@
+#include "Storage/Disk/AsyncIO.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/Config.h"
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define MINIKV_HAVE_IO_URING 1
+#endif
+
+namespace miniKV {
+
+namespace {
+
+/** One read or write, completed possibly in several steps after short transfers. */
+struct IORequest {
+  std::promise<void> promise;
+  int fd;
+  char *buffer;
+  size_t size;
+  off_t offset;
+  bool is_write;
+  size_t done = 0;
+  int retries = 0;  // submissions refused by io_uring_enter with a transient error
+
+  void Fail(int error) {
+    promise.set_exception(std::make_exception_ptr(
+        std::runtime_error(std::string(is_write ? "write failed: " : "read failed: ") + strerror(error))));
+  }
+};
+
+/**
+ * Falls back to blocking pread/pwrite on a fixed set of threads.
+ */
+class ThreadPoolAsyncIO : public AsyncIO {
+ public:
+  explicit ThreadPoolAsyncIO(size_t num_threads) {
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers.emplace_back([this]() { Work(); });
+    }
+  }
+
+  ~ThreadPoolAsyncIO() override {
+    {
+      std::lock_guard<std::mutex> guard{queue_mutex};
+      stopping = true;
+    }
+    queue_cond.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  std::future<void> Read(int fd, char *buffer, size_t size, off_t offset) override {
+    return Submit(new IORequest{{}, fd, buffer, size, offset, false});
+  }
+
+  std::future<void> Write(int fd, const char *buffer, size_t size, off_t offset) override {
+    return Submit(new IORequest{{}, fd, const_cast<char *>(buffer), size, offset, true});
+  }
+
+  const char *Name() const override { return "thread pool"; }
+
+ private:
+  std::future<void> Submit(IORequest *request) {
+    auto future = request->promise.get_future();
+    {
+      std::lock_guard<std::mutex> guard{queue_mutex};
+      queue.push_back(request);
+    }
+    queue_cond.notify_one();
+    return future;
+  }
+
+  void Work() {
+    while (true) {
+      IORequest *request;
+      {
+        std::unique_lock<std::mutex> lock{queue_mutex};
+        queue_cond.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+          return;
+        }
+        request = queue.front();
+        queue.pop_front();
+      }
+      Execute(request);
+      delete request;
+    }
+  }
+
+  static void Execute(IORequest *request) {
+    while (request->done < request->size) {
+      char *buffer = request->buffer + request->done;
+      size_t size = request->size - request->done;
+      off_t offset = request->offset + request->done;
+      ssize_t rc = request->is_write ? pwrite(request->fd, buffer, size, offset) : pread(request->fd, buffer, size, offset);
+      if (rc < 0 && errno == EINTR) {
+        continue;
+      }
+      if (rc < 0) {
+        request->Fail(errno);
+        return;
+      }
+      if (rc == 0 && !request->is_write) {
+        memset(buffer, 0, size);  // end of file
+        break;
+      }
+      request->done += rc;
+    }
+    request->promise.set_value();
+  }
+
+  std::vector<std::thread> workers;
+  std::deque<IORequest *> queue;
+  std::mutex queue_mutex;
+  std::condition_variable queue_cond;
+  bool stopping = false;
+};
+
+#ifdef MINIKV_HAVE_IO_URING
+
+/**
+ * io_uring through the raw system calls, so no liburing is needed.
+ * At most queue_depth requests are in flight, which keeps the completion queue
+ * (twice as large) from overflowing.
+ */
+class IoUringAsyncIO : public AsyncIO {
+ public:
+  /** @return nullptr if the kernel refuses to set up a ring */
+  static std::unique_ptr<AsyncIO> Create(unsigned queue_depth) {
+    std::unique_ptr<IoUringAsyncIO> engine(new IoUringAsyncIO());
+    if (!engine->Setup(queue_depth)) {
+      return nullptr;
+    }
+    engine->reaper = std::thread([raw = engine.get()]() { raw->Reap(); });
+    return engine;
+  }
+
+  ~IoUringAsyncIO() override {
+    if (reaper.joinable()) {
+      std::unique_lock<std::mutex> lock{sq_mutex};
+      slot_cond.wait(lock, [this]() { return in_flight == 0; });
+      int error;
+      for (int retries = 0; (error = Push(nullptr)) != 0 && IsTransient(error) && retries < ASYNC_IO_RETRIES;
+           ++retries) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      lock.unlock();
+      if (error != 0) {
+        // The reaper stops at the completion of a nop, without one it waits forever, leave it the ring.
+        reaper.detach();
+        return;
+      }
+      reaper.join();
+    }
+    if (sqes != nullptr) {
+      munmap(sqes, sqes_size);
+    }
+    if (cq_ptr != nullptr && cq_ptr != sq_ptr) {
+      munmap(cq_ptr, cq_size);
+    }
+    if (sq_ptr != nullptr) {
+      munmap(sq_ptr, sq_size);
+    }
+    if (ring_fd >= 0) {
+      close(ring_fd);
+    }
+  }
+
+  std::future<void> Read(int fd, char *buffer, size_t size, off_t offset) override {
+    return Submit(new IORequest{{}, fd, buffer, size, offset, false});
+  }
+
+  std::future<void> Write(int fd, const char *buffer, size_t size, off_t offset) override {
+    return Submit(new IORequest{{}, fd, const_cast<char *>(buffer), size, offset, true});
+  }
+
+  const char *Name() const override { return "io_uring"; }
+
+ private:
+  IoUringAsyncIO() = default;
+
+  bool Setup(unsigned queue_depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+    if (ring_fd < 0) {
+      return false;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_size = cq_size = std::max(sq_size, cq_size);
+    }
+    sq_ptr = Map(sq_size, IORING_OFF_SQ_RING);
+    cq_ptr = single_mmap ? sq_ptr : Map(cq_size, IORING_OFF_CQ_RING);
+    sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = static_cast<struct io_uring_sqe *>(Map(sqes_size, IORING_OFF_SQES));
+    if (sq_ptr == nullptr || cq_ptr == nullptr || sqes == nullptr) {
+      return false;
+    }
+
+    auto *sq = static_cast<char *>(sq_ptr);
+    sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<char *>(cq_ptr);
+    cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    max_in_flight = params.sq_entries;
+    return true;
+  }
+
+  void *Map(size_t size, off_t offset) const {
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  }
+
+  std::future<void> Submit(IORequest *request) {
+    auto future = request->promise.get_future();
+    std::unique_lock<std::mutex> lock{sq_mutex};
+    slot_cond.wait(lock, [this]() { return in_flight < max_in_flight; });
+    in_flight++;
+    int error;
+    while ((error = Push(request)) != 0 && IsTransient(error) && request->retries++ < ASYNC_IO_RETRIES) {
+      // Completions give the kernel its resources back, retry after the next one is reaped.
+      uint64_t reaped = completions;
+      refused++;
+      slot_cond.wait_for(lock, std::chrono::milliseconds(1), [&]() { return completions != reaped; });
+      refused--;
+    }
+    lock.unlock();
+    if (error != 0) {
+      Release(request, error);
+    }
+    return future;
+  }
+
+  // io_uring_enter errors that go away once completions are reaped: the kernel is short of memory for
+  // requests, or of room in the completion queue.
+  static bool IsTransient(int error) { return error == EAGAIN || error == EBUSY; }
+
+  /**
+   * Queue one submission queue entry for the remaining part of request and enter the kernel,
+   * sq_mutex must be held. Without SQPOLL the kernel consumes the entry before returning,
+   * so the submission queue never fills up.
+   * @return 0, or the error of io_uring_enter, which consumed no entry then, the entry is taken back
+   */
+  int Push(IORequest *request) {
+    unsigned tail = *sq_tail;
+    unsigned index = tail & sq_mask;
+    struct io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    if (request == nullptr) {
+      sqe->opcode = IORING_OP_NOP;
+    } else {
+      sqe->opcode = request->is_write ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->fd = request->fd;
+      sqe->addr = reinterpret_cast<uint64_t>(request->buffer + request->done);
+      sqe->len = static_cast<uint32_t>(request->size - request->done);
+      sqe->off = static_cast<uint64_t>(request->offset + request->done);
+    }
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    while (syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, nullptr, 0) < 0) {
+      if (errno != EINTR) {
+        int error = errno;
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+        return error;
+      }
+    }
+    return 0;
+  }
+
+  void Reap() {
+    while (true) {
+      unsigned head = *cq_head;
+      if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+        if (!deferred.empty() && !OthersInFlight()) {
+          // No completion is coming to wait for, only the deferred requests are in flight.
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          RetryDeferred();
+          continue;
+        }
+        syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        continue;
+      }
+
+      struct io_uring_cqe *cqe = &cqes[head & cq_mask];
+      auto *request = reinterpret_cast<IORequest *>(cqe->user_data);
+      int result = cqe->res;
+      __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+      if (request == nullptr) {
+        return;
+      }
+      Complete(request, result);
+      if (!deferred.empty()) {
+        RetryDeferred();
+      }
+    }
+  }
+
+  void Complete(IORequest *request, int result) {
+    if (result == -EINTR || result == -EAGAIN) {
+      Resubmit(request);
+      return;
+    }
+    if (result < 0) {
+      Release(request, -result);
+    } else if (result == 0 && !request->is_write) {
+      memset(request->buffer + request->done, 0, request->size - request->done);  // end of file
+      Release(request, 0);
+    } else {
+      request->done += result;
+      if (request->done < request->size) {
+        Resubmit(request);  // short transfer, the request keeps its slot
+        return;
+      }
+      Release(request, 0);
+    }
+  }
+
+  /**
+   * Submit request again from the reaper. The reaper cannot wait for the completions it has to reap itself,
+   * so a request refused with a transient error is deferred and retried by Reap after the next completion.
+   */
+  void Resubmit(IORequest *request) {
+    int error;
+    {
+      std::lock_guard<std::mutex> guard{sq_mutex};
+      error = Push(request);
+    }
+    if (error == 0) {
+      return;
+    }
+    if (IsTransient(error) && request->retries++ < ASYNC_IO_RETRIES) {
+      deferred.push_back(request);
+    } else {
+      Release(request, error);
+    }
+  }
+
+  // @return true if the kernel holds requests whose completions the reaper can wait for
+  bool OthersInFlight() {
+    std::lock_guard<std::mutex> guard{sq_mutex};
+    return in_flight > deferred.size() + refused;
+  }
+
+  void RetryDeferred() {
+    std::vector<IORequest *> retry;
+    retry.swap(deferred);
+    for (auto *request : retry) {
+      Resubmit(request);
+    }
+  }
+
+  // Complete request, with error if it is not 0, and give its slot back.
+  void Release(IORequest *request, int error) {
+    if (error != 0) {
+      request->Fail(error);
+    } else {
+      request->promise.set_value();
+    }
+    delete request;
+
+    {
+      std::lock_guard<std::mutex> guard{sq_mutex};
+      in_flight--;
+      completions++;
+    }
+    slot_cond.notify_all();
+  }
+
+  int ring_fd = -1;
+  void *sq_ptr = nullptr;
+  void *cq_ptr = nullptr;
+  size_t sq_size = 0;
+  size_t cq_size = 0;
+  size_t sqes_size = 0;
+  unsigned *sq_tail = nullptr;
+  unsigned sq_mask = 0;
+  unsigned *sq_array = nullptr;
+  struct io_uring_sqe *sqes = nullptr;
+  unsigned *cq_head = nullptr;
+  unsigned *cq_tail = nullptr;
+  unsigned cq_mask = 0;
+  struct io_uring_cqe *cqes = nullptr;
+
+  std::mutex sq_mutex;  // protects the submission queue tail, in_flight, refused and completions
+  std::condition_variable slot_cond;
+  unsigned in_flight = 0;
+  unsigned max_in_flight = 0;
+  unsigned refused = 0;  // requests in flight that Submit retries after the kernel refused them
+  uint64_t completions = 0;  // requests released, submitters refused by the kernel wait for the next one
+  std::vector<IORequest *> deferred;  // resubmissions refused by the kernel, only used by the reaper
+  std::thread reaper;
+};
+
+#endif  // MINIKV_HAVE_IO_URING
+
+}  // namespace
+
+std::unique_ptr<AsyncIO> AsyncIO::Create(bool use_io_uring, unsigned queue_depth, size_t num_threads) {
+#ifdef MINIKV_HAVE_IO_URING
+  if (use_io_uring) {
+    if (auto engine = IoUringAsyncIO::Create(queue_depth)) {
+      return engine;
+    }
+  }
+#endif
+  return std::make_unique<ThreadPoolAsyncIO>(num_threads);
+}
+
+}  // namespace miniKV
@@ -0,0 +1,41 @@
+#ifndef MINIKV_ASYNCIO_H
+#define MINIKV_ASYNCIO_H
+
+#include <sys/types.h>
+
+#include <future>
+#include <memory>
+
+namespace miniKV {
+
+/**
+ * AsyncIO runs positional reads and writes on a file descriptor in the background.
+ * Reads past the end of file zero-fill the rest of the buffer, I/O errors are reported
+ * through the returned future.
+ *
+ * The io_uring engine submits requests to the kernel from the calling thread and completes
+ * them on one reaper thread. When io_uring is not available (old kernel, seccomp) the engine
+ * falls back to a pool of threads issuing pread/pwrite.
+ */
+class AsyncIO {
+ public:
+  virtual ~AsyncIO() = default;
+
+  /**
+   * Create an I/O engine.
+   * @param use_io_uring try io_uring first, otherwise use the thread pool engine
+   * @param queue_depth io_uring submission queue entries, the number of requests in flight
+   * @param num_threads number of threads of the fallback engine
+   */
+  static std::unique_ptr<AsyncIO> Create(bool use_io_uring, unsigned queue_depth, size_t num_threads);
+
+  virtual std::future<void> Read(int fd, char *buffer, size_t size, off_t offset) = 0;
+  virtual std::future<void> Write(int fd, const char *buffer, size_t size, off_t offset) = 0;
+
+  /** @return "io_uring" or "thread pool" */
+  virtual const char *Name() const = 0;
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_ASYNCIO_H
@@ -4,43 +4,404 @@
 
 #include "Storage/Disk/DiskManager.h"
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 
 namespace miniKV {
 
-page_id_t DiskManager::AllocatePage() { return next_page_id++; }
+/** Layout of the file header, the rest of the FILE_HEADER_SIZE bytes is zero. */
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t page_size;
+  uint32_t buffer_pool_size;
+  page_id_t next_page_id;    // pages below it have been allocated
+  page_id_t free_list_head;  // first free-list page, INVALID_PAGE_ID if no page is free
+  uint32_t free_page_count;  // page ids stored in the free-list pages
+};
+
+/** Layout of a free-list page, an otherwise free page storing a part of the free page ids. */
+struct FreeListPage {
+  char magic[8];
+  page_id_t next_page_id;  // next free-list page, INVALID_PAGE_ID for the last one
+  uint32_t count;          // page ids stored in this page
+  page_id_t page_ids[0];
+
+  /** @return number of page ids fitting in a page of page_size bytes */
+  static size_t Capacity(size_t page_size) { return (page_size - sizeof(FreeListPage)) / sizeof(page_id_t); }
+};
+
+static constexpr char FILE_MAGIC[8] = {'m', 'i', 'n', 'i', 'K', 'V', 'd', 'b'};
+static constexpr char FREE_LIST_MAGIC[8] = {'m', 'K', 'V', 'f', 'r', 'e', 'e', 0};
+// Version 2 stores the keys and values of B+ tree pages in separate arrays, version 3 adds the right
+// sibling and high key to the B+ tree page headers.
+static constexpr uint32_t FILE_VERSION = 3;
+
+/** @return an aligned buffer of size bytes for O_DIRECT I/O */
+static std::unique_ptr<char, decltype(&std::free)> AlignedBuffer(size_t size) {
+  return {static_cast<char *>(std::aligned_alloc(DiskManager::IO_ALIGNMENT, size)), &std::free};
+}
+
+/** @return this thread's aligned page for O_DIRECT I/O on unaligned caller buffers */
+static char *BounceBuffer(size_t page_size) {
+  static thread_local size_t capacity = 0;
+  static thread_local std::unique_ptr<char, decltype(&std::free)> buffer(nullptr, &std::free);
+  if (capacity < page_size) {
+    buffer = AlignedBuffer(page_size);
+    capacity = page_size;
+  }
+  return buffer.get();
+}
+
+DiskManager::DiskManager(std::string db_file_, bool use_io_uring_, bool direct_io_)
+    : DiskManager(std::move(db_file_), DatabaseOptions(), use_io_uring_, direct_io_) {}
+
+DiskManager::DiskManager(std::string db_file_, const DatabaseOptions &options_, bool use_io_uring_, bool direct_io_)
+    : db_file_name(db_file_), next_page_id(0), use_io_uring(use_io_uring_), direct_io(direct_io_) {
+  std::string::size_type n = db_file_name.rfind('.');
+  if (n == std::string::npos) {
+    std::cout << "wrong file format";
+    return;
+  }
+
+  if (direct_io) {
+    db_fd = open(db_file_name.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (db_fd < 0 && errno == EINVAL) {
+      LOG(WARNING) << db_file_name << " does not support O_DIRECT, using buffered I/O";
+      direct_io = false;
+    }
+  }
+  if (!direct_io) {
+    db_fd = open(db_file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd < 0) {
+    throw std::runtime_error("can't open db file");
+  }
+
+  try {
+    OpenHeader(options_);
+  } catch (...) {
+    close(db_fd);
+    throw;
+  }
+}
+
+void DiskManager::OpenHeader(const DatabaseOptions &requested) {
+  if (GetFileSize() == 0) {
+    options.page_size = requested.page_size != 0 ? requested.page_size : PAGE_SIZE;
+    options.buffer_pool_size = requested.buffer_pool_size != 0 ? requested.buffer_pool_size : BUFFER_POOL_SIZE;
+    if (options.page_size % IO_ALIGNMENT != 0) {
+      throw std::runtime_error("page size must be a multiple of " + std::to_string(IO_ALIGNMENT));
+    }
+    Sync();
+    return;
+  }
+
+  auto buffer = AlignedBuffer(FILE_HEADER_SIZE);
+  auto *header = reinterpret_cast<FileHeader *>(buffer.get());
+  ReadPageAt(buffer.get(), 0, FILE_HEADER_SIZE);
+  if (memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+    throw std::runtime_error(db_file_name + " is not a miniKV database file");
+  }
+  if (header->version != FILE_VERSION) {
+    throw std::runtime_error("unsupported database file version " + std::to_string(header->version));
+  }
+  if (header->page_size == 0 || header->page_size % IO_ALIGNMENT != 0 || header->buffer_pool_size == 0 ||
+      header->next_page_id < 0) {
+    throw std::runtime_error(db_file_name + " has a corrupted header");
+  }
+  if (requested.page_size != 0 && requested.page_size != header->page_size) {
+    throw std::runtime_error("page size mismatch: " + db_file_name + " has " + std::to_string(header->page_size) +
+                             " byte pages, " + std::to_string(requested.page_size) + " requested");
+  }
+  options.page_size = header->page_size;
+  options.buffer_pool_size = header->buffer_pool_size;
+  next_page_id = header->next_page_id;
+  if (header->free_list_head != INVALID_PAGE_ID) {
+    ReadFreeList(header->free_list_head, header->free_page_count);
+  }
+  if (requested.buffer_pool_size != 0 && requested.buffer_pool_size != options.buffer_pool_size) {
+    options.buffer_pool_size = requested.buffer_pool_size;
+    Sync();
+  }
+}
+
+void DiskManager::WriteHeader() {
+  auto buffer = AlignedBuffer(FILE_HEADER_SIZE);
+  memset(buffer.get(), 0, FILE_HEADER_SIZE);
+  auto *header = reinterpret_cast<FileHeader *>(buffer.get());
+  memcpy(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header->version = FILE_VERSION;
+  header->page_size = options.page_size;
+  header->buffer_pool_size = options.buffer_pool_size;
+
+  std::lock_guard<std::mutex> guard(header_mutex);
+  {
+    std::lock_guard<std::mutex> free_guard(free_mutex);
+    header->free_list_head = WriteFreeList();
+    header->free_page_count = static_cast<uint32_t>(free_page_count);
+    header->next_page_id = next_page_id.load();
+  }
+  WritePageAt(buffer.get(), 0, FILE_HEADER_SIZE);
+}
+
+void DiskManager::ReadFreeList(page_id_t head, uint32_t count) {
+  auto buffer = AlignedBuffer(options.page_size);
+  auto *free_list_page = reinterpret_cast<FreeListPage *>(buffer.get());
+  size_t capacity = FreeListPage::Capacity(options.page_size);
+  page_id_t end = next_page_id.load();
+  bool corrupted = false;
+  // Every free-list page holds at least one id, so a cycle ends after count pages.
+  page_id_t page_id = head;
+  for (uint32_t pages_left = count; page_id != INVALID_PAGE_ID && pages_left > 0 && !corrupted; --pages_left) {
+    if (page_id <= HEADER_PAGE_ID || page_id >= end) {
+      corrupted = true;
+      break;
+    }
+    ReadPageAt(buffer.get(), PageOffset(page_id), options.page_size);
+    if (memcmp(free_list_page->magic, FREE_LIST_MAGIC, sizeof(FREE_LIST_MAGIC)) != 0 ||
+        free_list_page->count == 0 || free_list_page->count > capacity) {
+      corrupted = true;
+      break;
+    }
+    for (uint32_t i = 0; i < free_list_page->count; ++i) {
+      page_id_t free_page_id = free_list_page->page_ids[i];
+      corrupted |= free_page_id <= HEADER_PAGE_ID || free_page_id >= end;
+      InsertFreePage(free_page_id);
+    }
+    page_id = free_list_page->next_page_id;
+  }
+  if (corrupted || page_id != INVALID_PAGE_ID || free_page_count != count) {
+    // Losing the list only leaks the free pages, reusing a page that is not free would corrupt the database.
+    LOG(WARNING) << db_file_name << " has a corrupted free-page list, its pages are not reused";
+    free_pages.assign(free_stride, {});
+    free_page_count = 0;
+  }
+}
+
+page_id_t DiskManager::WriteFreeList() {
+  page_id_t end = next_page_id.load();
+  while (end > 0 && free_pages[static_cast<uint32_t>(end - 1) % free_stride].erase(end - 1) > 0) {
+    free_page_count--;
+    end--;
+  }
+  if (end != next_page_id.load()) {
+    next_page_id = end;
+    if (ftruncate(db_fd, PageOffset(end)) != 0) {
+      throw std::runtime_error(std::string("truncate failed: ") + strerror(errno));
+    }
+  }
+  if (free_page_count == 0) {
+    return INVALID_PAGE_ID;
+  }
+
+  // Free-list pages are taken from the highest free pages, AllocatePage reuses them last,
+  // so the list written by the last Sync() stays readable as long as possible.
+  size_t capacity = FreeListPage::Capacity(options.page_size);
+  auto buffer = AlignedBuffer(options.page_size);
+  auto *free_list_page = reinterpret_cast<FreeListPage *>(buffer.get());
+  std::vector<page_id_t> sorted = SortedFreePages();
+  auto list_page = sorted.rbegin();
+  page_id_t next_list_page = INVALID_PAGE_ID;
+  for (auto it = sorted.begin(); it != sorted.end();) {
+    memset(buffer.get(), 0, options.page_size);
+    memcpy(free_list_page->magic, FREE_LIST_MAGIC, sizeof(FREE_LIST_MAGIC));
+    free_list_page->next_page_id = next_list_page;
+    for (; it != sorted.end() && free_list_page->count < capacity; ++it) {
+      free_list_page->page_ids[free_list_page->count++] = *it;
+    }
+    next_list_page = *list_page++;
+    WritePageAt(buffer.get(), PageOffset(next_list_page), options.page_size);
+  }
+  return next_list_page;
+}
+
+DiskManager::~DiskManager() {
+  async_io.reset();  // waits for requests in flight
+  if (db_fd >= 0) {
+    try {
+      WriteHeader();
+    } catch (const std::exception &e) {
+      LOG(WARNING) << "failed to write the header of " << db_file_name << ": " << e.what();
+    }
+    close(db_fd);
+  }
+}
+
+page_id_t DiskManager::AllocatePage(uint32_t stride, uint32_t offset) {
+  std::lock_guard<std::mutex> guard(free_mutex);
+  SetFreeStride(stride);
+  auto &own_pages = free_pages[offset];
+  if (!own_pages.empty()) {
+    page_id_t reused = *own_pages.begin();
+    own_pages.erase(own_pages.begin());
+    free_page_count--;
+    return reused;
+  }
+
+  // Round up to the next page id that belongs to the requesting shard, the skipped ids are free for the others.
+  page_id_t page_id = next_page_id.load();
+  page_id_t allocated = page_id + static_cast<page_id_t>((offset + stride - page_id % stride) % stride);
+  for (; page_id < allocated; ++page_id) {
+    if (page_id != HEADER_PAGE_ID) {
+      InsertFreePage(page_id);
+    }
+  }
+  next_page_id = allocated + 1;
+  return allocated;
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(free_mutex);
+  if (page_id > HEADER_PAGE_ID && page_id < next_page_id.load()) {
+    InsertFreePage(page_id);
+  }
+}
+
+size_t DiskManager::GetFreePageCount() {
+  std::lock_guard<std::mutex> guard(free_mutex);
+  return free_page_count;
+}
+
+void DiskManager::SetFreeStride(uint32_t stride) {
+  if (stride == free_stride) {
+    return;
+  }
+  std::vector<page_id_t> sorted = SortedFreePages();
+  free_pages.assign(stride, {});
+  free_stride = stride;
+  free_page_count = 0;
+  for (page_id_t page_id : sorted) {
+    InsertFreePage(page_id);
+  }
+}
+
+std::vector<page_id_t> DiskManager::SortedFreePages() const {
+  std::vector<page_id_t> sorted;
+  sorted.reserve(free_page_count);
+  for (const auto &pages : free_pages) {
+    sorted.insert(sorted.end(), pages.begin(), pages.end());
+  }
+  std::sort(sorted.begin(), sorted.end());
+  return sorted;
+}
 
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int off_set = page_id * PAGE_SIZE;
-  if (off_set > GetFileSize()) {
-    throw std::runtime_error("page id out of range");
+  size_t page_size = options.page_size;
+  if (NeedsBounce(page_data)) {
+    ReadPageAt(BounceBuffer(page_size), PageOffset(page_id), page_size);
+    memcpy(page_data, BounceBuffer(page_size), page_size);
+  } else {
+    ReadPageAt(page_data, PageOffset(page_id), page_size);
   }
+}
 
-  db_io.seekp(page_id * PAGE_SIZE);
-  db_io.read(page_data, PAGE_SIZE);
+void DiskManager::ReadPageAt(char *page_data, off_t offset, size_t size) {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t rc = pread(db_fd, page_data + read_count, size - read_count, offset + read_count);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("read page failed: ") + strerror(errno));
+    }
+    if (rc == 0) {
+      break;
+    }
+    read_count += rc;
+  }
 
-  int read_count = db_io.gcount();
-  if (read_count < PAGE_SIZE) {
-    db_io.clear();
-    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  if (read_count < size) {
+    // Only stat the file on a short read, pages past the end of file do not exist yet.
+    if (read_count == 0 && offset > GetFileSize()) {
+      throw std::runtime_error("page id out of range");
+    }
+    memset(page_data + read_count, 0, size - read_count);
   }
 }
 
 void DiskManager::WritePage(page_id_t page_id, char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  db_io.seekp(offset);
-  db_io.write(page_data, PAGE_SIZE);
+  size_t page_size = options.page_size;
+  if (NeedsBounce(page_data)) {
+    memcpy(BounceBuffer(page_size), page_data, page_size);
+    WritePageAt(BounceBuffer(page_size), PageOffset(page_id), page_size);
+  } else {
+    WritePageAt(page_data, PageOffset(page_id), page_size);
+  }
+}
 
-  /// Flush to disk SYNC
-  db_io.flush();
+void DiskManager::WritePageAt(const char *page_data, off_t offset, size_t size) {
+  size_t write_count = 0;
+  while (write_count < size) {
+    ssize_t rc = pwrite(db_fd, page_data + write_count, size - write_count, offset + write_count);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("write page failed: ") + strerror(errno));
+    }
+    write_count += rc;
+  }
 }
 
-int DiskManager::GetFileSize() const {
-  struct stat stat_buf;
-  int rc = stat(db_file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+std::future<void> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  size_t page_size = options.page_size;
+  if (NeedsBounce(page_data)) {
+    // Only buffer pool frames are read asynchronously in the hot path, they are aligned.
+    std::promise<void> done;
+    try {
+      ReadPageAt(BounceBuffer(page_size), PageOffset(page_id), page_size);
+      memcpy(page_data, BounceBuffer(page_size), page_size);
+      done.set_value();
+    } catch (...) {
+      done.set_exception(std::current_exception());
+    }
+    return done.get_future();
+  }
+  return GetAsyncIO()->Read(db_fd, page_data, page_size, PageOffset(page_id));
 }
 
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+std::future<void> DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  size_t page_size = options.page_size;
+  if (NeedsBounce(page_data)) {
+    std::promise<void> done;
+    try {
+      memcpy(BounceBuffer(page_size), page_data, page_size);
+      WritePageAt(BounceBuffer(page_size), PageOffset(page_id), page_size);
+      done.set_value();
+    } catch (...) {
+      done.set_exception(std::current_exception());
+    }
+    return done.get_future();
+  }
+  return GetAsyncIO()->Write(db_fd, page_data, page_size, PageOffset(page_id));
+}
+
+AsyncIO *DiskManager::GetAsyncIO() {
+  std::call_once(async_io_init,
+                 [this]() { async_io = AsyncIO::Create(use_io_uring, ASYNC_IO_QUEUE_DEPTH, ASYNC_IO_THREADS); });
+  return async_io.get();
+}
+
+void DiskManager::Sync() {
+  WriteHeader();
+  if (fdatasync(db_fd) != 0) {
+    throw std::runtime_error(std::string("sync failed: ") + strerror(errno));
+  }
+}
+
+off_t DiskManager::GetFileSize() const {
+  struct stat stat_buf;
+  int rc = fstat(db_fd, &stat_buf);
+  return rc == 0 ? stat_buf.st_size : -1;
+}
 
 }  // namespace miniKV
\ No newline at end of file
@@ -5,51 +5,184 @@
 #ifndef MINIKV_DISKMANAGER_H
 #define MINIKV_DISKMANAGER_H
 
-#include <fstream>
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Common/Config.h"
+#include "Storage/Disk/AsyncIO.h"
 
 namespace miniKV {
 
+/**
+ * Options fixed per database, stored in the header of the database file.
+ * Zero means the value stored in an existing file, or the default from src/Common/Config.h for a new one.
+ */
+struct DatabaseOptions {
+  uint32_t page_size = 0;         // bytes per page, a multiple of DiskManager::IO_ALIGNMENT, cannot change once created
+  uint32_t buffer_pool_size = 0;  // pages in the buffer pool, a new value is stored on open
+};
+
+/**
+ * DiskManager reads and writes pages of the database file with positional I/O (pread/pwrite),
+ * so concurrent buffer pool misses do not serialize on a shared file offset.
+ * Writes reach the operating system immediately but are only durable after Sync().
+ * ReadPageAsync/WritePageAsync run on an io_uring engine, or on a thread pool when io_uring
+ * is not available, created on first use.
+ *
+ * In direct I/O mode the file is opened with O_DIRECT and pages bypass the kernel page cache,
+ * so they are only cached once, in the buffer pool. Buffers should then be IO_ALIGNMENT aligned,
+ * like buffer pool frames are, other buffers go through an aligned bounce buffer.
+ *
+ * The file starts with a FILE_HEADER_SIZE header holding the DatabaseOptions and the allocation state,
+ * page p is stored at FILE_HEADER_SIZE + p * page size. The header is written by Sync() and on close,
+ * so reopening a file continues allocating after the pages allocated before.
+ *
+ * Deallocated pages are kept in a free set that AllocatePage draws from first, lowest page id first.
+ * Sync() truncates free pages at the end of the file, and stores the remaining free page ids in a
+ * chain of free-list pages, which are free pages themselves, referenced by the file header.
+ */
 class DiskManager {
  public:
   DiskManager() = delete;
-  DiskManager(std::string db_file_) : db_file_name(db_file_), next_page_id(0) {
-    std::string::size_type n = db_file_name.rfind('.');
-    if (n == std::string::npos) {
-      std::cout << "wrong file format";
-      return;
-    }
-
-    db_io.open(db_file_name, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io.is_open()) {
-      db_io.clear();
-      // create a new file
-      db_io.open(db_file_name, std::ios::binary | std::ios::trunc | std::ios::out);
-      db_io.close();
-      // reopen with original mode
-      db_io.open(db_file_name, std::ios::binary | std::ios::in | std::ios::out);
-      if (!db_io.is_open()) {
-        throw std::runtime_error("can't open db file");
-      }
-    }
-  }
+  /**
+   * @param db_file_ path of the database file, created if it does not exist
+   * @param use_io_uring false to always run asynchronous I/O on the thread pool engine
+   * @param direct_io open the file with O_DIRECT, falls back to buffered I/O if the file system refuses
+   */
+  DiskManager(std::string db_file_, bool use_io_uring = true, bool direct_io = false);
+
+  /**
+   * @param options options of a new database file, checked against the header of an existing one
+   * @throw std::runtime_error if the file is not a database file, or its page size differs from options
+   */
+  DiskManager(std::string db_file_, const DatabaseOptions &options, bool use_io_uring = true, bool direct_io = false);
+  ~DiskManager();
+
+  DiskManager(const DiskManager &) = delete;
+  DiskManager &operator=(const DiskManager &) = delete;
 
   void ReadPage(page_id_t page_id, char *page_data);
   void WritePage(page_id_t page_id, char *page_data);
 
-  page_id_t AllocatePage();
+  /**
+   * Start reading a page, page_data must stay valid until the future is ready.
+   * Unlike ReadPage, a page past the end of file reads as zeros instead of throwing.
+   */
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /** Start writing a page, page_data must stay valid and unchanged until the future is ready. */
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /** @return the engine running asynchronous I/O */
+  AsyncIO *GetAsyncIO();
+
+  /** @return true if the file is opened with O_DIRECT */
+  bool IsDirectIO() const { return direct_io; }
+
+  /** @return the size of every page of the file in bytes */
+  size_t GetPageSize() const { return options.page_size; }
+
+  /** @return the options of the file, with the stored or default values filled in */
+  const DatabaseOptions &GetOptions() const { return options; }
+
+  /** Alignment of buffers, file offsets and sizes of O_DIRECT I/O. */
+  static constexpr size_t IO_ALIGNMENT = 4096;
+  static_assert(PAGE_SIZE % IO_ALIGNMENT == 0, "pages must be a multiple of the direct I/O alignment");
+
+  /** Size of the file header in front of the first page, keeps pages aligned for O_DIRECT. */
+  static constexpr size_t FILE_HEADER_SIZE = IO_ALIGNMENT;
+
+  /** Make every page written so far and the file header durable. */
+  void Sync();
+
+  /**
+   * Allocate a new page id.
+   * A sharded buffer pool passes its shard count and index so that the returned id
+   * satisfies page_id % stride == offset, i.e. the page belongs to the calling shard.
+   */
+  page_id_t AllocatePage(uint32_t stride = 1, uint32_t offset = 0);
+
+  /**
+   * Return a page to the free set, so AllocatePage can reuse it.
+   * The page must not be cached by a buffer pool any more, its content is lost.
+   */
   void DeallocatePage(page_id_t page_id);
 
+  /** @return the page id following every allocated page, 0 for a new database */
+  page_id_t GetNextPageId() const { return next_page_id.load(); }
+
+  /** @return number of deallocated pages waiting to be reused */
+  size_t GetFreePageCount();
+
  private:
   const std::string db_file_name;
-  std::fstream db_io;
+  int db_fd = -1;
   std::atomic<page_id_t> next_page_id;
+  bool use_io_uring;
+  bool direct_io;
+  std::once_flag async_io_init;
+  std::unique_ptr<AsyncIO> async_io;
+  DatabaseOptions options;
+  std::mutex header_mutex;  // orders header writes, so a stale next_page_id never overwrites a newer one
+  std::mutex free_mutex;    // protects the free pages, and next_page_id updates while free pages are truncated
+  // Free page ids by page id % free_stride, the stride of the last AllocatePage, so a shard of a
+  // ParallelBufferPoolManager takes the first free id of its own in one lookup.
+  std::vector<std::set<page_id_t>> free_pages{1};
+  uint32_t free_stride = 1;
+  size_t free_page_count = 0;
+
+  off_t GetFileSize() const;
+
+  // Add a free page id, free_mutex must be held.
+  void InsertFreePage(page_id_t page_id) {
+    free_page_count += free_pages[static_cast<uint32_t>(page_id) % free_stride].insert(page_id).second;
+  }
+
+  // Split the free page ids by a new stride, free_mutex must be held. Only the first allocation of a
+  // sharded buffer pool changes the stride.
+  void SetFreeStride(uint32_t stride);
+
+  // @return every free page id in increasing order, free_mutex must be held
+  std::vector<page_id_t> SortedFreePages() const;
+
+  /** Read the free-list pages starting at head into free_pages, the list is dropped if it is corrupted. */
+  void ReadFreeList(page_id_t head, uint32_t count);
+
+  /**
+   * Drop the free pages at the end of the file and truncate it, then write the free-list pages.
+   * free_mutex must be held.
+   * @return the first free-list page, INVALID_PAGE_ID if no page is free
+   */
+  page_id_t WriteFreeList();
+
+  /** Read and validate the header of an existing file, or write the header of a new one. */
+  void OpenHeader(const DatabaseOptions &requested);
+
+  /** Write the options and the allocation state to the file header. */
+  void WriteHeader();
+
+  /** @return the file offset of a page */
+  off_t PageOffset(page_id_t page_id) const {
+    return static_cast<off_t>(FILE_HEADER_SIZE) + static_cast<off_t>(page_id) * options.page_size;
+  }
+
+  /** @return true if buffer cannot be used for I/O on the file as is */
+  bool NeedsBounce(const char *buffer) const {
+    return direct_io && reinterpret_cast<uintptr_t>(buffer) % IO_ALIGNMENT != 0;
+  }
 
-  int GetFileSize() const;
+  void ReadPageAt(char *page_data, off_t offset, size_t size);
+  void WritePageAt(const char *page_data, off_t offset, size_t size);
 };
 }  // namespace miniKV
 
@@ -13,8 +13,10 @@
 
 #include <iostream>
 #include <sstream>
+#include <type_traits>
 
 #include "Common/Utils.h"
+#include "Util/KeySearch.h"
 
 namespace miniKV {
 /*****************************************************************************
@@ -32,6 +34,8 @@ void B_PLUS_TREE_INTERNAL_PAGE::Init(page_id_t page_id, page_id_t parent_id, int
   SetMaxSize(max_size);
   SetParentPageId(parent_id);
   SetPageId(page_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetHighKey(KeyType{});
 }
 
 /*
@@ -39,7 +43,7 @@ void B_PLUS_TREE_INTERNAL_PAGE::Init(page_id_t page_id, page_id_t parent_id, int
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-KeyType B_PLUS_TREE_INTERNAL_PAGE::KeyAt(int index) const { return array[index].first; }
+KeyType B_PLUS_TREE_INTERNAL_PAGE::KeyAt(int index) const { return Keys()[index]; }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE::SetKeyAt(int index, const KeyType &key) {
@@ -49,7 +53,7 @@ void B_PLUS_TREE_INTERNAL_PAGE::SetKeyAt(int index, const KeyType &key) {
     std::cout << "internal_page SetKeyAt: index=0" << std::endl;
   }
 
-  array[index].first = key;
+  Keys()[index] = key;
 }
 
 /*
@@ -61,7 +65,7 @@ int B_PLUS_TREE_INTERNAL_PAGE::ValueIndex(const ValueType &value) const {
   for (int i = 0; i < GetSize(); i++) {
     // We are comparing values here, of type page_id_t. So we just use ==.
     // KeyComparator is used for comparing keys.
-    if (array[i].second == value) {
+    if (Values()[i] == value) {
       return i;
     }
   }
@@ -75,7 +79,7 @@ int B_PLUS_TREE_INTERNAL_PAGE::ValueIndex(const ValueType &value) const {
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE::ValueAt(int index) const { return array[index].second; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE::ValueAt(int index) const { return Values()[index]; }
 
 //*****************************************************************************
 //* LOOKUP
@@ -87,14 +91,53 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE::ValueAt(int index) const { return array[ind
  * Start the search from the second key(the first key should always be invalid)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE::Lookup(const KeyType &key) const {
-  for (int i = 1; i < GetSize(); i++) {
-    KeyType k = array[i].first;
-    if (key < k) {
-      return array[i - 1].second;
-    }
+ValueType B_PLUS_TREE_INTERNAL_PAGE::Lookup(const KeyType &key) const { return Values()[LookupIndex(key)]; }
+
+/*
+ * Same as Lookup, but return the index of the child pointer. Keys of the child are below KeyAt(index + 1),
+ * if index + 1 < GetSize().
+ * The index is the number of valid keys not greater than key, found with a branch-free binary search, which
+ * compares the last few keys with SIMD instructions for int64 keys.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE::LookupIndex(const KeyType &key) const {
+  if (GetSize() <= 1) {
+    return 0;
+  }
+  return CountKeysNotGreater(Keys() + 1, GetSize() - 1, key);
+}
+
+/*
+ * Same as Lookup, for readers that neither latch nor pin the page, see BPlusTree::GetValue. A writer may
+ * change the page meanwhile, so the header is read once and checked against the capacity of a page of
+ * page_size bytes: a torn page gives a wrong child, but no read outside the page. The caller validates the
+ * page version before following the child.
+ * @return false if the header is not the one of an internal page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE::OptimisticLookup(const KeyType &key, size_t page_size, ValueType *child) const {
+  int size = GetSize();
+  int capacity = GetMaxSize() + 1;
+  if (IsLeafPage() || size < 1 || size > capacity || capacity > MaxSizeFor(page_size) + 1) {
+    return false;
+  }
+  const KeyType *keys = Keys();
+  const ValueType *values = reinterpret_cast<const ValueType *>(data_ + sizeof(KeyType) * capacity);
+  *child = values[CountKeysNotGreater(keys + 1, size - 1, key)];
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE::CountKeysNotGreater(const KeyType *keys, size_t count, const KeyType &key) {
+  if (count == 0) {
+    return 0;
+  }
+  if constexpr (std::is_same_v<KeyType, int64_t>) {
+    return static_cast<int>(CountNotGreater(keys, count, key));
+  } else {
+    const KeyType *base = NarrowNotGreater(keys, &count, key, 1);
+    return static_cast<int>(base - keys) + !(key < *base);
   }
-  return array[GetSize() - 1].second;
 }
 
 /*****************************************************************************
@@ -110,14 +153,10 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                                                 const ValueType &new_value) {
   // This is called when a new root page is created. It only contains one key, two values.
+  // old_value is the left half of the split, reused page ids make the right half's id lower at times.
   SetKeyAt(1, new_key);
-  if (old_value <= new_value) {
-    array[0].second = old_value;
-    array[1].second = new_value;
-  } else {
-    array[0].second = new_value;
-    array[1].second = old_value;
-  }
+  Values()[0] = old_value;
+  Values()[1] = new_value;
   SetSize(2);
 }
 
@@ -139,12 +178,13 @@ int B_PLUS_TREE_INTERNAL_PAGE::InsertNodeAfter(const ValueType &old_value, const
   // Shift existing values, if needed
   if (value_index + 1 < old_size) {
     for (int i = old_size - 1; i > value_index; i--) {
-      array[i + 1] = array[i];
+      MoveEntry(i, i + 1);
     }
   }
 
   // Insert new value
-  array[value_index + 1] = MappingType{new_key, new_value};
+  Keys()[value_index + 1] = new_key;
+  Values()[value_index + 1] = new_value;
 
   // Update size
   IncreaseSize(1);
@@ -152,16 +192,43 @@ int B_PLUS_TREE_INTERNAL_PAGE::InsertNodeAfter(const ValueType &old_value, const
   return GetSize();
 }
 
+/*
+ * Insert new_key & new_value pair at the position of new_key, after the pairs with smaller keys.
+ * B-link splits insert the new child by key, the child it was split from may have moved on.
+ * @return:  new size after insertion
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE::Insert(const KeyType &new_key, const ValueType &new_value) {
+  int index = LookupIndex(new_key) + 1;
+  for (int i = GetSize() - 1; i >= index; i--) {
+    MoveEntry(i, i + 1);
+  }
+  Keys()[index] = new_key;
+  Values()[index] = new_value;
+  IncreaseSize(1);
+  return GetSize();
+}
+
+/*
+ * Append key & value pair after the last pair, the key of the first pair is ignored.
+ * NOTE: This method is only called by BulkLoad()(BPlusTree.cpp), which sets the parent page id
+ * of the child when creating it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE::AppendChild(const KeyType &key, const ValueType &value) {
+  Keys()[GetSize()] = key;
+  Values()[GetSize()] = value;
+  IncreaseSize(1);
+}
+
 // Helper function
 // Fetch page_id into buffer bool, update its parent page id, and unpin the page, marking it as dirty.
 void updateParentPageId(page_id_t page_id, page_id_t parent_page_id,
-                        std::shared_ptr<BufferPoolManager> buffer_pool_manager) {
-  auto mem_page = buffer_pool_manager->FetchPage(page_id);
-  BPlusTreePage *tree_page = reinterpret_cast<BPlusTreePage *>(mem_page->GetData());
-
-  assert(tree_page != nullptr);
-  tree_page->SetParentPageId(parent_page_id);
-  buffer_pool_manager->UnpinPage(page_id, true);
+                        const std::shared_ptr<IBufferPoolManager> &buffer_pool_manager) {
+  auto mem_page = buffer_pool_manager->FetchPageBasic(page_id);
+  assert(mem_page);
+  mem_page.As<BPlusTreePage>()->SetParentPageId(parent_page_id);
+  mem_page.SetDirty();
 }
 
 /*****************************************************************************
@@ -173,33 +240,34 @@ void updateParentPageId(page_id_t page_id, page_id_t parent_page_id,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE::MoveHalfTo(BPlusTreeInternalPage *recipient,
-                                           std::shared_ptr<BufferPoolManager> buffer_pool_manager) {
+                                           std::shared_ptr<IBufferPoolManager> buffer_pool_manager) {
   // Move array[(size+1)/2 : size-1]
   // Number of elements moved: size-1 - (size+1)/2 + 1 = size-(size+1)/2 = size-ceil(size/2) = floor(size/2)
   // After move, this->GetSize() >= recipient->GetSize().
   int move_start = (GetSize() + 1) / 2;
   int num_moved = GetSize() - move_start;
-  recipient->CopyNFrom(&array[move_start], num_moved, buffer_pool_manager);
+  recipient->CopyNFrom(this, move_start, num_moved, buffer_pool_manager);
 
   recipient->SetSize(num_moved);
   SetSize(GetSize() - num_moved);
 }
 
-/* Copy entries into me, starting from {items} and copy {size} entries.
+/* Copy {size} entries of source into me, starting from its entry {start}.
  * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
  * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger.
  *
  * The caller should update the size. This function doesn't.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE::CopyNFrom(MappingType *items, int size,
-                                          std::shared_ptr<BufferPoolManager> buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE::CopyNFrom(const BPlusTreeInternalPage *source, int start, int size,
+                                          std::shared_ptr<IBufferPoolManager> buffer_pool_manager) {
   int old_size = GetSize();
-  for (int i = old_size; i < size; i++) {
-    int offset = i - old_size;
-    array[i] = items[offset];
+  for (int i = old_size; i < old_size + size; i++) {
+    int offset = start + i - old_size;
+    Keys()[i] = source->Keys()[offset];
+    Values()[i] = source->Values()[offset];
 
-    page_id_t page_id = array[i].second;
+    page_id_t page_id = Values()[i];
     page_id_t parent_page_id = GetPageId();
     updateParentPageId(page_id, parent_page_id, buffer_pool_manager);
   }
@@ -216,7 +284,7 @@ void B_PLUS_TREE_INTERNAL_PAGE::CopyNFrom(MappingType *items, int size,
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE::Remove(int index) {
   for (int i = index + 1; i < GetSize(); i++) {
-    array[i - 1] = array[i];
+    MoveEntry(i, i - 1);
   }
 
   IncreaseSize(-1);
@@ -233,7 +301,7 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE::RemoveAndReturnOnlyChild() {
   }
 
   SetSize(0);
-  return array[0].second;
+  return Values()[0];
 }
 
 /*****************************************************************************
@@ -248,21 +316,24 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE::RemoveAndReturnOnlyChild() {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                          std::shared_ptr<BufferPoolManager> buffer_pool_manager) {
+                                          std::shared_ptr<IBufferPoolManager> buffer_pool_manager) {
   // Assume recipient is the left sibling
   // This is only called by Coalesce() in b_plus_tree.cpp
 
   // Move key&value pairs
   for (int i = 0; i < GetSize(); i++) {
-    recipient->array[recipient->GetSize() + i] = array[i];
+    recipient->Keys()[recipient->GetSize() + i] = Keys()[i];
+    recipient->Values()[recipient->GetSize() + i] = Values()[i];
 
-    page_id_t page_id = array[i].second;
+    page_id_t page_id = Values()[i];
     page_id_t parent_page_id = recipient->GetPageId();
     updateParentPageId(page_id, parent_page_id, buffer_pool_manager);
   }
 
   // Set middle_key
-  recipient->array[recipient->GetSize()].first = middle_key;
+  recipient->Keys()[recipient->GetSize()] = middle_key;
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
 
   // Update size for both nodes
   int sz = GetSize();
@@ -283,15 +354,15 @@ void B_PLUS_TREE_INTERNAL_PAGE::MoveAllTo(BPlusTreeInternalPage *recipient, cons
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                 std::shared_ptr<BufferPoolManager> buffer_pool_manager) {
-  recipient->array[recipient->GetSize()] = array[0];
-  recipient->array[recipient->GetSize()].first = middle_key;
+                                                 std::shared_ptr<IBufferPoolManager> buffer_pool_manager) {
+  recipient->Keys()[recipient->GetSize()] = middle_key;
+  recipient->Values()[recipient->GetSize()] = Values()[0];
 
   for (int i = 1; i < GetSize(); i++) {
-    array[i - 1] = array[i];
+    MoveEntry(i, i - 1);
   }
 
-  page_id_t page_id = recipient->array[recipient->GetSize()].second;
+  page_id_t page_id = recipient->Values()[recipient->GetSize()];
   page_id_t parent_page_id = recipient->GetPageId();
   updateParentPageId(page_id, parent_page_id, buffer_pool_manager);
 
@@ -304,11 +375,12 @@ void B_PLUS_TREE_INTERNAL_PAGE::MoveFirstToEndOf(BPlusTreeInternalPage *recipien
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE::CopyLastFrom(const MappingType &pair,
-                                             std::shared_ptr<BufferPoolManager> buffer_pool_manager) {
-  array[GetSize()] = pair;
+void B_PLUS_TREE_INTERNAL_PAGE::CopyLastFrom(const KeyType &key, const ValueType &value,
+                                             std::shared_ptr<IBufferPoolManager> buffer_pool_manager) {
+  Keys()[GetSize()] = key;
+  Values()[GetSize()] = value;
 
-  updateParentPageId(array[GetSize()].second, GetPageId(), buffer_pool_manager);
+  updateParentPageId(value, GetPageId(), buffer_pool_manager);
 
   IncreaseSize(1);
 }
@@ -322,27 +394,14 @@ void B_PLUS_TREE_INTERNAL_PAGE::CopyLastFrom(const MappingType &pair,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                  std::shared_ptr<BufferPoolManager> buffer_pool_manager) {
-  // make room
-  for (int i = recipient->GetSize() - 1; i >= 0; i--) {
-    recipient->array[i + 2] = recipient->array[i];
-  }
-
-  // put middle_key
-  recipient->array[2].first = middle_key;
-
-  // move key-value pair
-  recipient->array[1] = array[GetSize() - 1];
+                                                  std::shared_ptr<IBufferPoolManager> buffer_pool_manager) {
+  // The old first child of recipient is now separated from the moved child by middle_key.
+  recipient->Keys()[0] = middle_key;
 
-  // invalidate pointer. TODO(fred): is this correct?
-  recipient->array[0].second = INVALID_PAGE_ID;
+  // The key of the moved pair lands in recipient's dummy key, the caller copies it up to the parent.
+  recipient->CopyFirstFrom(Keys()[GetSize() - 1], Values()[GetSize() - 1], buffer_pool_manager);
 
-  // update parent page id
-  updateParentPageId(recipient->array[1].second, recipient->GetPageId(), buffer_pool_manager);
-
-  // update size
   IncreaseSize(-1);
-  recipient->IncreaseSize(1);
 }
 
 /* Append an entry at the beginning.
@@ -350,21 +409,19 @@ void B_PLUS_TREE_INTERNAL_PAGE::MoveLastToFrontOf(BPlusTreeInternalPage *recipie
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE::CopyFirstFrom(const MappingType &pair,
-                                              std::shared_ptr<BufferPoolManager> buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE::CopyFirstFrom(const KeyType &key, const ValueType &value,
+                                              std::shared_ptr<IBufferPoolManager> buffer_pool_manager) {
   // make room
   for (int i = GetSize() - 1; i >= 0; i--) {
-    array[i + 1] = array[i];
+    MoveEntry(i, i + 1);
   }
 
   // put entry
-  array[1] = pair;
-
-  // invalidate pointer. TODO(fred): is this correct?
-  array[0].second = INVALID_PAGE_ID;
+  Keys()[0] = key;
+  Values()[0] = value;
 
   // update parent page id
-  updateParentPageId(array[1].second, GetPageId(), buffer_pool_manager);
+  updateParentPageId(value, GetPageId(), buffer_pool_manager);
 
   // update size
   IncreaseSize(1);
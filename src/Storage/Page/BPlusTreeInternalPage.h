@@ -17,8 +17,7 @@
 namespace miniKV {
 
 #define B_PLUS_TREE_INTERNAL_PAGE BPlusTreeInternalPage<KeyType, ValueType>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)) - 1)
+#define INTERNAL_PAGE_HEADER_SIZE 32
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -27,16 +26,31 @@ namespace miniKV {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Internal page format (keys are stored in increasing order). Keys and page ids are stored in two arrays,
+ * each with room for max size + 1 entries, so searches only read keys:
+ *  -------------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) | KEY(2) | ... | KEY(max + 1) | PAGE_ID(1) | PAGE_ID(2) | ... | PAGE_ID(max + 1) |
+ *  -------------------------------------------------------------------------------------------
+ *
+ * The header is that of BPlusTreePage followed by NextPageId (4) and HighKey (8), 32 bytes in total, like
+ * in leaf pages: the right sibling on the same level and the first key it may hold.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
+  void Init(page_id_t page_id, page_id_t parent_id, int max_size);
+  // number of children fitting in an internal page of page_size bytes, one slot is kept for splits
+  static int MaxSizeFor(size_t page_size) {
+    return static_cast<int>((page_size - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)) - 1);
+  }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+  KeyType GetHighKey() const { return high_key_; }
+  void SetHighKey(const KeyType &high_key) { high_key_ = high_key; }
+  // true if key belongs to a page on the right, the page was split since its parent was read
+  bool IsPastHighKey(const KeyType &key) const { return next_page_id_ != INVALID_PAGE_ID && !(key < high_key_); }
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
@@ -44,24 +58,53 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   ValueType ValueAt(int index) const;
 
   ValueType Lookup(const KeyType &key) const;
+  int LookupIndex(const KeyType &key) const;
+  bool OptimisticLookup(const KeyType &key, size_t page_size, ValueType *child) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+  int Insert(const KeyType &new_key, const ValueType &new_value);
+  // append a child after the last one when building a node left to right, its parent page id is not updated
+  void AppendChild(const KeyType &key, const ValueType &value);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
   // Split and Merge utility methods
   void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                 std::shared_ptr<BufferPoolManager> buffer_pool_manager);
-  void MoveHalfTo(BPlusTreeInternalPage *recipient, std::shared_ptr<BufferPoolManager> buffer_pool_manager);
+                 std::shared_ptr<IBufferPoolManager> buffer_pool_manager);
+  void MoveHalfTo(BPlusTreeInternalPage *recipient, std::shared_ptr<IBufferPoolManager> buffer_pool_manager);
   void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                        std::shared_ptr<BufferPoolManager> buffer_pool_manager);
+                        std::shared_ptr<IBufferPoolManager> buffer_pool_manager);
   void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                         std::shared_ptr<BufferPoolManager> buffer_pool_manager);
+                         std::shared_ptr<IBufferPoolManager> buffer_pool_manager);
 
  private:
-  void CopyNFrom(MappingType *items, int size, std::shared_ptr<BufferPoolManager> buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair, std::shared_ptr<BufferPoolManager> buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, std::shared_ptr<BufferPoolManager> buffer_pool_manager);
-  MappingType array[0];
+  void CopyNFrom(const BPlusTreeInternalPage *source, int start, int size,
+                 std::shared_ptr<IBufferPoolManager> buffer_pool_manager);
+  void CopyLastFrom(const KeyType &key, const ValueType &value,
+                    std::shared_ptr<IBufferPoolManager> buffer_pool_manager);
+  void CopyFirstFrom(const KeyType &key, const ValueType &value,
+                     std::shared_ptr<IBufferPoolManager> buffer_pool_manager);
+
+  // number of keys not greater than key, keys are sorted
+  static int CountKeysNotGreater(const KeyType *keys, size_t count, const KeyType &key);
+
+  // copy the key and value at index from to index to
+  void MoveEntry(int from, int to) {
+    Keys()[to] = Keys()[from];
+    Values()[to] = Values()[from];
+  }
+
+  // The value array starts after room for GetArrayCapacity() keys.
+  KeyType *Keys() { return reinterpret_cast<KeyType *>(data_); }
+  const KeyType *Keys() const { return reinterpret_cast<const KeyType *>(data_); }
+  ValueType *Values() { return reinterpret_cast<ValueType *>(data_ + sizeof(KeyType) * GetArrayCapacity()); }
+  const ValueType *Values() const {
+    return reinterpret_cast<const ValueType *>(data_ + sizeof(KeyType) * GetArrayCapacity());
+  }
+
+  page_id_t next_page_id_;
+  KeyType high_key_;
+  // Key array followed by the value array, see the page format above.
+  alignas(KeyType) char data_[0];
 };
 }  // namespace miniKV
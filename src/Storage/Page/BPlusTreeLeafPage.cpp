@@ -12,6 +12,7 @@
 #include "Storage/Page/BPlusTreeLeafPage.h"
 
 #include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include "Common/Utils.h"
@@ -32,13 +33,14 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
   // Default values:
   // parent_id = INVALID_PAGE_ID;
-  // max_size = LEAF_PAGE_SIZE.
+  // max_size = MaxSizeFor(page size).
 
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
   SetPageId(page_id);
   SetParentPageId(parent_id);
   SetNextPageId(INVALID_PAGE_ID);
+  SetHighKey(KeyType{});
   SetMaxSize(max_size);
 }
 
@@ -52,15 +54,12 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
 /**
- * Helper method to find the first index i so that array[i].first >= key
- * NOTE: This method is only used when generating index iterator
+ * Helper method to find the first index i so that KeyAt(i) >= key
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE::KeyIndex(const KeyType &key) const {
-  const MappingType *p = std::lower_bound(array, array + GetSize(), key,
-                                          [&](const MappingType &item, const KeyType &k) { return item.first < k; });
-
-  return std::distance(array, p);
+  const KeyType *keys = Keys();
+  return std::distance(keys, std::lower_bound(keys, keys + GetSize(), key));
 }
 
 /*
@@ -68,14 +67,25 @@ int B_PLUS_TREE_LEAF_PAGE::KeyIndex(const KeyType &key) const {
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-KeyType B_PLUS_TREE_LEAF_PAGE::KeyAt(int index) const { return array[index].first; }
+KeyType B_PLUS_TREE_LEAF_PAGE::KeyAt(int index) const { return Keys()[index]; }
 
 /*
  * Helper method to find and return the key & value pair associated with input
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE::GetItem(int index) { return array[index]; }
+MappingType B_PLUS_TREE_LEAF_PAGE::GetItem(int index) const { return MappingType{Keys()[index], Values()[index]}; }
+
+/*
+ * Move {count} entries starting from index {from} to index {to}, the ranges may overlap.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE::ShiftEntries(int from, int to, int count) {
+  if (count > 0) {
+    std::memmove(Keys() + to, Keys() + from, count * sizeof(KeyType));
+    std::memmove(Values() + to, Values() + from, count * sizeof(ValueType));
+  }
+}
 
 //*****************************************************************************
 //* INSERTION
@@ -87,16 +97,16 @@ const MappingType &B_PLUS_TREE_LEAF_PAGE::GetItem(int index) { return array[inde
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE::Insert(const KeyType &key, const ValueType &value) {
-  /* find insert position [binary search] */
-  int insert_position = KeyIndex(key);
+  /* find insert position, keys past the last key are appended without a search [binary search] */
+  int size = GetSize();
+  int insert_position = size == 0 || Keys()[size - 1] < key ? size : KeyIndex(key);
 
   // make room
-  for (int i = GetSize() - 1; i >= insert_position; i--) {
-    array[i + 1] = array[i];
-  }
+  ShiftEntries(insert_position, insert_position + 1, size - insert_position);
 
   // insert key-value pair
-  array[insert_position] = MappingType{key, value};
+  Keys()[insert_position] = key;
+  Values()[insert_position] = value;
 
   // update size
   IncreaseSize(1);
@@ -104,6 +114,24 @@ int B_PLUS_TREE_LEAF_PAGE::Insert(const KeyType &key, const ValueType &value) {
   return GetSize();
 }
 
+/*
+ * Insert count entries with strictly increasing keys, none of them in the page, which has room for them.
+ * Entries are placed from the last one down, so every entry of the page moves once, where an Insert per
+ * entry moves the entries after it every time.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE::InsertAll(const MappingType *entries, int count) {
+  int end = GetSize();  // entries [0, end) of the page have not moved yet
+  for (int i = count - 1; i >= 0; --i) {
+    int insert_position = std::distance(Keys(), std::lower_bound(Keys(), Keys() + end, entries[i].first));
+    ShiftEntries(insert_position, insert_position + i + 1, end - insert_position);
+    Keys()[insert_position + i] = entries[i].first;
+    Values()[insert_position + i] = entries[i].second;
+    end = insert_position;
+  }
+  IncreaseSize(count);
+}
+
 //*****************************************************************************
 // SPLIT
 //*****************************************************************************
@@ -118,28 +146,32 @@ void B_PLUS_TREE_LEAF_PAGE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
   // Move array[(size+1)/2 : size-1].
   // Number of elements moved: size-1 - (size+1)/2 + 1 = size-(size+1)/2 = size-ceil(size/2) = floor(size/2)
   // After move, this->GetSize() >= recipient->GetSize().
-  int move_start = (GetSize() + 1) / 2;
-  int num_moved = GetSize() - move_start;
-  recipient->CopyNFrom(&array[move_start], num_moved);
+  MoveTailTo(recipient, GetSize() / 2);
+}
 
-  IncreaseSize(-num_moved);
-  recipient->IncreaseSize(num_moved);
+/**
+ * Remove the last {count} key & value pairs from this page to "recipient" page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE::MoveTailTo(BPlusTreeLeafPage *recipient, int count) {
+  recipient->CopyNFrom(this, GetSize() - count, count);
+
+  IncreaseSize(-count);
+  recipient->IncreaseSize(count);
 }
 
 /*
- * Copy starting from items, and copy {size} number of elements into me.
+ * Copy {size} number of elements of source, starting from index {start}, after my elements.
  * [Attention] The caller should update size. This function doesn't.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE::CopyNFrom(MappingType *items, int size) {
+void B_PLUS_TREE_LEAF_PAGE::CopyNFrom(const BPlusTreeLeafPage *source, int start, int size) {
   if (GetSize() + size > GetMaxSize()) {
     throw std::runtime_error("CopyNFrom: will overflow page");
   }
 
-  int old_size = GetSize();
-  for (int i = 0; i < size; i++) {
-    array[old_size + i] = items[i];
-  }
+  std::memcpy(Keys() + GetSize(), source->Keys() + start, size * sizeof(KeyType));
+  std::memcpy(Values() + GetSize(), source->Values() + start, size * sizeof(ValueType));
 }
 
 //*****************************************************************************
@@ -153,28 +185,91 @@ void B_PLUS_TREE_LEAF_PAGE::CopyNFrom(MappingType *items, int size) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE::Lookup(const KeyType &key, ValueType *value) const {
-  /* Linear search */
-  // for (int i = 0; i < GetSize(); i++) {
-  //   if (comparator(array[i].first, key) == 0) {
-  //     if (value != nullptr) {
-  //       *value = array[i].second;
-  //     }
-  //     return true;
-  //   }
-  // }
-  // return false;
-
   /* Binary search */
   int pos = KeyIndex(key);
-  if (pos < GetSize() && (array[pos].first == key)) {
+  if (pos < GetSize() && (Keys()[pos] == key)) {
     if (value != nullptr) {
-      *value = array[pos].second;
+      *value = Values()[pos];
     }
     return true;
   }
   return false;
 }
 
+/*
+ * Set the value of the given key in place, if the key exists in the leaf page.
+ * @return true if the key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE::Update(const KeyType &key, const ValueType &value) {
+  ValueType *slot = FindValue(key);
+  if (slot != nullptr) {
+    *slot = value;
+  }
+  return slot != nullptr;
+}
+
+/*
+ * Find the value of the given key, to be read or set in place with a single search.
+ * @return pointer into the page, nullptr if the key does not exist
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType *B_PLUS_TREE_LEAF_PAGE::FindValue(const KeyType &key) {
+  int pos = KeyIndex(key);
+  if (pos < GetSize() && (Keys()[pos] == key)) {
+    return &Values()[pos];
+  }
+  return nullptr;
+}
+
+/*
+ * Same as Lookup, for readers that neither latch nor pin the page, see BPlusTree::GetValue. The header is
+ * read once and checked against the capacity of a page of page_size bytes, so a page changed meanwhile
+ * gives a wrong answer, which the caller discards when it validates the page version, but no read
+ * outside the page.
+ * @param position if not null, the search starts at *position, the position of a smaller key looked up
+ * before, and *position is set to the position of key, for callers looking up keys in ascending order
+ * @return false if the header is not the one of a leaf page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE::OptimisticLookup(const KeyType &key, size_t page_size, ValueType *value, bool *found,
+                                             int *position) const {
+  int size = GetSize();
+  int capacity = GetMaxSize() + 1;
+  if (!IsLeafPage() || size < 0 || size > capacity || capacity > MaxSizeFor(page_size)) {
+    return false;
+  }
+  const KeyType *keys = Keys();
+  int from = position != nullptr ? std::min(std::max(*position, 0), size) : 0;
+  int pos = std::distance(keys, std::lower_bound(keys + from, keys + size, key));
+  if (position != nullptr) {
+    *position = pos;
+  }
+  *found = pos < size && keys[pos] == key;
+  if (*found) {
+    *value = reinterpret_cast<const ValueType *>(data_ + sizeof(KeyType) * capacity)[pos];
+  }
+  return true;
+}
+
+/*
+ * Key and value arrays and size of the page for readers that search it themselves, checked as in
+ * OptimisticLookup, see BPlusTree::MultiGet.
+ * @return false if the header is not the one of a leaf page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE::OptimisticArrays(size_t page_size, const KeyType **keys, const ValueType **values,
+                                             int *size) const {
+  *size = GetSize();
+  int capacity = GetMaxSize() + 1;
+  if (!IsLeafPage() || *size < 0 || *size > capacity || capacity > MaxSizeFor(page_size)) {
+    return false;
+  }
+  *keys = Keys();
+  *values = reinterpret_cast<const ValueType *>(data_ + sizeof(KeyType) * capacity);
+  return true;
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -188,22 +283,43 @@ INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE::RemoveAndDeleteRecord(const KeyType &key) {
   /* Binary search */
   int pos = KeyIndex(key);
-  if (pos < GetSize() && (array[pos].first == key)) {
-    for (int j = pos + 1; j < GetSize(); j++) {
-      array[j - 1] = array[j];
-    }
+  if (pos < GetSize() && (Keys()[pos] == key)) {
+    ShiftEntries(pos + 1, pos, GetSize() - pos - 1);
     IncreaseSize(-1);
   }
   return GetSize();
 }
 
+/*
+ * Remove the entries of count strictly increasing keys, keys that do not exist are skipped. Every entry
+ * of the page moves at most once.
+ * @return   page size after deletion
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE::RemoveAll(const KeyType *keys, int count) {
+  int size = GetSize();
+  int removed = 0;
+  int start = 0;  // entries [start, pos) are kept, they move down by removed
+  for (int i = 0; i < count; ++i) {
+    int pos = std::distance(Keys(), std::lower_bound(Keys() + start, Keys() + size, keys[i]));
+    if (pos < size && Keys()[pos] == keys[i]) {
+      ShiftEntries(start, start - removed, pos - start);
+      removed++;
+      start = pos + 1;
+    }
+  }
+  ShiftEntries(start, start - removed, size - start);
+  IncreaseSize(-removed);
+  return GetSize();
+}
+
 //*****************************************************************************
 //* MERGE
 //*****************************************************************************
 
 /*
  * Remove all of key & value pairs from this page to "recipient" page. Don't forget
- * to update the next_page id in the sibling page.
+ * to update the next_page id and the high key in the sibling page.
  *
  * This function updates the size of two nodes.
  */
@@ -213,8 +329,9 @@ void B_PLUS_TREE_LEAF_PAGE::MoveAllTo(BPlusTreeLeafPage *recipient) {
   // If we are moving to the right sibling (recipient), we need to update the left sibling
   int sz = GetSize();
 
-  recipient->CopyNFrom(array, sz);
+  recipient->CopyNFrom(this, 0, sz);
   recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
 
   recipient->IncreaseSize(sz);
   IncreaseSize(-sz);
@@ -230,12 +347,10 @@ void B_PLUS_TREE_LEAF_PAGE::MoveAllTo(BPlusTreeLeafPage *recipient) {
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
   // Copy element to recipient's last position
-  recipient->CopyLastFrom(array[0]);
+  recipient->CopyLastFrom(Keys()[0], Values()[0]);
 
-  // Remove first element from my array
-  for (int i = 1; i < GetSize(); i++) {
-    array[i - 1] = array[i];
-  }
+  // Remove first element from my arrays
+  ShiftEntries(1, 0, GetSize() - 1);
 
   // update size for both nodes
   IncreaseSize(-1);
@@ -249,7 +364,7 @@ void B_PLUS_TREE_LEAF_PAGE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
   // Copy element to recipient's front position
-  recipient->CopyFirstFrom(array[GetSize() - 1]);
+  recipient->CopyFirstFrom(Keys()[GetSize() - 1], Values()[GetSize() - 1]);
 
   // No need to remove the last element. The caller can just update the size.
 
@@ -263,21 +378,23 @@ void B_PLUS_TREE_LEAF_PAGE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
  * [Attention] This function doesn't update size.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE::CopyLastFrom(const MappingType &item) { array[GetSize()] = item; }
+void B_PLUS_TREE_LEAF_PAGE::CopyLastFrom(const KeyType &key, const ValueType &value) {
+  Keys()[GetSize()] = key;
+  Values()[GetSize()] = value;
+}
 
 /*
  * Insert item at the front of my items. Move items accordingly.
  * [Attention] this function doesn't update size.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE::CopyFirstFrom(const MappingType &item) {
+void B_PLUS_TREE_LEAF_PAGE::CopyFirstFrom(const KeyType &key, const ValueType &value) {
   // make space
-  for (int i = GetSize() - 1; i >= 0; i--) {
-    array[i + 1] = array[i];
-  }
+  ShiftEntries(0, 1, GetSize());
 
   // copy element
-  array[0] = item;
+  Keys()[0] = key;
+  Values()[0] = value;
 }
 
 template class BPlusTreeLeafPage<key_t, value_t>;
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -19,47 +20,66 @@
 namespace miniKV {
 
 #define B_PLUS_TREE_LEAF_PAGE BPlusTreeLeafPage<KeyType, ValueType>
-#define LEAF_PAGE_HEADER_SIZE 24
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE 32
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
  *
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ * Leaf page format (keys are stored in order). Keys and values are stored in two arrays, each with room
+ * for the max size given to Init, so key searches only read keys and entries are not padded:
+ *  ---------------------------------------------------------------------------------
+ * | HEADER | KEY(1) | KEY(2) | ... | KEY(max) | VALUE(1) | VALUE(2) | ... | VALUE(max)
+ *  ---------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 24 bytes in total):
+ *  Header format (size in byte, 32 bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) |  CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -------------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4) ｜
- *  -------------------------------------------------
+ *  ------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) ｜ HighKey (8) |
+ *  ------------------------------------------------------------------
+ *
+ * NextPageId is the right sibling and HighKey the first key it may hold, the keys of the page are less
+ * than HighKey, see BPlusTree for the B-link protocol. The last leaf has no high key.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  void Init(page_id_t page_id, page_id_t parent_id, int max_size);
+  // number of entries fitting in a leaf page of page_size bytes
+  static int MaxSizeFor(size_t page_size) {
+    return static_cast<int>((page_size - LEAF_PAGE_HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)));
+  }
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const { return high_key_; }
+  void SetHighKey(const KeyType &high_key) { high_key_ = high_key; }
+  // true if key belongs to a page on the right, the page was split since its parent was read
+  bool IsPastHighKey(const KeyType &key) const { return next_page_id_ != INVALID_PAGE_ID && !(key < high_key_); }
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key) const;
-  const MappingType &GetItem(int index);
+  MappingType GetItem(int index) const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value);
+  void InsertAll(const MappingType *entries, int count);
   bool Lookup(const KeyType &key, ValueType *value) const;
+  bool Update(const KeyType &key, const ValueType &value);
+  ValueType *FindValue(const KeyType &key);
+  bool OptimisticLookup(const KeyType &key, size_t page_size, ValueType *value, bool *found,
+                        int *position = nullptr) const;
+  bool OptimisticArrays(size_t page_size, const KeyType **keys, const ValueType **values, int *size) const;
   int RemoveAndDeleteRecord(const KeyType &key);
+  int RemoveAll(const KeyType *keys, int count);
 
   // Split and Merge utility methods
   void MoveHalfTo(BPlusTreeLeafPage *recipient);
+  void MoveTailTo(BPlusTreeLeafPage *recipient, int count);
   void MoveAllTo(BPlusTreeLeafPage *recipient);
   void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
@@ -67,13 +87,25 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   std::string toString() const;
 
  private:
-  void CopyNFrom(MappingType *items, int size);
-  void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item);
+  void CopyNFrom(const BPlusTreeLeafPage *source, int start, int size);
+  void CopyLastFrom(const KeyType &key, const ValueType &value);
+  void CopyFirstFrom(const KeyType &key, const ValueType &value);
+  void ShiftEntries(int from, int to, int count);
+
+  // Entries are shifted and copied with memmove and memcpy.
+  static_assert(std::is_trivially_copyable_v<KeyType> && std::is_trivially_copyable_v<ValueType>);
+
+  // The value array starts after room for GetArrayCapacity() keys.
+  KeyType *Keys() { return reinterpret_cast<KeyType *>(data_); }
+  const KeyType *Keys() const { return reinterpret_cast<const KeyType *>(data_); }
+  ValueType *Values() { return reinterpret_cast<ValueType *>(data_ + sizeof(KeyType) * GetArrayCapacity()); }
+  const ValueType *Values() const {
+    return reinterpret_cast<const ValueType *>(data_ + sizeof(KeyType) * GetArrayCapacity());
+  }
+
   page_id_t next_page_id_;
-  // `array` is the name of the variable. The syntax is the same as `MappingType arr[0]` or `int arr[0]`.
-  // To assign `array` to another variable, you must use `const`, since `array` is constant. Example:
-  // `const MappingType *ptr = array;`.
-  MappingType array[0];
+  KeyType high_key_;
+  // Key array followed by the value array, see the page format above.
+  alignas(KeyType) char data_[0];
 };
 }  // namespace miniKV
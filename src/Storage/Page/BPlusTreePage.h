@@ -57,6 +57,11 @@ class BPlusTreePage {
   page_id_t GetPageId() const;
   void SetPageId(page_id_t page_id);
 
+ protected:
+  // Entries the key and value arrays of the page have room for, GetMaxSize() + 1. Inline, the array
+  // accessors of the pages compute it on every access.
+  int GetArrayCapacity() const { return page_type_ == IndexPageType::LEAF_PAGE ? max_size_ : max_size_ + 1; }
+
  private:
   // member variable, attributes that both internal and leaf page share
   IndexPageType page_type_;
@@ -0,0 +1,78 @@
+#include "Storage/Page/HeaderPage.h"
+
+#include <cstring>
+
+namespace miniKV {
+
+/**
+ * Record related
+ */
+bool HeaderPage::InsertRecord(const std::string &name, page_id_t root_id, size_t page_size) {
+  MINIKV_ASSERT(name.length() < MAX_NAME_SIZE, "index name too long");
+  // check for duplicate name
+  if (FindRecord(name) != -1) {
+    return false;
+  }
+  int record_num = GetRecordCount();
+  if (record_num >= MaxRecordsFor(page_size)) {
+    return false;
+  }
+  char *record = RecordAt(record_num);
+  memset(record, 0, MAX_NAME_SIZE);
+  memcpy(record, name.c_str(), name.length());
+  memcpy(record + MAX_NAME_SIZE, &root_id, sizeof(page_id_t));
+  SetRecordCount(record_num + 1);
+  return true;
+}
+
+bool HeaderPage::DeleteRecord(const std::string &name) {
+  int record_num = GetRecordCount();
+  int index = FindRecord(name);
+  // record does not exist
+  if (index == -1) {
+    return false;
+  }
+  memmove(RecordAt(index), RecordAt(index + 1), (record_num - index - 1) * RECORD_SIZE);
+  SetRecordCount(record_num - 1);
+  return true;
+}
+
+bool HeaderPage::UpdateRecord(const std::string &name, page_id_t root_id) {
+  int index = FindRecord(name);
+  // record does not exist
+  if (index == -1) {
+    return false;
+  }
+  memcpy(RecordAt(index) + MAX_NAME_SIZE, &root_id, sizeof(page_id_t));
+  return true;
+}
+
+bool HeaderPage::GetRootId(const std::string &name, page_id_t *root_id) const {
+  int index = FindRecord(name);
+  // record does not exist
+  if (index == -1) {
+    return false;
+  }
+  memcpy(root_id, RecordAt(index) + MAX_NAME_SIZE, sizeof(page_id_t));
+  return true;
+}
+
+/**
+ * helper functions
+ */
+int HeaderPage::GetRecordCount() const { return record_count_; }
+
+void HeaderPage::SetRecordCount(int record_count) { record_count_ = record_count; }
+
+int HeaderPage::FindRecord(const std::string &name) const {
+  int record_num = GetRecordCount();
+  for (int i = 0; i < record_num; i++) {
+    const char *raw_name = RecordAt(i);
+    if (strncmp(raw_name, name.c_str(), MAX_NAME_SIZE) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace miniKV
@@ -0,0 +1,56 @@
+#ifndef MINIKV_HEADERPAGE_H
+#define MINIKV_HEADERPAGE_H
+
+#include <string>
+
+#include "Common/Config.h"
+
+namespace miniKV {
+
+/**
+ * The header page is page HEADER_PAGE_ID of a database, it maps index names to root page ids,
+ * so a B+ tree finds its root again when the database is reopened.
+ *
+ * Format (size in byte):
+ * ----------------------------------------------------------------
+ * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
+ * ----------------------------------------------------------------
+ */
+class HeaderPage {
+ public:
+  // After creating the header page from buffer pool, must call initialize method
+  void Init() { SetRecordCount(0); }
+
+  // record related, InsertRecord fails on a duplicate name or when the page of page_size bytes is full
+  bool InsertRecord(const std::string &name, page_id_t root_id, size_t page_size);
+  bool DeleteRecord(const std::string &name);
+  bool UpdateRecord(const std::string &name, page_id_t root_id);
+
+  // return root_id if success
+  bool GetRootId(const std::string &name, page_id_t *root_id) const;
+  int GetRecordCount() const;
+
+  static constexpr size_t MAX_NAME_SIZE = 32;
+
+  // number of records fitting in a header page of page_size bytes
+  static int MaxRecordsFor(size_t page_size) {
+    return static_cast<int>((page_size - sizeof(record_count_)) / RECORD_SIZE);
+  }
+
+ private:
+  // helper functions
+  int FindRecord(const std::string &name) const;
+  void SetRecordCount(int record_count);
+
+  char *RecordAt(int index) { return records_ + index * RECORD_SIZE; }
+  const char *RecordAt(int index) const { return records_ + index * RECORD_SIZE; }
+
+  static constexpr size_t RECORD_SIZE = MAX_NAME_SIZE + sizeof(page_id_t);
+
+  int record_count_;
+  char records_[0];
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_HEADERPAGE_H
@@ -5,6 +5,7 @@
 #ifndef MINIKV_IPAGE_H
 #define MINIKV_IPAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -17,8 +18,12 @@ class Page {
   friend class BufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /**
+   * Constructor.
+   * @param data_ the frame holding the page content, owned by the buffer pool
+   * @param page_size_ size of the frame in bytes
+   */
+  Page(char *data_, size_t page_size_) : data(data_), page_size(page_size_) {}
 
   /** Default destructor. */
   ~Page() = default;
@@ -26,20 +31,29 @@ class Page {
   /** @return the actual data contained within this page */
   inline char *GetData() { return data; }
 
+  /** @return the size of the page content in bytes */
+  inline size_t GetPageSize() const { return page_size; }
+
   /** @return the page id of this page */
-  inline page_id_t GetPageId() { return page_id; }
+  inline page_id_t GetPageId() { return PageIdOf(pin_state.load(std::memory_order_acquire)); }
 
-  /** @return the pin count of this page */
-  inline int GetPinCount() { return pin_count; }
+  /** @return the pin count of this page, -1 if the frame does not hold a page */
+  inline int GetPinCount() { return PinCountOf(pin_state.load(std::memory_order_acquire)); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
-  inline bool IsDirty() { return is_dirty; }
+  inline bool IsDirty() { return is_dirty.load(std::memory_order_acquire); }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch.WLock(); }
+  inline void WLatch() {
+    rwlatch.WLock();
+    BeginWrite();
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch.WUnlock(); }
+  inline void WUnlatch() {
+    EndWrite();
+    rwlatch.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch.RLock(); }
@@ -47,6 +61,19 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch.RUnlock(); }
 
+  /**
+   * Version of the content, for optimistic readers that neither latch nor pin the page. It is odd while
+   * the page is write latched or the frame does not hold a loaded page, and it changes whenever the
+   * content may have changed. Readers take the version, read the page and validate the version.
+   */
+  inline uint64_t GetVersion() const { return version.load(std::memory_order_acquire); }
+
+  /** @return true if the version is still v, so the reads since GetVersion returned v saw a stable page */
+  inline bool ValidateVersion(uint64_t v) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version.load(std::memory_order_relaxed) == v;
+  }
+
  protected:
   static_assert(sizeof(page_id_t) == 4);
 
@@ -55,13 +82,84 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
-  inline void ResetMemory() { memset(data, OFFSET_PAGE_START, PAGE_SIZE + 16); }
-
-  char data[PAGE_SIZE];
-  page_id_t page_id = -1;
-  int pin_count = 0;
-  bool is_dirty = false;
-  ReaderWriterLatch rwlatch;
+  inline void ResetMemory() { memset(data, OFFSET_PAGE_START, page_size); }
+
+  // The page id in the upper half of pin_state, the pin count in the lower half.
+  static uint64_t PinState(page_id_t page_id, int pin_count) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32 | static_cast<uint32_t>(pin_count);
+  }
+  static page_id_t PageIdOf(uint64_t state) { return static_cast<page_id_t>(state >> 32); }
+  static int PinCountOf(uint64_t state) { return static_cast<int>(static_cast<uint32_t>(state)); }
+
+  // Set the page id and the pin count of a frame no one else can pin, it is free, being evicted or being
+  // given its first pin.
+  inline void SetPinState(page_id_t page_id, int pin_count) {
+    pin_state.store(PinState(page_id, pin_count), std::memory_order_release);
+  }
+
+  // Pin the frame if it holds page_id and is not free or being evicted. The page id is checked by the same
+  // compare-and-swap that pins, so a stale page table hint never pins a frame holding another page.
+  inline bool TryPin(page_id_t page_id) {
+    uint64_t state = pin_state.load(std::memory_order_acquire);
+    do {
+      if (PageIdOf(state) != page_id || PinCountOf(state) < 0) {
+        return false;
+      }
+    } while (!pin_state.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel));
+    return true;
+  }
+
+  // Add a pin to a frame in the page table, the buffer pool latch is held, so it is not being evicted.
+  inline void AddPin() { pin_state.fetch_add(1, std::memory_order_acq_rel); }
+
+  // Drop a pin of page_id, fails if the frame does not hold page_id or is not pinned.
+  // Sequentially consistent with delete_pending, see BufferPoolManager::DeletePage.
+  // @param[out] last true if this was the last pin
+  inline bool DropPin(page_id_t page_id, bool *last) {
+    uint64_t state = pin_state.load(std::memory_order_acquire);
+    do {
+      if (PageIdOf(state) != page_id || PinCountOf(state) <= 0) {
+        return false;
+      }
+    } while (!pin_state.compare_exchange_weak(state, state - 1, std::memory_order_seq_cst));
+    *last = PinCountOf(state) == 1;
+    return true;
+  }
+
+  // Mark an unpinned frame as being evicted or deleted, pin count -1, fails if it is pinned or free.
+  inline bool TryEvict() {
+    uint64_t state = pin_state.load(std::memory_order_acquire);
+    do {
+      if (PinCountOf(state) != 0) {
+        return false;
+      }
+    } while (!pin_state.compare_exchange_weak(state, PinState(PageIdOf(state), -1), std::memory_order_seq_cst));
+    return true;
+  }
+
+  // Make the version odd before the content changes, the frame is write latched or unpinned.
+  inline void BeginWrite() {
+    uint64_t v = version.load(std::memory_order_relaxed);
+    if (v % 2 == 0) {
+      version.store(v + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+  }
+
+  // Make the version even again, publishing the content written since BeginWrite.
+  inline void EndWrite() { version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  char *data;
+  size_t page_size;
+  // pin_state and is_dirty are read by the lock-free hit path of BufferPoolManager,
+  // they are only changed under the buffer pool latch, except for pinning and unpinning.
+  // A pin count of -1: the frame is free or being evicted, so it cannot be pinned.
+  std::atomic<uint64_t> pin_state{PinState(INVALID_PAGE_ID, -1)};
+  std::atomic<bool> is_dirty{false};
+  std::atomic<bool> delete_pending{false};  // DeletePage found the page pinned, its last unpin deletes it
+  std::atomic<bool> io_in_progress{false};  // content is being read or written back outside the latch
+  std::atomic<uint64_t> version{1};         // see GetVersion, frames start without a page
+  ReaderWriterLatch rwlatch;               // on a cache line of its own, apart from version
 };
 
 }  // namespace miniKV
@@ -0,0 +1,136 @@
+#include "Util/ExternalSort.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace miniKV {
+
+// Records read from a run file at a time.
+static constexpr size_t RUN_BLOCK_SIZE = 64 * 1024;
+
+ExternalSorter::ExternalSorter(std::string path_prefix_, size_t run_size_)
+    : path_prefix(std::move(path_prefix_)), run_size(std::max<size_t>(1, run_size_)) {}
+
+ExternalSorter::~ExternalSorter() {
+  for (auto &run : runs) {
+    if (run.file != nullptr) {
+      fclose(run.file);
+    }
+    remove(run.path.c_str());
+  }
+}
+
+void ExternalSorter::Add(key_t key, value_t value) {
+  MINIKV_ASSERT(!sorted, "records cannot be added after Sort()");
+  buffer.emplace_back(key, value);
+  if (buffer.size() == run_size) {
+    SpillRun();
+  }
+}
+
+void ExternalSorter::SortBuffer() {
+  std::stable_sort(buffer.begin(), buffer.end(),
+                   [](const Record &a, const Record &b) { return a.first < b.first; });
+  auto end = std::unique(buffer.begin(), buffer.end(),
+                         [](const Record &a, const Record &b) { return a.first == b.first; });
+  buffer.erase(end, buffer.end());
+}
+
+void ExternalSorter::SpillRun() {
+  SortBuffer();
+  Run run;
+  run.path = path_prefix + ".run" + std::to_string(runs.size());
+  run.file = fopen(run.path.c_str(), "w+b");
+  if (run.file == nullptr) {
+    throw std::runtime_error("can't create " + run.path + ": " + strerror(errno));
+  }
+  runs.push_back(std::move(run));
+  if (fwrite(buffer.data(), sizeof(Record), buffer.size(), runs.back().file) != buffer.size()) {
+    throw std::runtime_error("can't write " + runs.back().path + ": " + strerror(errno));
+  }
+  buffer.clear();
+}
+
+size_t ExternalSorter::Sort() {
+  sorted = true;
+  if (runs.empty()) {
+    SortBuffer();
+    buffer_position = 0;
+    return buffer.size();
+  }
+
+  if (!buffer.empty()) {
+    SpillRun();
+  }
+  buffer.shrink_to_fit();
+  // Count the distinct keys with a first merge pass, the caller can then size its output.
+  StartMerge();
+  size_t count = 0;
+  key_t key;
+  value_t value;
+  while (Next(&key, &value)) {
+    count++;
+  }
+  StartMerge();
+  return count;
+}
+
+void ExternalSorter::StartMerge() {
+  heap = decltype(heap)();
+  has_last_key = false;
+  for (size_t i = 0; i < runs.size(); ++i) {
+    rewind(runs[i].file);
+    runs[i].block.clear();
+    runs[i].position = 0;
+    if (FillBlock(&runs[i])) {
+      heap.emplace(runs[i].block[0].first, i);
+    }
+  }
+}
+
+bool ExternalSorter::FillBlock(Run *run) {
+  if (run->position < run->block.size()) {
+    return true;
+  }
+  run->block.resize(RUN_BLOCK_SIZE);
+  size_t read = fread(run->block.data(), sizeof(Record), RUN_BLOCK_SIZE, run->file);
+  run->block.resize(read);
+  run->position = 0;
+  return read > 0;
+}
+
+bool ExternalSorter::Next(key_t *key, value_t *value) {
+  MINIKV_ASSERT(sorted, "Sort() must be called before Next()");
+  if (runs.empty()) {
+    if (buffer_position == buffer.size()) {
+      return false;
+    }
+    *key = buffer[buffer_position].first;
+    *value = buffer[buffer_position].second;
+    buffer_position++;
+    return true;
+  }
+
+  while (!heap.empty()) {
+    size_t index = heap.top().second;
+    heap.pop();
+    Run &run = runs[index];
+    Record record = run.block[run.position++];
+    if (FillBlock(&run)) {
+      heap.emplace(run.block[run.position].first, index);
+    }
+    // Runs are free of duplicates, a key seen before comes from an earlier run.
+    if (!has_last_key || record.first != last_key) {
+      has_last_key = true;
+      last_key = record.first;
+      *key = record.first;
+      *value = record.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace miniKV
@@ -0,0 +1,85 @@
+#ifndef MINIKV_EXTERNALSORT_H
+#define MINIKV_EXTERNALSORT_H
+
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Common/Config.h"
+
+namespace miniKV {
+
+/**
+ * ExternalSorter sorts key-value records by key with a bounded amount of memory.
+ * Records are sorted in memory in runs of run_size records, and full runs are written to temporary
+ * files named after path_prefix. Next() merges the runs. Of records with the same key, the one added
+ * first is kept.
+ */
+class ExternalSorter {
+ public:
+  using Record = std::pair<key_t, value_t>;
+
+  explicit ExternalSorter(std::string path_prefix, size_t run_size = EXTERNAL_SORT_RUN_SIZE);
+
+  /** Remove the run files. */
+  ~ExternalSorter();
+
+  DISALLOW_COPY_AND_MOVE(ExternalSorter);
+
+  /** Add a record, Sort() must not have been called. */
+  void Add(key_t key, value_t value);
+
+  /**
+   * Finish adding records and prepare the merge.
+   * @return number of distinct keys, the number of records Next() returns
+   */
+  size_t Sort();
+
+  /**
+   * Get the next record in key order.
+   * @return false after the last record
+   */
+  bool Next(key_t *key, value_t *value);
+
+  /** @return number of runs written to files */
+  size_t GetRunCount() const { return runs.size(); }
+
+ private:
+  // A sorted run in a file, read a block at a time.
+  struct Run {
+    std::string path;
+    FILE *file = nullptr;
+    std::vector<Record> block;
+    size_t position = 0;
+  };
+
+  /** Sort the buffered records and write them to a new run file. */
+  void SpillRun();
+
+  /** Rewind every run and fill the merge heap with their first records. */
+  void StartMerge();
+
+  /** @return false if the run has no record left, otherwise its current record is valid */
+  bool FillBlock(Run *run);
+
+  /** Sort buffer by key, dropping the records whose key was added before. */
+  void SortBuffer();
+
+  std::string path_prefix;
+  size_t run_size;
+  bool sorted = false;
+  std::vector<Record> buffer;  // records of the run being built, or all records if nothing was spilled
+  size_t buffer_position = 0;
+  std::vector<Run> runs;
+  // (key, run index) of the current record of every run not exhausted, earlier runs win ties
+  std::priority_queue<std::pair<key_t, size_t>, std::vector<std::pair<key_t, size_t>>, std::greater<>> heap;
+  bool has_last_key = false;
+  key_t last_key = 0;
+};
+
+}  // namespace miniKV
+
+#endif  // MINIKV_EXTERNALSORT_H
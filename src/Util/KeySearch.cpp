@@ -0,0 +1,94 @@
+#include "Util/KeySearch.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MINIKV_KEYSEARCH_X86
+#endif
+
+namespace miniKV {
+
+// Keys the vector kernels compare after the binary search, one AVX2 compare. Windows of 8 and 16 keys measured
+// slower since keys are contiguous.
+static constexpr size_t SIMD_WINDOW = 4;
+
+size_t CountNotGreaterScalar(const int64_t *keys, size_t count, int64_t key) {
+  if (count == 0) {
+    return 0;
+  }
+  const int64_t *base = NarrowNotGreater(keys, &count, key, 1);
+  return (base - keys) + (*base <= key);
+}
+
+#ifdef MINIKV_KEYSEARCH_X86
+__attribute__((target("avx2,popcnt"))) static size_t CountNotGreaterAVX2(const int64_t *keys, size_t count,
+                                                                          int64_t key) {
+  const int64_t *base = NarrowNotGreater(keys, &count, key, SIMD_WINDOW);
+  const __m256i needle = _mm256_set1_epi64x(key);
+  size_t greater = 0;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i window = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base + i));
+    greater += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(window, needle))));
+  }
+  for (; i < count; ++i) {
+    greater += base[i] > key;
+  }
+  return (base - keys) + count - greater;
+}
+
+[[maybe_unused]] __attribute__((target("sse4.2,popcnt"))) static size_t CountNotGreaterSSE42(
+    const int64_t *keys, size_t count, int64_t key) {
+  const int64_t *base = NarrowNotGreater(keys, &count, key, SIMD_WINDOW);
+  const __m128i needle = _mm_set1_epi64x(key);
+  size_t greater = 0;
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128i window = _mm_loadu_si128(reinterpret_cast<const __m128i *>(base + i));
+    greater += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(window, needle))));
+  }
+  for (; i < count; ++i) {
+    greater += base[i] > key;
+  }
+  return (base - keys) + count - greater;
+}
+#endif
+
+namespace {
+
+using CountFunction = size_t (*)(const int64_t *, size_t, int64_t);
+
+struct Kernel {
+  CountFunction function;
+  const char *name;
+};
+
+Kernel SelectKernel() {
+#if defined(__AVX2__)
+  return {CountNotGreaterAVX2, "avx2"};
+#elif defined(MINIKV_KEYSEARCH_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {CountNotGreaterAVX2, "avx2"};
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return {CountNotGreaterSSE42, "sse4.2"};
+  }
+#endif
+  return {CountNotGreaterScalar, "scalar"};
+}
+
+const Kernel kernel = SelectKernel();
+
+}  // namespace
+
+size_t CountNotGreater(const int64_t *keys, size_t count, int64_t key) {
+#if defined(__AVX2__)
+  return CountNotGreaterAVX2(keys, count, key);
+#else
+  return kernel.function(keys, count, key);
+#endif
+}
+
+const char *KeySearchKernel() { return kernel.name; }
+
+}  // namespace miniKV
@@ -0,0 +1,45 @@
+#ifndef MINIKV_KEYSEARCH_H
+#define MINIKV_KEYSEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace miniKV {
+
+/**
+ * Branch-free binary search over sorted keys. Narrows keys down to a window of at most window keys,
+ * such that the keys before the window are not greater than key and the keys after it are greater. The
+ * comparison selects the next window with a conditional move instead of a branch, so a descent does not
+ * pay for mispredicted branches.
+ * @param[in,out] count number of keys, then size of the window
+ * @return start of the window
+ */
+template <typename Key>
+inline const Key *NarrowNotGreater(const Key *base, size_t *count, const Key &key, size_t window) {
+  size_t n = *count;
+  while (n > window) {
+    size_t half = n / 2;
+    base = key < base[half] ? base : base + half;
+    n -= half;
+  }
+  *count = n;
+  return base;
+}
+
+/**
+ * Count the keys not greater than key, which is the index upper_bound returns, keys are sorted.
+ * The search is a branch-free binary search down to a window of a few keys, which are compared all
+ * at once with AVX2 or SSE4.2. The kernel is AVX2 when compiling for it, otherwise it is chosen when
+ * the program starts by what the CPU supports. CPUs other than x86-64 run CountNotGreaterScalar.
+ */
+size_t CountNotGreater(const int64_t *keys, size_t count, int64_t key);
+
+/** Portable CountNotGreater, a branch-free binary search down to a single key. */
+size_t CountNotGreaterScalar(const int64_t *keys, size_t count, int64_t key);
+
+/** @return name of the kernel CountNotGreater runs: "avx2", "sse4.2" or "scalar" */
+const char *KeySearchKernel();
+
+}  // namespace miniKV
+
+#endif  // MINIKV_KEYSEARCH_H
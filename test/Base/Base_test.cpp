@@ -4,10 +4,13 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
 #include <thread>
 #include <vector>
 
 #include "Base/BoundedQueue.h"
+#include "Base/ReaderWriterLatch.h"
 
 template <typename... Args>
 void LaunchParallelThreads(std::vector<std::thread> &threads, size_t num_threads, Args &&...args) {
@@ -54,4 +57,58 @@ TEST(BaseTest, BoundedQueuePushTest) {
   WaitThreadFinish(threads);
 
   ASSERT_EQ(values.size(), queue_size * thread_num);
-}
\ No newline at end of file
+}
+
+TEST(BaseTest, ReaderWriterLatchSharedReadersTest) {
+  ReaderWriterLatch latch;
+  latch.RLock();
+  latch.RLock();  // readers share the latch
+
+  std::atomic<bool> writer_in{false};
+  std::thread writer([&] {
+    latch.WLock();
+    writer_in = true;
+    latch.WUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(writer_in);  // parked until both readers leave
+  latch.RUnlock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(writer_in);
+  latch.RUnlock();
+  writer.join();
+  EXPECT_TRUE(writer_in);
+}
+
+TEST(BaseTest, ReaderWriterLatchExclusionTest) {
+  const int thread_num = 8;
+  const int rounds = 20000;
+  ReaderWriterLatch latch;
+  int64_t counter = 0;       // changed only under the write latch
+  int64_t shadow = 0;        // always equal to counter outside the write latch
+  std::atomic<int> torn{0};  // reads that saw a writer inside
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < thread_num; ++tid) {
+    threads.emplace_back([&, tid] {
+      for (int i = 0; i < rounds; ++i) {
+        if ((i + tid) % 4 == 0) {
+          latch.WLock();
+          counter++;
+          shadow++;
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          if (counter != shadow) {
+            torn++;
+          }
+          latch.RUnlock();
+        }
+      }
+    });
+  }
+  WaitThreadFinish(threads);
+
+  EXPECT_EQ(torn, 0);
+  EXPECT_EQ(counter, thread_num * rounds / 4);
+}
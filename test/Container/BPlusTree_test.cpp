@@ -5,6 +5,14 @@
 #include "Container/BPlusTree.h"
 
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -32,4 +40,742 @@ TEST(BPlusTreeTest, InsertTest1) {
   delete transaction;
   remove("test.db");
 }
-}  // namespace miniKV
\ No newline at end of file
+
+TEST(BPlusTreeTest, PageSizeTest) {
+  remove("test.db");
+  DatabaseOptions options;
+  options.page_size = 4096;
+  auto disk_manager = std::make_shared<DiskManager>("test.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(50, disk_manager);
+  EXPECT_EQ(4096, bpm->GetPageSize());
+
+  // Node capacities follow the page size, so many leaves and a few levels are needed.
+  BPlusTree<key_t, value_t> tree{bpm};
+  key_t max_key = 20000;
+  for (key_t key = 0; key < max_key; ++key) {
+    EXPECT_TRUE(tree.Insert(key, static_cast<value_t>(key)));
+  }
+  for (key_t key = 0; key < max_key; ++key) {
+    value_t value;
+    EXPECT_TRUE(tree.GetValue(key, value));
+    EXPECT_EQ(static_cast<value_t>(key), value);
+  }
+  using LeafPage = BPlusTreeLeafPage<key_t, value_t>;
+  EXPECT_LE(max_key / LeafPage::MaxSizeFor(4096), disk_manager->AllocatePage());
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, PageReuseTest) {
+  remove("test.db");
+  DatabaseOptions options;
+  options.page_size = 4096;
+  auto disk_manager = std::make_shared<DiskManager>("test.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(50, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm};
+
+  // Pages freed by merges are reused, so inserting and removing the same keys does not grow the file.
+  // Page 0 is never freed, it is the header page of a database, so the first root takes one more page.
+  key_t max_key = 20000;
+  page_id_t first_round_pages = 0;
+  for (int round = 0; round < 3; ++round) {
+    for (key_t key = 0; key < max_key; ++key) {
+      EXPECT_TRUE(tree.Insert(key, static_cast<value_t>(key)));
+    }
+    if (round == 0) {
+      first_round_pages = disk_manager->GetNextPageId();
+    }
+    EXPECT_LE(disk_manager->GetNextPageId(), first_round_pages + 1);
+    for (key_t key = 0; key < max_key; ++key) {
+      tree.Remove(key);
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+    EXPECT_EQ(static_cast<size_t>(disk_manager->GetNextPageId() - 1), disk_manager->GetFreePageCount());
+  }
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, ReusedPageRootSplitTest) {
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(50, disk_manager);
+  ASSERT_NE(nullptr, bpm->NewPage());  // page 0 is never freed, keep it out of the way
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  BPlusTree<key_t, value_t> freed{bpm, 4, 4};
+  BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+
+  // The root leaf of tree has a higher page id than the page freed by the other tree, so the right
+  // half of the root split reuses a lower id than the left half.
+  EXPECT_TRUE(freed.Insert(0, 0));
+  EXPECT_TRUE(tree.Insert(0, 0));
+  freed.Remove(0);
+  ASSERT_EQ(1, disk_manager->GetFreePageCount());
+  key_t max_key = 8;
+  for (key_t key = 1; key < max_key; ++key) {
+    EXPECT_TRUE(tree.Insert(key, static_cast<value_t>(key)));
+  }
+  EXPECT_EQ(0, disk_manager->GetFreePageCount());
+
+  for (key_t key = 0; key < max_key; ++key) {
+    value_t value;
+    EXPECT_TRUE(tree.GetValue(key, value));
+    EXPECT_EQ(static_cast<value_t>(key), value);
+  }
+  key_t expected = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it) {
+    EXPECT_EQ(expected++, it->first);
+  }
+  EXPECT_EQ(max_key, expected);
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, HeaderPageFullTest) {
+  remove("test.db");
+  DatabaseOptions options;
+  options.page_size = 4096;
+  auto disk_manager = std::make_shared<DiskManager>("test.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(50, disk_manager);
+  auto header_page = bpm->NewPage();
+  ASSERT_EQ(HEADER_PAGE_ID, header_page->GetPageId());
+  reinterpret_cast<HeaderPage *>(header_page->GetData())->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  // Every named tree keeps a record in the header page, one more than fits is refused.
+  int max_records = HeaderPage::MaxRecordsFor(options.page_size);
+  for (int i = 0; i < max_records; ++i) {
+    BPlusTree<key_t, value_t> tree{"index_" + std::to_string(i), bpm};
+    EXPECT_TRUE(tree.Insert(i, static_cast<value_t>(i)));
+  }
+  BPlusTree<key_t, value_t> tree{"index_" + std::to_string(max_records), bpm};
+  EXPECT_THROW(tree.Insert(max_records, static_cast<value_t>(max_records)), std::runtime_error);
+
+  auto page = bpm->FetchPageRead(HEADER_PAGE_ID);
+  const auto *records = page.As<HeaderPage>();
+  EXPECT_EQ(max_records, records->GetRecordCount());
+  for (int i = 0; i < max_records; ++i) {
+    page_id_t root_id = INVALID_PAGE_ID;
+    EXPECT_TRUE(records->GetRootId("index_" + std::to_string(i), &root_id));
+    EXPECT_NE(INVALID_PAGE_ID, root_id);
+  }
+  page_id_t root_id = INVALID_PAGE_ID;
+  EXPECT_FALSE(records->GetRootId("index_" + std::to_string(max_records), &root_id));
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, BulkLoadTest) {
+  remove("test.db");
+  DatabaseOptions options;
+  options.page_size = 4096;
+  auto disk_manager = std::make_shared<DiskManager>("test.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(50, disk_manager);
+
+  // Tiny nodes give a deep tree, 4 KB nodes a wide one, both with levels that do not divide evenly.
+  for (size_t max_size : {3, 0}) {
+    BPlusTree<key_t, value_t> tree{bpm, max_size, max_size};
+    std::vector<std::pair<key_t, value_t>> entries;
+    for (key_t key = 0; key < 20011; ++key) {
+      entries.emplace_back(key * 2, static_cast<value_t>(key));
+    }
+    tree.BulkLoad(entries.begin(), entries.end());
+    EXPECT_THROW(tree.BulkLoad(entries.begin(), entries.end()), std::runtime_error);
+
+    for (auto &entry : entries) {
+      value_t value;
+      EXPECT_TRUE(tree.GetValue(entry.first, value));
+      EXPECT_EQ(entry.second, value);
+      EXPECT_FALSE(tree.GetValue(entry.first + 1, value));
+    }
+
+    // The loaded tree takes inserts and removes like any other.
+    for (key_t key = 1; key < 2000; key += 2) {
+      EXPECT_TRUE(tree.Insert(key, static_cast<value_t>(key)));
+    }
+    for (key_t key = 0; key < 40022; key += 4) {
+      tree.Remove(key);
+    }
+    for (key_t key = 0; key < 40022; key += 2) {
+      value_t value;
+      EXPECT_EQ(key % 4 != 0, tree.GetValue(key, value));
+    }
+  }
+
+  BPlusTree<key_t, value_t> tree{bpm};
+  std::vector<std::pair<key_t, value_t>> unsorted{{1, 1}, {3, 3}, {2, 2}};
+  EXPECT_THROW(tree.BulkLoad(unsorted.begin(), unsorted.end()), std::runtime_error);
+  std::vector<std::pair<key_t, value_t>> duplicates{{1, 1}, {1, 2}};
+  EXPECT_THROW(tree.BulkLoad(duplicates.begin(), duplicates.end()), std::runtime_error);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, AppendTest) {
+  remove("test.db");
+  DatabaseOptions options;
+  options.page_size = 4096;
+  auto disk_manager = std::make_shared<DiskManager>("test.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(50, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm};
+
+  // Increasing keys split only the new key off the last leaf, so every other leaf stays full.
+  using LeafPage = BPlusTreeLeafPage<key_t, value_t>;
+  key_t max_key = 20000;
+  for (key_t key = 0; key < max_key; key += 2) {
+    EXPECT_TRUE(tree.Insert(key, static_cast<value_t>(key)));
+  }
+  EXPECT_FALSE(tree.Insert(max_key - 2, 0));
+  EXPECT_GE(max_key / 2 / (LeafPage::MaxSizeFor(4096) - 1) + 3, disk_manager->GetNextPageId());
+
+  // Full leaves split evenly when keys are inserted between their keys.
+  for (key_t key = 1; key < max_key; key += 2) {
+    EXPECT_TRUE(tree.Insert(key, static_cast<value_t>(key)));
+  }
+  for (key_t key = 0; key < max_key; key += 3) {
+    tree.Remove(key);
+  }
+  for (key_t key = 0; key < max_key; ++key) {
+    value_t value;
+    EXPECT_EQ(key % 3 != 0, tree.GetValue(key, value));
+    if (key % 3 != 0) {
+      EXPECT_EQ(static_cast<value_t>(key), value);
+    }
+  }
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, IndexIteratorTest) {
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(50, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+  EXPECT_TRUE(tree.Begin() == tree.End());
+  EXPECT_TRUE(tree.Begin(0).IsEnd());
+
+  key_t max_key = 5000;
+  for (key_t key = 0; key < max_key; key += 2) {
+    tree.Insert(key, static_cast<value_t>(key));
+  }
+  key_t expected = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it) {
+    EXPECT_EQ(expected, it->first);
+    EXPECT_EQ(static_cast<value_t>(expected), (*it).second);
+    expected += 2;
+  }
+  EXPECT_EQ(max_key, expected);
+
+  // Begin(key) starts at key, or at the next key when key is missing, even in the next leaf.
+  for (key_t key = 0; key < max_key - 2; ++key) {
+    auto it = tree.Begin(key);
+    ASSERT_FALSE(it.IsEnd());
+    EXPECT_EQ(key + key % 2, it->first);
+  }
+  EXPECT_TRUE(tree.Begin(max_key).IsEnd());
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, ConcurrentScanTest) {
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(100, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+
+  // Even keys stay in the tree, while a writer inserts and removes odd keys, splitting and merging the
+  // leaves under the scans. Every scan must return each even key once, in order.
+  key_t max_key = 2000;
+  for (key_t key = 0; key < max_key; key += 2) {
+    tree.Insert(key, static_cast<value_t>(key));
+  }
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int round = 0; round < 10; ++round) {
+      for (key_t key = 1; key < max_key; key += 2) {
+        tree.Insert(key, static_cast<value_t>(key));
+      }
+      for (key_t key = 1; key < max_key; key += 2) {
+        tree.Remove(key);
+      }
+    }
+    done = true;
+  });
+
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 2; ++tid) {
+    readers.emplace_back([&] {
+      do {
+        key_t expected = 0;
+        key_t last = -1;
+        for (auto it = tree.Begin(); !it.IsEnd(); ++it) {
+          ASSERT_LT(last, it->first);
+          last = it->first;
+          if (last % 2 == 0) {
+            ASSERT_EQ(expected, last);
+            expected += 2;
+          }
+        }
+        ASSERT_EQ(max_key, expected);
+      } while (!done);
+    });
+  }
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, OptimisticReadTest) {
+  // A small pool evicts pages under the readers, so lookups also fall back to latching, a large one keeps
+  // every page resident, so they stay optimistic.
+  for (size_t pool_size : {50, 2000}) {
+    remove("test.db");
+    auto disk_manager = std::make_shared<DiskManager>("test.db");
+    auto bpm = std::make_shared<BufferPoolManager>(pool_size, disk_manager);
+    BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+
+    // Even keys stay in the tree, while a writer inserts and removes odd keys, splitting and merging
+    // pages and changing the root under the lookups.
+    key_t max_key = 2000;
+    for (key_t key = 0; key < max_key; key += 2) {
+      tree.Insert(key, static_cast<value_t>(key));
+    }
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+      for (int round = 0; round < 10; ++round) {
+        for (key_t key = 1; key < max_key; key += 2) {
+          tree.Insert(key, static_cast<value_t>(key));
+        }
+        for (key_t key = 1; key < max_key; key += 2) {
+          tree.Remove(key);
+        }
+      }
+      done = true;
+    });
+
+    std::vector<std::thread> readers;
+    for (int tid = 0; tid < 2; ++tid) {
+      readers.emplace_back([&, tid] {
+        std::mt19937 rng(tid);
+        std::uniform_int_distribution<key_t> dist(0, max_key - 1);
+        do {
+          key_t key = dist(rng);
+          value_t value = -1;
+          bool found = tree.GetValue(key, value);
+          if (key % 2 == 0) {
+            ASSERT_TRUE(found) << key;
+          }
+          if (found) {
+            ASSERT_EQ(static_cast<value_t>(key), value);
+          }
+        } while (!done);
+      });
+    }
+    writer.join();
+    for (auto &reader : readers) {
+      reader.join();
+    }
+  }
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, MultiGetTest) {
+  for (size_t pool_size : {50, 2000}) {
+    remove("test.db");
+    auto disk_manager = std::make_shared<DiskManager>("test.db");
+    auto bpm = std::make_shared<BufferPoolManager>(pool_size, disk_manager);
+    BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+
+    key_t max_key = 2000;
+    std::vector<key_t> keys = {3, 1, 2};
+    std::vector<value_t> values(keys.size());
+    uint64_t found = ~uint64_t{0};
+    EXPECT_EQ(0, tree.MultiGet(keys.data(), keys.size(), values.data(), &found));
+    EXPECT_EQ(0, found);
+
+    // Batches of unsorted keys with duplicates, looked up while a writer changes the pages they land on,
+    // as in OptimisticReadTest.
+    for (key_t key = 0; key < max_key; key += 2) {
+      tree.Insert(key, static_cast<value_t>(key));
+    }
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+      for (int round = 0; round < 10; ++round) {
+        for (key_t key = 1; key < max_key; key += 2) {
+          tree.Insert(key, static_cast<value_t>(key));
+        }
+        for (key_t key = 1; key < max_key; key += 2) {
+          tree.Remove(key);
+        }
+      }
+      done = true;
+    });
+
+    std::vector<std::thread> readers;
+    for (int tid = 0; tid < 2; ++tid) {
+      readers.emplace_back([&, tid] {
+        std::mt19937 rng(tid);
+        std::uniform_int_distribution<key_t> dist(-10, max_key + 10);
+        std::vector<key_t> batch(100);
+        std::vector<value_t> batch_values(batch.size());
+        uint64_t batch_found[2];
+        do {
+          for (auto &key : batch) {
+            key = dist(rng);
+          }
+          size_t hits = tree.MultiGet(batch.data(), batch.size(), batch_values.data(), batch_found);
+          size_t expected_hits = 0;
+          for (size_t i = 0; i < batch.size(); ++i) {
+            bool hit = (batch_found[i / 64] >> (i % 64) & 1) != 0;
+            expected_hits += hit;
+            if (batch[i] >= 0 && batch[i] < max_key && batch[i] % 2 == 0) {
+              ASSERT_TRUE(hit) << batch[i];
+            }
+            if (hit) {
+              ASSERT_EQ(static_cast<value_t>(batch[i]), batch_values[i]);
+            }
+          }
+          ASSERT_EQ(expected_hits, hits);
+          ASSERT_EQ(0, batch_found[1] >> (batch.size() - 64));
+        } while (!done);
+      });
+    }
+    writer.join();
+    for (auto &reader : readers) {
+      reader.join();
+    }
+  }
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, WriteBatchTest) {
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(2000, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+
+  // Random puts and deletes, some on the same key in one batch, starting from an empty tree and checked
+  // against a map after every batch. Small nodes make batches split and merge leaves.
+  std::map<key_t, value_t> expected;
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<key_t> dist(0, 2999);
+  WriteBatch<key_t, value_t> batch;
+  for (int round = 0; round < 40; ++round) {
+    batch.Clear();
+    size_t batch_size = std::vector<size_t>{1, 7, 64, 500}[round % 4];
+    for (size_t i = 0; i < batch_size; ++i) {
+      key_t key = dist(rng);
+      if (rng() % 10 < 3) {
+        batch.Delete(key);
+        expected.erase(key);
+      } else {
+        batch.Put(key, static_cast<value_t>(rng()));
+        expected[key] = batch.GetOperations().back().value;
+      }
+    }
+    tree.Write(batch);
+
+    auto entry = expected.begin();
+    for (auto it = tree.Begin(); !it.IsEnd(); ++it, ++entry) {
+      ASSERT_NE(expected.end(), entry);
+      ASSERT_EQ(entry->first, it->first);
+      ASSERT_EQ(entry->second, it->second);
+    }
+    ASSERT_EQ(expected.end(), entry);
+  }
+
+  // Threads write batches of interleaved keys, then delete half of them.
+  BPlusTree<key_t, value_t> shared_tree{bpm, 4, 4};
+  key_t max_key = 8000;
+  int num_threads = 4;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      WriteBatch<key_t, value_t> thread_batch;
+      for (key_t key = tid; key < max_key; key += num_threads) {
+        thread_batch.Put(key, static_cast<value_t>(key));
+        if (thread_batch.Size() == 100) {
+          shared_tree.Write(thread_batch);
+          thread_batch.Clear();
+        }
+      }
+      shared_tree.Write(thread_batch);
+      thread_batch.Clear();
+      for (key_t key = tid; key < max_key; key += 2 * num_threads) {
+        thread_batch.Delete(key);
+      }
+      shared_tree.Write(thread_batch);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  key_t key = 0;
+  for (auto it = shared_tree.Begin(); !it.IsEnd(); ++it) {
+    while (key % (2 * num_threads) < num_threads) {
+      key++;
+    }
+    ASSERT_EQ(key, it->first);
+    EXPECT_EQ(static_cast<value_t>(key), it->second);
+    key++;
+  }
+  EXPECT_EQ(max_key, key);
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, UpsertTest) {
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(2000, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+  value_t value;
+
+  EXPECT_FALSE(tree.Update(1, 1));
+  EXPECT_TRUE(tree.Upsert(1, 1));
+  EXPECT_FALSE(tree.Upsert(1, 2));
+  EXPECT_TRUE(tree.GetValue(1, value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(tree.Insert(1, 3));
+  EXPECT_TRUE(tree.GetValue(1, value));
+  EXPECT_EQ(2, value);
+
+  // Updates of existing keys, in leaves full or not, set values in place and never restart to split.
+  for (key_t key = 0; key < 1000; ++key) {
+    tree.Upsert(key, static_cast<value_t>(key));
+  }
+  uint64_t restarts = tree.GetInsertRestarts();
+  for (key_t key = 0; key < 1000; ++key) {
+    EXPECT_TRUE(tree.Update(key, static_cast<value_t>(-key)));
+    EXPECT_FALSE(tree.Upsert(key, static_cast<value_t>(key * 2)));
+  }
+  EXPECT_FALSE(tree.Update(1000, 0));
+  EXPECT_EQ(restarts, tree.GetInsertRestarts());
+  for (key_t key = 0; key < 1000; ++key) {
+    EXPECT_TRUE(tree.GetValue(key, value));
+    EXPECT_EQ(key * 2, value);
+  }
+
+  // Threads count hits of shared keys with Merge, which must not lose increments, while the first merge of
+  // a key inserts it and splits leaves.
+  auto increment = [](const value_t *count) { return count != nullptr ? *count + 1 : 1; };
+  key_t num_counters = 500;
+  int num_threads = 4;
+  int rounds = 20;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      for (int round = 0; round < rounds; ++round) {
+        for (key_t key = 0; key < num_counters; ++key) {
+          tree.Merge(2000 + (key * 7 + tid) % num_counters, increment);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (key_t key = 0; key < num_counters; ++key) {
+    EXPECT_TRUE(tree.GetValue(2000 + key, value));
+    EXPECT_EQ(num_threads * rounds, value);
+  }
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, ConcurrentInsertTest) {
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(100, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+
+  // Threads insert interleaved keys, most inserts fit their leaf and take the optimistic path, the
+  // others split leaves under it. Every thread also inserts the keys of the next one, half fail as
+  // duplicates.
+  key_t max_key = 8000;
+  int num_threads = 4;
+  std::atomic<int> inserted{0};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      for (key_t key = 0; key < max_key; ++key) {
+        if (key % num_threads == tid || key % num_threads == (tid + 1) % num_threads) {
+          inserted += tree.Insert(key, static_cast<value_t>(key));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(max_key, inserted);
+  EXPECT_LT(0, tree.GetInsertRestarts());
+
+  key_t expected = 0;
+  for (auto it = tree.Begin(); !it.IsEnd(); ++it) {
+    ASSERT_EQ(expected, it->first);
+    EXPECT_EQ(static_cast<value_t>(expected), it->second);
+    expected++;
+  }
+  EXPECT_EQ(max_key, expected);
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, BLinkStressTest) {
+  remove("test.db");
+  DatabaseOptions options;
+  options.page_size = 4096;
+  auto disk_manager = std::make_shared<DiskManager>("test.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(16000, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+
+  // Writers insert random keys, splitting leaves and internal pages without latching their parents,
+  // while readers look up and scan keys that stay in the tree. Lookups may land on a page split since its
+  // parent was read, and must move right to find the key. Multiples of 3 stay, writers insert the others.
+  key_t max_key = 20000;
+  for (key_t key = 0; key < max_key; key += 3) {
+    tree.Insert(key, static_cast<value_t>(key));
+  }
+  std::atomic<int> writers_done{0};
+  int num_writers = 3;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_writers; ++tid) {
+    threads.emplace_back([&, tid] {
+      std::vector<key_t> keys;
+      for (key_t key = 0; key < max_key; ++key) {
+        if (key % 3 != 0 && key / 3 % num_writers == tid) {
+          keys.push_back(key);
+        }
+      }
+      std::shuffle(keys.begin(), keys.end(), std::mt19937(tid));
+      for (auto key : keys) {
+        EXPECT_TRUE(tree.Insert(key, static_cast<value_t>(key))) << key;
+      }
+      writers_done++;
+    });
+  }
+  for (int tid = 0; tid < 2; ++tid) {
+    threads.emplace_back([&, tid] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<key_t> dist(0, max_key / 3 - 1);
+      do {
+        key_t key = dist(rng) * 3;
+        value_t value = -1;
+        ASSERT_TRUE(tree.GetValue(key, value)) << key;
+        ASSERT_EQ(static_cast<value_t>(key), value);
+        key_t expected = key;
+        for (auto it = tree.Begin(key); !it.IsEnd() && expected < key + 300; ++it) {
+          if (it->first % 3 == 0) {
+            ASSERT_EQ(expected, it->first);
+            expected += 3;
+          }
+        }
+      } while (writers_done < num_writers);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  key_t expected = 0;
+  for (auto it = tree.Begin(); !it.IsEnd(); ++it) {
+    ASSERT_EQ(expected, it->first);
+    expected++;
+  }
+  EXPECT_EQ(max_key, expected);
+  for (key_t key = 0; key < max_key; ++key) {
+    value_t value;
+    EXPECT_TRUE(tree.GetValue(key, value));
+  }
+
+  remove("test.db");
+}
+
+TEST(BPlusTreeTest, BLinkMergeStressTest) {
+  remove("test.db");
+  DatabaseOptions options;
+  options.page_size = 4096;
+  auto disk_manager = std::make_shared<DiskManager>("test.db", options);
+  auto bpm = std::make_shared<BufferPoolManager>(2000, disk_manager);
+  BPlusTree<key_t, value_t> tree{bpm, 4, 4};
+
+  // Splits run concurrently with merges: each writer inserts its keys and removes them again, so pages
+  // keep splitting and merging, while the multiples of 64 stay in the tree and must stay visible. The tree
+  // shrinks and grows by levels, the pool holds a fraction of it, so pages are evicted and the pages freed
+  // by merges are reused, by root splits too. The last round removes the even keys of the writers only.
+  key_t max_key = 20000;
+  for (key_t key = 0; key < max_key; key += 64) {
+    tree.Insert(key, static_cast<value_t>(key));
+  }
+  auto kept = [](key_t key) { return key % 64 == 0 || key % 2 == 1; };
+  std::atomic<int> writers_done{0};
+  int num_writers = 3;
+  int rounds = 4;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_writers; ++tid) {
+    threads.emplace_back([&, tid] {
+      std::vector<key_t> keys;
+      for (key_t key = 0; key < max_key; ++key) {
+        if (key % 64 != 0 && key / 64 % num_writers == tid) {
+          keys.push_back(key);
+        }
+      }
+      std::mt19937 rng(tid);
+      for (int round = 0; round < rounds; ++round) {
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (auto key : keys) {
+          EXPECT_TRUE(tree.Insert(key, static_cast<value_t>(key))) << key;
+        }
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (auto key : keys) {
+          if (round < rounds - 1 || !kept(key)) {
+            tree.Remove(key);
+          }
+        }
+      }
+      writers_done++;
+    });
+  }
+  threads.emplace_back([&] {
+    std::mt19937 rng(num_writers);
+    std::uniform_int_distribution<key_t> dist(0, max_key / 64 - 1);
+    do {
+      key_t key = dist(rng) * 64;
+      value_t value = -1;
+      ASSERT_TRUE(tree.GetValue(key, value)) << key;
+      ASSERT_EQ(static_cast<value_t>(key), value);
+    } while (writers_done < num_writers);
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (key_t key = 0; key < max_key; ++key) {
+    value_t value = -1;
+    ASSERT_EQ(kept(key), tree.GetValue(key, value)) << key;
+    if (kept(key)) {
+      EXPECT_EQ(static_cast<value_t>(key), value);
+    }
+  }
+  key_t expected = 0;
+  for (auto it = tree.Begin(); !it.IsEnd(); ++it) {
+    while (!kept(expected)) {
+      expected++;
+    }
+    ASSERT_EQ(expected, it->first);
+    expected++;
+  }
+  while (expected < max_key && !kept(expected)) {
+    expected++;
+  }
+  EXPECT_EQ(max_key, expected);
+
+  remove("test.db");
+}
+}  // namespace miniKV
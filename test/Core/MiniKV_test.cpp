@@ -0,0 +1,210 @@
+#include "Core/MiniKV.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace miniKV {
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(MiniKVTest, ColdStartTest) {
+  remove("test.db");
+  const size_t num_keys = 200000;
+  std::vector<key_t> keys;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(static_cast<key_t>(rng() >> 1));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    MiniKV db("test.db");
+    for (auto key : keys) {
+      EXPECT_TRUE(db.insert(key, static_cast<value_t>(key)));
+    }
+  }
+  double load_seconds = SecondsSince(start);
+
+  // Reopening reads the file header and the header page, not the tree.
+  start = std::chrono::steady_clock::now();
+  {
+    MiniKV db("test.db");
+    double open_seconds = SecondsSince(start);
+    LOG(INFO) << "loaded " << num_keys << " keys in " << load_seconds << " s, reopened in " << open_seconds << " s";
+    EXPECT_LT(open_seconds * 10, load_seconds);
+
+    for (auto key : keys) {
+      EXPECT_EQ(static_cast<value_t>(key), db.get(key));
+    }
+    // New pages are allocated after the existing ones, nothing is overwritten.
+    for (size_t i = 0; i < num_keys / 4; ++i) {
+      EXPECT_TRUE(db.insert(static_cast<key_t>(rng() >> 1) | 1, 1));
+    }
+  }
+
+  {
+    MiniKV db("test.db");
+    for (auto key : keys) {
+      EXPECT_EQ(static_cast<value_t>(key), db.get(key));
+    }
+  }
+  remove("test.db");
+}
+
+TEST(MiniKVTest, ImportTest) {
+  remove("test.db");
+  remove("test.data");
+  const size_t num_keys = 100000;
+  std::vector<key_t> keys;
+  std::mt19937_64 rng(0);
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(static_cast<key_t>(rng() >> 1));
+  }
+
+  // Unsorted records, with a second record for some keys that must not win.
+  FILE *file = fopen("test.data", "wb");
+  for (size_t i = 0; i < num_keys + num_keys / 10; ++i) {
+    key_t key = keys[i % num_keys];
+    auto value = static_cast<value_t>(i < num_keys ? key : -key);
+    fwrite(&key, sizeof(key), 1, file);
+    fwrite(&value, sizeof(value), 1, file);
+  }
+  fclose(file);
+
+  {
+    MiniKV db("test.db");
+    // Small runs, so the records are merged from many run files.
+    EXPECT_EQ(num_keys, db.import("test.data", 8192));
+    for (auto key : keys) {
+      EXPECT_EQ(static_cast<value_t>(key), db.get(key));
+    }
+    EXPECT_THROW(db.import("test.data"), std::runtime_error);
+  }
+
+  {
+    MiniKV db("test.db");
+    for (auto key : keys) {
+      EXPECT_EQ(static_cast<value_t>(key), db.get(key));
+    }
+  }
+  remove("test.db");
+  remove("test.data");
+}
+
+TEST(MiniKVTest, RangeTest) {
+  remove("test.db");
+  {
+    MiniKV db("test.db");
+    for (key_t key = 0; key < 100000; key += 3) {
+      db.insert(key, static_cast<value_t>(key * 2));
+    }
+
+    std::pair<key_t, value_t> buffer[1000];
+    EXPECT_EQ(0u, db.range(10, 5, buffer, 1000));
+    EXPECT_EQ(0u, db.range(100000, 200000, buffer, 1000));
+    EXPECT_EQ(1u, db.range(99999, 200000, buffer, 1000));
+    EXPECT_EQ(4u, db.range(10, 21, buffer, 1000));
+    EXPECT_EQ(12, buffer[0].first);
+    EXPECT_EQ(21, buffer[3].first);
+
+    // A range larger than the buffer is read in parts.
+    key_t expected = 300;
+    for (key_t lo = 299;;) {
+      size_t count = db.range(lo, 60000, buffer, 1000);
+      for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(expected, buffer[i].first);
+        EXPECT_EQ(static_cast<value_t>(expected * 2), buffer[i].second);
+        expected += 3;
+      }
+      if (count < 1000) {
+        break;
+      }
+      lo = buffer[count - 1].first + 1;
+    }
+    EXPECT_EQ(60003, expected);
+  }
+  remove("test.db");
+}
+
+TEST(MiniKVTest, MultiGetTest) {
+  remove("test.db");
+  {
+    MiniKV db("test.db");
+    for (key_t key = 0; key < 100000; key += 3) {
+      db.insert(key, static_cast<value_t>(key * 2));
+    }
+
+    std::vector<key_t> keys;
+    for (key_t key = 100001; key >= -1; key -= 7) {
+      keys.push_back(key);
+    }
+    std::vector<value_t> values(keys.size());
+    std::vector<uint64_t> found((keys.size() + 63) / 64);
+    auto expected_hits = std::count_if(keys.begin(), keys.end(), [](key_t key) { return key >= 0 && key % 3 == 0; });
+    EXPECT_EQ(static_cast<size_t>(expected_hits), db.multi_get(keys.data(), keys.size(), values.data(), found.data()));
+    for (size_t i = 0; i < keys.size(); ++i) {
+      bool hit = keys[i] >= 0 && keys[i] < 100000 && keys[i] % 3 == 0;
+      EXPECT_EQ(hit, (found[i / 64] >> (i % 64) & 1) != 0) << keys[i];
+      EXPECT_EQ(hit ? static_cast<value_t>(keys[i] * 2) : -1, values[i]);
+    }
+  }
+  remove("test.db");
+}
+
+TEST(MiniKVTest, UpdateTest) {
+  remove("test.db");
+  {
+    MiniKV db("test.db");
+    EXPECT_TRUE(db.update(1, 10));
+    EXPECT_FALSE(db.update(1, 20));
+    EXPECT_EQ(20, db.get(1));
+
+    auto increment = [](const value_t *count) { return count != nullptr ? *count + 1 : 1; };
+    EXPECT_TRUE(db.merge(2, increment));
+    EXPECT_FALSE(db.merge(2, increment));
+    EXPECT_FALSE(db.merge(1, increment));
+    EXPECT_EQ(2, db.get(2));
+    EXPECT_EQ(21, db.get(1));
+  }
+  remove("test.db");
+}
+
+TEST(MiniKVTest, WriteTest) {
+  remove("test.db");
+  {
+    MiniKV db("test.db");
+    WriteBatch<key_t, value_t> batch;
+    for (key_t key = 0; key < 100000; ++key) {
+      batch.Put(key, static_cast<value_t>(key));
+    }
+    db.write(batch);
+
+    // Delete every third key, overwrite the others, and put a key twice, the last put wins.
+    batch.Clear();
+    for (key_t key = 100000 - 1; key >= 0; --key) {
+      if (key % 3 == 0) {
+        batch.Delete(key);
+      } else {
+        batch.Put(key, static_cast<value_t>(key * 2));
+      }
+    }
+    batch.Put(100000, 1);
+    batch.Put(100000, 2);
+    db.write(batch);
+
+    for (key_t key = 0; key < 100000; ++key) {
+      EXPECT_EQ(key % 3 == 0 ? -1 : static_cast<value_t>(key * 2), db.get(key));
+    }
+    EXPECT_EQ(2, db.get(100000));
+  }
+  remove("test.db");
+}
+
+}  // namespace miniKV
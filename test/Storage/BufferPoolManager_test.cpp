@@ -1,11 +1,16 @@
 #include "Storage/BufferPool/BufferPoolManager.h"
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <memory>
 #include <random>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "Storage/BufferPool/ParallelBufferPoolManager.h"
 #include "gtest/gtest.h"
 
 namespace miniKV {
@@ -177,6 +182,211 @@ TEST(BufferPoolManagerTest, IsDirty) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, AsyncIOTest) {
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 64;
+  const int num_threads = 8;
+  remove("test.db");
+
+  for (bool use_io_uring : {true, false}) {
+    auto disk_manager = std::make_shared<DiskManager>("test.db", use_io_uring);
+    auto bpm =
+        std::make_shared<BufferPoolManager>(buffer_pool_size, disk_manager, ReplacerType::LRU, /*async_io=*/true);
+
+    // Every page holds its page id and a counter, the pool is much smaller than the pages.
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < num_pages; ++i) {
+      auto page = bpm->NewPage();
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, page->GetData()[0]);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page->GetPageId());
+      page_ids.push_back(page->GetPageId());
+      EXPECT_TRUE(bpm->UnpinPage(page->GetPageId(), true));
+    }
+
+    // Threads only touch their own pages' counters but read every page, so misses, write-backs
+    // and hits on frames still being loaded overlap.
+    std::vector<int> counters(num_pages, 0);
+    std::vector<std::thread> threads;
+    std::atomic<int> errors{0};
+    for (int tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([&, tid]() {
+        std::mt19937 rng(tid);
+        for (int i = 0; i < 2000; ++i) {
+          int index = rng() % num_pages;
+          auto page = bpm->FetchPage(page_ids[index]);
+          if (page == nullptr) {
+            continue;
+          }
+          bool dirty = false;
+          page->WLatch();
+          int page_id;
+          int counter = 0;
+          sscanf(page->GetData(), "%d %d", &page_id, &counter);
+          if (page_id != page_ids[index]) {
+            errors++;
+          }
+          if (index % num_threads == tid) {
+            EXPECT_EQ(counters[index], counter);
+            counters[index]++;
+            snprintf(page->GetData(), PAGE_SIZE, "%d %d", page_id, counters[index]);
+            dirty = true;
+          }
+          page->WUnlatch();
+          EXPECT_TRUE(bpm->UnpinPage(page_ids[index], dirty));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(0, errors);
+
+    bpm->FlushAllPages();
+    char data[PAGE_SIZE];
+    for (int i = 0; i < num_pages; ++i) {
+      disk_manager->ReadPage(page_ids[i], data);
+      int page_id;
+      int counter = 0;
+      sscanf(data, "%d %d", &page_id, &counter);
+      EXPECT_EQ(page_ids[i], page_id);
+      EXPECT_EQ(counters[i], counter);
+    }
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+  const size_t buffer_pool_size = 10;
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(buffer_pool_size, disk_manager);
+
+  // Fill the pool with dirty unpinned pages, the first one stays pinned.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto page = bpm->NewPage();
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page->GetPageId());
+    page_ids.push_back(page->GetPageId());
+    if (i > 0) {
+      EXPECT_TRUE(bpm->UnpinPage(page->GetPageId(), true));
+    }
+  }
+
+  // The cleaner writes every dirty unpinned page, but not the pinned one.
+  bpm->StartPageCleaner(100);
+  for (int i = 0; i < 1000 && bpm->GetBackgroundFlushes() < buffer_pool_size - 1; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm->StopPageCleaner();
+  EXPECT_EQ(buffer_pool_size - 1, bpm->GetBackgroundFlushes());
+
+  // Evicting them needs no inline write, and their content is on disk.
+  for (size_t i = 1; i < buffer_pool_size; ++i) {
+    auto page = bpm->NewPage();
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(bpm->UnpinPage(page->GetPageId(), false));
+  }
+  EXPECT_EQ(0, bpm->GetInlineFlushes());
+  for (size_t i = 1; i < buffer_pool_size; ++i) {
+    auto page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_ids[i])).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+
+  // Without the cleaner, evicting the dirty pinned page is an inline flush.
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], true));
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto page = bpm->NewPage();
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(bpm->UnpinPage(page->GetPageId(), false));
+  }
+  EXPECT_EQ(1, bpm->GetInlineFlushes());
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, DeferredDeleteTest) {
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(4, disk_manager);
+  auto header_page = bpm->NewPage();
+  ASSERT_NE(nullptr, header_page);
+  EXPECT_TRUE(bpm->UnpinPage(header_page->GetPageId(), false));
+
+  // A page deleted while pinned is deleted by its last unpin, not dropped.
+  auto page = bpm->NewPage();
+  ASSERT_NE(nullptr, page);
+  page_id_t page_id = page->GetPageId();
+  EXPECT_FALSE(bpm->DeletePage(page_id));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  EXPECT_EQ(0, disk_manager->GetFreePageCount());
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  EXPECT_EQ(1, disk_manager->GetFreePageCount());
+  EXPECT_EQ(-1, page->GetPinCount());
+
+  // Its id is reused, and the new page is not deleted by the old request.
+  page = bpm->NewPage();
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(page_id, page->GetPageId());
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  EXPECT_EQ(0, disk_manager->GetFreePageCount());
+  EXPECT_EQ(0, page->GetPinCount());
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, StaleHitTest) {
+  remove("test.db");
+  const size_t buffer_pool_size = 8;
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+    auto page = bpm->NewPage();
+    ASSERT_NE(nullptr, page);
+    page_ids.push_back(page->GetPageId());
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_ids.back());
+    EXPECT_TRUE(bpm->UnpinPage(page_ids.back(), true));
+  }
+
+  // Readers keep evicting and reloading pages, so the lock-free page table lookups of the hit path find
+  // frames that already hold another page. Such a lookup must not pin the frame, not even for a moment:
+  // a frame holding an unpinned page can always be deleted.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 3; ++tid) {
+    readers.emplace_back([&, tid] {
+      std::mt19937 rng(tid);
+      while (!stop) {
+        page_id_t page_id = page_ids[rng() % page_ids.size()];
+        auto page = bpm->FetchPage(page_id);
+        if (page != nullptr) {
+          EXPECT_EQ(std::to_string(page_id), page->GetData());
+          EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 20000; ++i) {
+    auto page = bpm->NewPage();
+    if (page == nullptr) {
+      continue;  // every frame is pinned by a reader
+    }
+    page_id_t page_id = page->GetPageId();
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    EXPECT_TRUE(bpm->DeletePage(page_id));
+  }
+  stop = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  remove("test.db");
+}
+
 TEST(BufferPoolManagerTest, HardTest4) {
   const int num_threads = 30;
   const int num_runs = 5000;
@@ -335,4 +545,94 @@ TEST(BufferPoolManagerTest, HardTest4) {
     remove("test.db");
   }
 }
+
+TEST(BufferPoolManagerTest, ParallelSampleTest) {
+  const size_t num_instances = 4;
+  const size_t slot_num = 5;
+
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<ParallelBufferPoolManager>(num_instances, slot_num, disk_manager);
+  EXPECT_EQ(num_instances * slot_num, bpm->GetPoolSize());
+
+  // Scenario: new pages are spread over all instances, so every frame of the pool can be used.
+  std::set<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * slot_num; ++i) {
+    auto page = bpm->NewPage();
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page->GetPageId());
+    page_ids.insert(page->GetPageId());
+  }
+  EXPECT_EQ(num_instances * slot_num, page_ids.size());
+
+  // Scenario: all frames of all instances are pinned.
+  EXPECT_EQ(nullptr, bpm->NewPage());
+
+  // Scenario: a free frame in any instance is enough to create a new page.
+  page_id_t victim = *page_ids.rbegin();
+  EXPECT_EQ(true, bpm->UnpinPage(victim, true));
+  auto page = bpm->NewPage();
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(victim % num_instances, page->GetPageId() % num_instances);
+  EXPECT_EQ(true, bpm->UnpinPage(page->GetPageId(), false));
+
+  // Scenario: the evicted page is read back from the instance that owns it.
+  page = bpm->FetchPage(victim);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(std::to_string(victim), page->GetData());
+
+  for (auto page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(false, bpm->UnpinPage(victim, false));
+
+  remove("test.db");
+}
+
+// Guards pin on construction, unpin on destruction, and hand their pin over when moved.
+TEST(BufferPoolManagerTest, PageGuardTest) {
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(2, disk_manager);
+
+  page_id_t page_id;
+  {
+    auto guard = bpm->NewPageGuarded();
+    ASSERT_TRUE(guard);
+    page_id = guard.PageId();
+    strcpy(guard.GetData(), "guarded");  // NOLINT
+    guard.SetDirty();
+
+    BasicPageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard);  // NOLINT
+    EXPECT_EQ(page_id, moved.PageId());
+  }
+  EXPECT_EQ(false, bpm->UnpinPage(page_id, false));  // unpinned once, by the guard it was moved to
+
+  // Scenario: the page was unpinned dirty, so it is written back when evicted.
+  auto page1 = bpm->NewPage();
+  auto page2 = bpm->NewPage();
+  ASSERT_NE(nullptr, page1);
+  ASSERT_NE(nullptr, page2);
+  EXPECT_FALSE(bpm->FetchPageRead(page_id));  // every frame is pinned
+  EXPECT_EQ(true, bpm->UnpinPage(page1->GetPageId(), false));
+  EXPECT_EQ(true, bpm->UnpinPage(page2->GetPageId(), false));
+
+  {
+    auto reader = bpm->FetchPageRead(page_id);
+    ASSERT_TRUE(reader);
+    EXPECT_STREQ("guarded", reader.As<char>());
+    auto second_reader = bpm->FetchPageRead(page_id);  // read latches are shared
+    ASSERT_TRUE(second_reader);
+    reader = std::move(second_reader);
+  }
+  {
+    auto writer = bpm->FetchPageWrite(page_id);  // would wait forever if a read latch had leaked
+    ASSERT_TRUE(writer);
+    writer.Drop();
+    EXPECT_FALSE(writer);
+  }
+  EXPECT_EQ(false, bpm->UnpinPage(page_id, false));
+
+  remove("test.db");
+}
+
 }  // namespace miniKV
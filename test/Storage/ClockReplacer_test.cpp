@@ -0,0 +1,130 @@
+#include "Storage/BufferPool/ClockReplacer.h"
+
+#include <cstring>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "Storage/BufferPool/BufferPoolManager.h"
+#include "gtest/gtest.h"
+
+namespace miniKV {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer clock_replacer(7);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer.
+  clock_replacer.Unpin(1);
+  clock_replacer.Unpin(2);
+  clock_replacer.Unpin(3);
+  clock_replacer.Unpin(4);
+  clock_replacer.Unpin(5);
+  clock_replacer.Unpin(6);
+  clock_replacer.Unpin(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // Scenario: get three victims from the clock.
+  int value;
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+
+  // Scenario: pin elements in the replacer.
+  // Note that 3 has already been victimized, so pinning 3 should have no effect.
+  clock_replacer.Pin(3);
+  clock_replacer.Pin(4);
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // Scenario: unpin 4. We expect that the reference bit of 4 will be set to 1.
+  clock_replacer.Unpin(4);
+
+  // Scenario: continue looking for victims. We expect these victims.
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+}
+
+TEST(ClockReplacerTest, ConcurrentTest) {
+  const size_t num_pages = 64;
+  const size_t num_threads = 4;
+  ClockReplacer clock_replacer(num_pages);
+
+  // Every thread owns a disjoint set of frames and repeatedly unpins and pins them,
+  // while victims are taken concurrently.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid]() {
+      for (int round = 0; round < 1000; ++round) {
+        for (size_t frame = tid; frame < num_pages; frame += num_threads) {
+          clock_replacer.Unpin(frame);
+        }
+        frame_id_t victim;
+        clock_replacer.Victim(&victim);
+        for (size_t frame = tid; frame < num_pages; frame += num_threads) {
+          clock_replacer.Pin(frame);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+
+  for (size_t frame = 0; frame < num_pages; ++frame) {
+    clock_replacer.Unpin(frame);
+  }
+  EXPECT_EQ(num_pages, clock_replacer.Size());
+  std::set<frame_id_t> victims;
+  frame_id_t victim;
+  while (clock_replacer.Victim(&victim)) {
+    EXPECT_TRUE(victims.insert(victim).second);
+  }
+  EXPECT_EQ(num_pages, victims.size());
+}
+
+TEST(ClockReplacerTest, BufferPoolManagerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto disk_manager = std::make_shared<DiskManager>(db_name);
+  auto bpm = std::make_shared<BufferPoolManager>(buffer_pool_size, disk_manager, ReplacerType::Clock);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto page = bpm->NewPage();
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page->GetPageId());
+    page_ids.push_back(page->GetPageId());
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage());
+
+  // Unpinned pages are evicted and written back, then read again on fetch.
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto page = bpm->NewPage();
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(bpm->UnpinPage(page->GetPageId(), false));
+  }
+  for (auto page_id : page_ids) {
+    auto page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  remove("test.db");
+}
+
+}  // namespace miniKV
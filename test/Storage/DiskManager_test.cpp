@@ -0,0 +1,269 @@
+#include "Storage/Disk/DiskManager.h"
+
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Storage/BufferPool/BufferPoolManager.h"
+#include "gtest/gtest.h"
+
+namespace miniKV {
+
+TEST(DiskManagerTest, ReadWritePageTest) {
+  remove("test.db");
+  DiskManager disk_manager("test.db");
+  std::vector<char> page(PAGE_SIZE);
+  std::vector<char> buffer(PAGE_SIZE);
+
+  for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+    snprintf(page.data(), PAGE_SIZE, "page %d", page_id);
+    page[PAGE_SIZE - 1] = static_cast<char>(page_id);
+    disk_manager.WritePage(page_id, page.data());
+  }
+  disk_manager.Sync();
+
+  for (page_id_t page_id = 7; page_id >= 0; --page_id) {
+    disk_manager.ReadPage(page_id, buffer.data());
+    EXPECT_EQ(0, strcmp(buffer.data(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(static_cast<char>(page_id), buffer[PAGE_SIZE - 1]);
+  }
+
+  // The page right after the end of file reads as zeros, pages further out do not exist.
+  buffer[0] = 'x';
+  disk_manager.ReadPage(8, buffer.data());
+  EXPECT_EQ(0, buffer[0]);
+  EXPECT_THROW(disk_manager.ReadPage(100, buffer.data()), std::runtime_error);
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, AsyncReadWritePageTest) {
+  const page_id_t num_pages = 32;
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    DiskManager disk_manager("test.db", use_io_uring);
+    if (!use_io_uring) {
+      EXPECT_STREQ("thread pool", disk_manager.GetAsyncIO()->Name());
+    }
+
+    std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+    std::vector<std::future<void>> futures;
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      snprintf(pages[page_id].data(), PAGE_SIZE, "page %d", page_id);
+      pages[page_id][PAGE_SIZE - 1] = static_cast<char>(page_id);
+      futures.push_back(disk_manager.WritePageAsync(page_id, pages[page_id].data()));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+    futures.clear();
+
+    std::vector<std::vector<char>> buffers(num_pages + 1, std::vector<char>(PAGE_SIZE, 'x'));
+    for (page_id_t page_id = 0; page_id <= num_pages; ++page_id) {
+      futures.push_back(disk_manager.ReadPageAsync(page_id, buffers[page_id].data()));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      EXPECT_EQ(0, memcmp(pages[page_id].data(), buffers[page_id].data(), PAGE_SIZE))
+          << disk_manager.GetAsyncIO()->Name() << " page " << page_id;
+    }
+    // Reads past the end of file are zero-filled.
+    EXPECT_EQ(0, buffers[num_pages][0]);
+    EXPECT_EQ(0, buffers[num_pages][PAGE_SIZE - 1]);
+  }
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  remove("test.db");
+  auto disk_manager = std::make_shared<DiskManager>("test.db", true, true);
+  EXPECT_TRUE(disk_manager->IsDirectIO());
+
+  // Unaligned buffers go through a bounce buffer.
+  std::vector<char> page(PAGE_SIZE + 1);
+  std::vector<char> buffer(PAGE_SIZE + 1);
+  snprintf(page.data() + 1, PAGE_SIZE, "unaligned");
+  disk_manager->WritePage(0, page.data() + 1);
+  disk_manager->ReadPage(0, buffer.data() + 1);
+  EXPECT_STREQ("unaligned", buffer.data() + 1);
+  disk_manager->ReadPageAsync(0, buffer.data()).get();
+  EXPECT_STREQ("unaligned", buffer.data());
+
+  // Buffer pool frames are aligned and do direct I/O on eviction and fetch, with and without huge pages.
+  for (bool huge_pages : {false, true}) {
+    const size_t buffer_pool_size = 4;
+    BufferPoolManager bpm(buffer_pool_size, disk_manager, ReplacerType::LRU, false, huge_pages);
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < 16; ++i) {
+      auto new_page = bpm.NewPage();
+      ASSERT_NE(nullptr, new_page);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(new_page->GetData()) % DiskManager::IO_ALIGNMENT);
+      snprintf(new_page->GetData(), PAGE_SIZE, "page %d", new_page->GetPageId());
+      page_ids.push_back(new_page->GetPageId());
+      EXPECT_TRUE(bpm.UnpinPage(new_page->GetPageId(), true));
+    }
+    for (auto page_id : page_ids) {
+      auto fetched = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, fetched);
+      EXPECT_EQ(0, strcmp(fetched->GetData(), ("page " + std::to_string(page_id)).c_str()));
+      EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+    }
+    bpm.FlushAllPages();
+  }
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, FileHeaderTest) {
+  remove("test.db");
+  DatabaseOptions options;
+  options.page_size = 8192;
+  options.buffer_pool_size = 16;
+  {
+    DiskManager disk_manager("test.db", options);
+    EXPECT_EQ(8192, disk_manager.GetPageSize());
+    std::vector<char> page(8192);
+    snprintf(page.data(), page.size(), "page 1");
+    EXPECT_EQ(0, disk_manager.AllocatePage());
+    EXPECT_EQ(1, disk_manager.AllocatePage());
+    disk_manager.WritePage(1, page.data());
+  }
+
+  // The stored options and allocation state are used when no options are requested.
+  {
+    DiskManager disk_manager("test.db");
+    EXPECT_EQ(8192, disk_manager.GetPageSize());
+    EXPECT_EQ(16, disk_manager.GetOptions().buffer_pool_size);
+    EXPECT_EQ(2, disk_manager.GetNextPageId());
+    std::vector<char> buffer(8192);
+    disk_manager.ReadPage(1, buffer.data());
+    EXPECT_STREQ("page 1", buffer.data());
+  }
+
+  // The page size cannot change, the buffer pool size can and is stored.
+  options.page_size = 16384;
+  EXPECT_THROW(DiskManager("test.db", options), std::runtime_error);
+  options.page_size = 0;
+  options.buffer_pool_size = 32;
+  { DiskManager disk_manager("test.db", options); }
+  EXPECT_EQ(32, DiskManager("test.db").GetOptions().buffer_pool_size);
+  remove("test.db");
+
+  // Page sizes must suit O_DIRECT, and files without a header are refused.
+  options.page_size = 1000;
+  EXPECT_THROW(DiskManager("test.db", options), std::runtime_error);
+  remove("test.db");
+  FILE *file = fopen("test.db", "w");
+  fputs("not a database", file);
+  fclose(file);
+  EXPECT_THROW(DiskManager("test.db"), std::runtime_error);
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, FreePageTest) {
+  remove("test.db");
+  {
+    DiskManager disk_manager("test.db");
+    for (page_id_t page_id = 0; page_id < 10; ++page_id) {
+      EXPECT_EQ(page_id, disk_manager.AllocatePage());
+    }
+
+    // Freed pages are reused lowest first, shards only get their own pages.
+    disk_manager.DeallocatePage(3);
+    disk_manager.DeallocatePage(6);
+    disk_manager.DeallocatePage(5);
+    EXPECT_EQ(3, disk_manager.GetFreePageCount());
+    EXPECT_EQ(3, disk_manager.AllocatePage());
+    EXPECT_EQ(6, disk_manager.AllocatePage(4, 2));
+    EXPECT_EQ(5, disk_manager.AllocatePage());
+    EXPECT_EQ(10, disk_manager.AllocatePage());
+
+    // Ids skipped to reach a shard's page are free for the others.
+    EXPECT_EQ(14, disk_manager.AllocatePage(4, 2));
+    EXPECT_EQ(11, disk_manager.AllocatePage());
+    EXPECT_EQ(2, disk_manager.GetFreePageCount());
+
+    // The header page and pages never allocated are not freed.
+    disk_manager.DeallocatePage(HEADER_PAGE_ID);
+    disk_manager.DeallocatePage(100);
+    disk_manager.DeallocatePage(4);
+    disk_manager.DeallocatePage(8);
+    EXPECT_EQ(4, disk_manager.GetFreePageCount());
+  }
+
+  // The free pages survive a reopen, and free pages at the end of the file are truncated.
+  {
+    DiskManager disk_manager("test.db");
+    EXPECT_EQ(15, disk_manager.GetNextPageId());
+    EXPECT_EQ(4, disk_manager.GetFreePageCount());
+    disk_manager.DeallocatePage(14);
+    disk_manager.Sync();
+    EXPECT_EQ(12, disk_manager.GetNextPageId());
+    EXPECT_EQ(2, disk_manager.GetFreePageCount());
+    EXPECT_EQ(4, disk_manager.AllocatePage());
+    EXPECT_EQ(8, disk_manager.AllocatePage());
+    EXPECT_EQ(12, disk_manager.AllocatePage());
+  }
+
+  // A page cut off by truncation is free too: the file ends after the last allocated page.
+  {
+    DiskManager disk_manager("test.db");
+    EXPECT_EQ(13, disk_manager.GetNextPageId());
+    EXPECT_EQ(0, disk_manager.GetFreePageCount());
+    for (page_id_t page_id = 1; page_id < 13; ++page_id) {
+      disk_manager.DeallocatePage(page_id);
+    }
+    disk_manager.Sync();
+    EXPECT_EQ(1, disk_manager.GetNextPageId());
+  }
+  FILE *file = fopen("test.db", "r");
+  fseek(file, 0, SEEK_END);
+  EXPECT_EQ(DiskManager::FILE_HEADER_SIZE + PAGE_SIZE, ftell(file));
+  fclose(file);
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, ShardedFreePageTest) {
+  remove("test.db");
+  {
+    DiskManager disk_manager("test.db");
+    for (page_id_t page_id = 0; page_id < 40; ++page_id) {
+      EXPECT_EQ(page_id, disk_manager.AllocatePage(4, page_id % 4));
+    }
+
+    // Each shard reuses its own freed pages lowest first, and skipped ids go to the shard they belong to.
+    for (page_id_t page_id = 38; page_id > 0; --page_id) {
+      if (page_id % 4 == 1 || page_id % 4 == 2) {
+        disk_manager.DeallocatePage(page_id);
+      }
+    }
+    EXPECT_EQ(20, disk_manager.GetFreePageCount());
+    EXPECT_EQ(40, disk_manager.AllocatePage(4, 0));
+    EXPECT_EQ(43, disk_manager.AllocatePage(4, 3));
+    EXPECT_EQ(22, disk_manager.GetFreePageCount());
+    for (uint32_t shard = 1; shard < 3; ++shard) {
+      EXPECT_EQ(static_cast<page_id_t>(shard), disk_manager.AllocatePage(4, shard));
+      EXPECT_EQ(static_cast<page_id_t>(shard + 4), disk_manager.AllocatePage(4, shard));
+    }
+    EXPECT_EQ(9, disk_manager.AllocatePage());
+    EXPECT_EQ(17, disk_manager.GetFreePageCount());
+  }
+
+  // The free pages survive a reopen whatever the stride they were freed with.
+  {
+    DiskManager disk_manager("test.db");
+    EXPECT_EQ(44, disk_manager.GetNextPageId());
+    EXPECT_EQ(17, disk_manager.GetFreePageCount());
+    EXPECT_EQ(10, disk_manager.AllocatePage(4, 2));
+    EXPECT_EQ(47, disk_manager.AllocatePage(4, 3));
+    EXPECT_EQ(13, disk_manager.AllocatePage());
+    EXPECT_EQ(18, disk_manager.GetFreePageCount());
+  }
+  remove("test.db");
+}
+
+}  // namespace miniKV
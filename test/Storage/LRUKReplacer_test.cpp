@@ -0,0 +1,171 @@
+#include "Storage/BufferPool/LRUKReplacer.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Storage/BufferPool/BufferPoolManager.h"
+#include "gtest/gtest.h"
+
+namespace miniKV {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2, 0);
+
+  // Scenario: access and unpin six frames, frame 1 is accessed twice.
+  for (frame_id_t frame = 1; frame <= 6; ++frame) {
+    lru_replacer.RecordAccess(frame);
+    lru_replacer.Unpin(frame);
+  }
+  lru_replacer.RecordAccess(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: frames with a single reference have an infinite backward 2-distance
+  // and go first, in order of their first reference.
+  int value;
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+
+  // Scenario: pinned frames are not victims, until they are unpinned.
+  lru_replacer.Pin(4);
+  EXPECT_EQ(3, lru_replacer.Size());
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  lru_replacer.Unpin(4);
+
+  // Scenario: frame 6 has fewer references than frame 1, frame 4 is older than frame 6.
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(0, lru_replacer.Size());
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const frame_id_t num_frames = 10;
+  LRUKReplacer lru_replacer(num_frames, 2, 0);
+
+  // Frames 0 and 1 hold pages that every lookup touches.
+  for (int round = 0; round < 3; ++round) {
+    lru_replacer.RecordAccess(0);
+    lru_replacer.RecordAccess(1);
+  }
+  lru_replacer.Unpin(0);
+  lru_replacer.Unpin(1);
+
+  // A scan touches every other frame once, after the hot frames.
+  for (frame_id_t frame = 2; frame < num_frames; ++frame) {
+    lru_replacer.RecordAccess(frame);
+    lru_replacer.Unpin(frame);
+  }
+
+  for (frame_id_t frame = 2; frame < num_frames; ++frame) {
+    int value;
+    ASSERT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(frame, value);
+  }
+  EXPECT_EQ(2, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_replacer(4, 2, 2);
+
+  // Two references of frame 0 in a row count as one, so frame 1 ranks better.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(0);
+  for (frame_id_t frame = 0; frame < 4; ++frame) {
+    lru_replacer.Unpin(frame);
+  }
+
+  // Frames 2 and 3 have one reference each and go first.
+  int value;
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+
+  // Frame 0 also has a single reference and ranks before frame 1, but it is still within
+  // its correlated reference period and is passed over while frame 1 can be evicted.
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(0, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, CorrelatedHotFrameTest) {
+  LRUKReplacer lru_replacer(14, 2, 4);
+
+  // Frame 0 is referenced every 2 or 3 accesses, so every reference after its first is correlated,
+  // while frames 1 to 8 are touched once in between, then frames 9 to 13 after it.
+  for (frame_id_t frame : {0, 1, 0, 2, 3, 0, 4, 0, 5, 6, 0, 7, 0, 8, 0}) {
+    lru_replacer.RecordAccess(frame);
+  }
+  for (frame_id_t frame = 9; frame < 14; ++frame) {
+    lru_replacer.RecordAccess(frame);
+  }
+  for (frame_id_t frame = 0; frame < 14; ++frame) {
+    lru_replacer.Unpin(frame);
+  }
+
+  // Frame 0 has a single reference, but at the end of its correlated period, after frames 1 to 8.
+  int value;
+  for (frame_id_t frame = 1; frame <= 8; ++frame) {
+    ASSERT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(frame, value);
+  }
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_EQ(5, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, BufferPoolManagerTest) {
+  const size_t buffer_pool_size = 10;
+
+  auto disk_manager = std::make_shared<DiskManager>("test.db");
+  auto bpm = std::make_shared<BufferPoolManager>(buffer_pool_size, disk_manager, ReplacerType::LRUK);
+
+  // The hot page is flushed, then changed in memory only, so a reload from disk would show.
+  auto hot_page = bpm->NewPage();
+  ASSERT_NE(nullptr, hot_page);
+  page_id_t hot_page_id = hot_page->GetPageId();
+  snprintf(hot_page->GetData(), PAGE_SIZE, "on disk");
+  EXPECT_TRUE(bpm->UnpinPage(hot_page_id, true));
+  EXPECT_TRUE(bpm->FlushPage(hot_page_id));
+  snprintf(hot_page->GetData(), PAGE_SIZE, "in memory");
+
+  // The hot page is fetched between other pages, then a scan touches three times the pool size.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(hot_page_id));
+    EXPECT_TRUE(bpm->UnpinPage(hot_page_id, false));
+    for (int j = 0; j < LRUK_CRP; ++j) {
+      auto page = bpm->NewPage();
+      ASSERT_NE(nullptr, page);
+      EXPECT_TRUE(bpm->UnpinPage(page->GetPageId(), false));
+    }
+  }
+  for (size_t i = 0; i < buffer_pool_size * 3; ++i) {
+    auto page = bpm->NewPage();
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(bpm->UnpinPage(page->GetPageId(), false));
+  }
+
+  auto page = bpm->FetchPage(hot_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "in memory"));
+  EXPECT_TRUE(bpm->UnpinPage(hot_page_id, false));
+
+  remove("test.db");
+}
+
+}  // namespace miniKV
@@ -0,0 +1,51 @@
+#include "Util/KeySearch.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Storage/Page/BPlusTreeInternalPage.h"
+#include "gtest/gtest.h"
+
+namespace miniKV {
+
+TEST(KeySearchTest, CountNotGreaterTest) {
+  std::mt19937_64 rng(0);
+  // Sizes around the SIMD window and its vector widths, keys with gaps so missing keys are searched too.
+  for (size_t count : {0, 1, 2, 3, 4, 5, 15, 16, 17, 18, 31, 33, 100, 1000, 13000}) {
+    std::vector<int64_t> sorted;
+    for (size_t i = 0; i < count; ++i) {
+      sorted.push_back(static_cast<int64_t>(i * 4) - 100);
+    }
+    std::vector<int64_t> keys{INT64_MIN, INT64_MAX, -101, -100, -99};
+    for (int i = 0; i < 200; ++i) {
+      keys.push_back(static_cast<int64_t>(rng() % (count * 4 + 8)) - 104);
+    }
+    for (auto key : keys) {
+      auto expected = static_cast<size_t>(std::upper_bound(sorted.begin(), sorted.end(), key) - sorted.begin());
+      EXPECT_EQ(expected, CountNotGreater(sorted.data(), count, key)) << KeySearchKernel();
+      EXPECT_EQ(expected, CountNotGreaterScalar(sorted.data(), count, key));
+    }
+  }
+}
+
+TEST(KeySearchTest, InternalPageLookupTest) {
+  using InternalPage = BPlusTreeInternalPage<key_t, value_t>;
+  for (int size : {1, 2, 3, 17, 500}) {
+    std::unique_ptr<char[]> data(new char[INTERNAL_PAGE_HEADER_SIZE + (sizeof(key_t) + sizeof(value_t)) * (size + 1)]);
+    auto *page = reinterpret_cast<InternalPage *>(data.get());
+    page->Init(1, INVALID_PAGE_ID, size);
+    // Child i holds the keys in [10 * i, 10 * i + 10), the first key is invalid.
+    for (int i = 0; i < size; ++i) {
+      page->AppendChild(10 * i, 100 + i);
+    }
+    for (key_t key = -5; key < 10 * size + 5; ++key) {
+      int expected = std::min(std::max<int>(0, static_cast<int>(key / 10)), size - 1);
+      EXPECT_EQ(expected, page->LookupIndex(key));
+      EXPECT_EQ(100 + expected, page->Lookup(key));
+    }
+  }
+}
+
+}  // namespace miniKV